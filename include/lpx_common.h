@@ -56,10 +56,11 @@ inline void log(LogLevel level, const std::string& message) {
 #define LOG_DEBUG(msg) lpx::log(lpx::LOG_DEBUG, msg)
 
 // Constants
-const float TWO_PI = 2.0f * M_PI;
-const float ONE_THIRD = 1.0f / 3.0f;
-const float sv_A = M_PI * std::sqrt(3.0f);  // Spiral construction constant for hexagonal cells
-const float r0 = 0.455f;  // Radius in pixels to the center of the LPXImage cell at absolute angle zero
+constexpr float TWO_PI = 2.0f * M_PI;
+constexpr float ONE_THIRD = 1.0f / 3.0f;
+constexpr float SQRT_3 = 1.7320508f;  // std::sqrt(3.0f), as a constant expression
+constexpr float sv_A = M_PI * SQRT_3;  // Spiral construction constant for hexagonal cells
+constexpr float r0 = 0.455f;  // Radius in pixels to the center of the LPXImage cell at absolute angle zero
 const float FLOAT_EPSILON = 0.001f;  // Epsilon for float comparisons
 
 // Float comparison function for near equality
@@ -67,14 +68,34 @@ inline bool floatEquals(float a, float b, float epsilon = FLOAT_EPSILON) {
     return std::abs(a - b) < epsilon;
 }
 
-// Calculate the index of the LPXImage cell that contains the point (x, y)
-inline int getXCellIndex(float x, float y, float spiralPer) {
+// The terms of getXCellIndex that depend only on the spiral period. The
+// period is wholePeriods + 0.5, as getXCellIndex rounds it.
+struct SpiralConstants {
+    float spiralPer;
+    int wholePer;
+    float pitch;
+    float pitchAng;
+    float invPitchAng;
+    float sv_A_pitch_1;
+    float width;  // Angular width of a half cell
+
+    constexpr explicit SpiralConstants(int wholePeriods)
+        : spiralPer(wholePeriods + 0.5f),
+          wholePer(wholePeriods),
+          pitch(1.0f / (wholePeriods + 0.5f)),
+          pitchAng(0.99999999f * TWO_PI * (1.0f / (wholePeriods + 0.5f))),  // Fixup for round off error
+          invPitchAng(1.0f / (0.99999999f * TWO_PI * (1.0f / (wholePeriods + 0.5f)))),
+          sv_A_pitch_1(sv_A * (1.0f / (wholePeriods + 0.5f)) + 1),
+          width(static_cast<float>(M_PI * (1.0f / (wholePeriods + 0.5f)))) {}
+};
+
+// Index of the LPXImage cell that contains the point (x, y), given the
+// spiral's constants and logGrowth = std::log(spiral.sv_A_pitch_1)
+inline int getXCellIndex(float x, float y, const SpiralConstants& spiral, float logGrowth) {
     if (x == 0 && y == 0) {
         return 0;
     }
 
-    spiralPer = std::floor(spiralPer) + 0.5f;
-
     float radius = std::sqrt(x * x + y * y);
     
     // Bounds check: if radius is too large, return a safe default
@@ -85,29 +106,25 @@ inline int getXCellIndex(float x, float y, float spiralPer) {
     
     float angle = std::atan2(y, x);
 
-    float pitch = 1.0f / spiralPer;
-    float pitchAng = 0.99999999f * TWO_PI * pitch;  // Fixup for round off error
-    float invPitchAng = 1.0f / pitchAng;
-
     float ang = (angle < 0.0f) ? angle + TWO_PI : angle;  // Map angles to range 0 to TWO_PI
 
-    float arg = ang * invPitchAng;
+    float arg = ang * spiral.invPitchAng;
     float j = 2 * arg - 0.0000001f;  // Offset the angle enough that the low boundary is included in the cell
-    float sv_A_pitch_1 = sv_A * pitch + 1;
 
-    int iPer = static_cast<int>(((4.0f * M_PI * std::log(radius / r0) / std::log(sv_A_pitch_1) * invPitchAng) - j) * pitch * 0.5f);
+    int iPer = static_cast<int>(((4.0f * M_PI * std::log(radius / r0) / logGrowth * spiral.invPitchAng) - j) *
+                                spiral.pitch * 0.5f);
 
-    int iPer_2_spiralPer = static_cast<int>(iPer * 2 * spiralPer);
+    int iPer_2_spiralPer = static_cast<int>(iPer * 2 * spiral.spiralPer);
 
     int iCell_2 = iPer_2_spiralPer + static_cast<int>(j);  // Half-period index
 
-    float absAng = 0.5f * (iPer_2_spiralPer + j) * pitchAng;
+    float absAng = 0.5f * (iPer_2_spiralPer + j) * spiral.pitchAng;
 
-    float ang1 = 0.5f * iCell_2 * pitchAng;  // Absolute ang1 on half-cell boundaries
+    float ang1 = 0.5f * iCell_2 * spiral.pitchAng;  // Absolute ang1 on half-cell boundaries
 
-    float r1 = r0 * std::pow(sv_A_pitch_1, (absAng / TWO_PI));  // Radius through center of cell at ang
+    float r1 = r0 * std::pow(spiral.sv_A_pitch_1, (absAng / TWO_PI));  // Radius through center of cell at ang
 
-    float r2 = r1 * sv_A_pitch_1;  // Radius through center of cells at next spiral period
+    float r2 = r1 * spiral.sv_A_pitch_1;  // Radius through center of cells at next spiral period
     float s_2 = (r2 - r1) * ONE_THIRD;
 
     int iCell = static_cast<int>(iCell_2 / 2);  // Index of bounding cell
@@ -120,27 +137,26 @@ inline int getXCellIndex(float x, float y, float spiralPer) {
     }
     
     if (dr >= s_2 && dr < 2.0f * s_2) {
-        float width = M_PI * pitch;
-        float bound = width * (dr - s_2) / s_2;
+        float bound = spiral.width * (dr - s_2) / s_2;
 
         if (iCell_2 % 2 > 0) {  // If in the upper half-cell
-            if (da >= width - bound) {  // If Region 4
-                iCell = iCell + static_cast<int>(spiralPer) + 1;
+            if (da >= spiral.width - bound) {  // If Region 4
+                iCell = iCell + spiral.wholePer + 1;
                 return iCell;
             } else {  // Else if Region 3
                 return iCell;
             }
         } else {  // Else in the lower half-cell
             if (da < bound) {  // If Region 5
-                iCell = iCell + static_cast<int>(spiralPer);
+                iCell = iCell + spiral.wholePer;
             }
             return iCell;  // Else if Region 2
         }
     } else {  // if (dr >= 2.0 * s_2)
         if (iCell_2 % 2 > 0) {  // If Region 4
-            iCell = iCell + static_cast<int>(spiralPer) + 1;
+            iCell = iCell + spiral.wholePer + 1;
         } else {  // Else if Region 5
-            iCell = iCell + static_cast<int>(spiralPer);
+            iCell = iCell + spiral.wholePer;
         }
         
         // Final bounds check: ensure result is reasonable
@@ -152,6 +168,56 @@ inline int getXCellIndex(float x, float y, float spiralPer) {
     }
 }
 
+// Calculate the index of the LPXImage cell that contains the point (x, y)
+inline int getXCellIndex(float x, float y, float spiralPer) {
+    if (x == 0 && y == 0) {
+        return 0;
+    }
+    const SpiralConstants spiral(static_cast<int>(std::floor(spiralPer)));
+    return getXCellIndex(x, y, spiral, std::log(spiral.sv_A_pitch_1));
+}
+
+// Constants of a spiral period fixed at compile time. The log of the growth
+// is taken once, when the program starts, so a lookup reads it without the
+// guard of a function-local static.
+template <int WholePeriods>
+struct FixedSpiral {
+    static constexpr SpiralConstants spiral{WholePeriods};
+    static const float logGrowth;
+};
+
+template <int WholePeriods>
+constexpr SpiralConstants FixedSpiral<WholePeriods>::spiral;
+
+template <int WholePeriods>
+const float FixedSpiral<WholePeriods>::logGrowth = std::log(FixedSpiral<WholePeriods>::spiral.sv_A_pitch_1);
+
+// getXCellIndex for a spiral period fixed at compile time: the constants
+// are folded into the code
+template <int WholePeriods>
+inline int getXCellIndex(float x, float y) {
+    return getXCellIndex(x, y, FixedSpiral<WholePeriods>::spiral, FixedSpiral<WholePeriods>::logGrowth);
+}
+
+typedef int (*XCellIndexFunction)(float x, float y);
+
+// getXCellIndex<P> for the common spiral periods, or nullptr for others
+inline XCellIndexFunction getFixedXCellIndex(float spiralPer) {
+    switch (static_cast<int>(std::floor(spiralPer))) {
+        case 15: return &getXCellIndex<15>;
+        case 31: return &getXCellIndex<31>;
+        case 63: return &getXCellIndex<63>;
+        case 127: return &getXCellIndex<127>;
+        default: return nullptr;
+    }
+}
+
+// getXCellIndex(xs[i], ys[i], spiralPer) of n points into out[i]. With the
+// AVX2 or NEON span kernel selected, the points are taken a vector at a time
+// and the few near a cell boundary are left to getXCellIndex, so the cells
+// are exactly those it gives.
+void getXCellIndices(const float* xs, const float* ys, int n, float spiralPer, int* out);
+
 inline float getSpiralRadius(int length, float spiralPer) {
     // Validate spiralPer
     if (spiralPer < 0.1f) {
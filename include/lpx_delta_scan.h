@@ -0,0 +1,97 @@
+/**
+ * lpx_delta_scan.h
+ *
+ * Change-driven scanning of video from a fixed camera, where most of each
+ * frame is the same as the one before
+ */
+
+#ifndef LPX_DELTA_SCAN_H
+#define LPX_DELTA_SCAN_H
+
+#include "lpx_image.h"
+#include "lpx_optimized.h"
+#include <climits>
+#include <memory>
+#include <vector>
+
+namespace lpx {
+
+// Keeps the cell sums of the last frame scanned and a copy of that frame.
+// Each new frame is compared with the copy tile by tile; the pixels of tiles
+// that differ are subtracted from their cells' sums and the new pixels added,
+// and only the cells touched are averaged again. Unchanged tiles are compared
+// but not summed, so apart from that comparison the cost of a frame follows
+// the area that changed. The result is identical to a full scan.
+//
+// The first frame, and any frame whose size, format, fixation or cell range
+// differs from the last, is scanned in full. 8-bit packed formats only: their
+// integer sums cancel exactly. One scanner follows one stream and is not
+// shared between threads.
+class LPXDeltaScanner {
+public:
+    static const int DEFAULT_TILE_SIZE = 16;
+
+    // Scanner using the global plan cache for these tables
+    explicit LPXDeltaScanner(std::shared_ptr<LPXTables> tables, int tileSize = DEFAULT_TILE_SIZE);
+    // Scanner using a scan context's plan cache, such as an engine's
+    explicit LPXDeltaScanner(const optimized::ScanContext& context, int tileSize = DEFAULT_TILE_SIZE);
+
+    // Scan image into lpxImage, which must use the scanner's tables. Any
+    // LPXImage may be passed each frame: the cells are kept by the scanner.
+    bool scan(LPXImage* lpxImage, const cv::Mat& image, float x_center, float y_center,
+              PixelFormat format = PIXEL_FORMAT_AUTO, int firstCell = 0, int lastCell = INT_MAX);
+
+    // Forget the last frame, so the next scan is a full one
+    void reset();
+
+    std::shared_ptr<LPXTables> getScanTables() const { return context.spans ? context.spans->sct : nullptr; }
+    int getTileSize() const { return tileSize; }
+
+    // Tiles of the rows the last scan read, and how many of them changed
+    // (all of them for a full scan)
+    int getTileCount() const { return tileCount; }
+    int getChangedTileCount() const { return changedTiles; }
+    bool wasFullScan() const { return fullScan; }
+
+private:
+    void scanFull(const optimized::FrameLayout& frame, bool rainbowMode);
+    void scanChanges(const optimized::FrameLayout& frame, bool rainbowMode);
+    void indexFoveaTiles();
+    void markDirty(int cell);
+
+    optimized::ScanContext context;
+    int tileSize;
+
+    std::shared_ptr<const optimized::ScanPlan> plan;  // Plan of the last frame; null = none
+    bool precise = false;
+    bool rainbowMode = false;  // LPX_RAINBOW_MODE when the cells were merged
+    std::vector<uint32_t> cells;
+    std::vector<float> preciseCells;
+    optimized::AccumulatorBuffer buffer;
+
+    // Copy of the rows [firstRow, endRow) the plan reads, rows tightly packed
+    std::vector<uchar> previous;
+    size_t previousStep = 0;
+    int firstRow = 0;
+    int endRow = 0;
+    int tilesPerRow = 0;
+
+    // Fovea pixels grouped by tile (the last table entry of each cell only)
+    std::vector<optimized::PlanFoveaPixel> foveaByTile;
+    std::vector<int> foveaTileStart;
+
+    // Per-frame scratch
+    std::vector<char> tileChanged;                    // One tile row
+    std::vector<int> changedRuns;                     // [start, end) column pairs of one tile row
+    std::vector<optimized::PlanFoveaPixel> foveaChanged;
+    std::vector<char> cellDirty;
+    std::vector<int> dirtyCells;
+
+    int tileCount = 0;
+    int changedTiles = 0;
+    bool fullScan = false;
+};
+
+} // namespace lpx
+
+#endif // LPX_DELTA_SCAN_H
@@ -0,0 +1,90 @@
+/**
+ * lpx_engine.h
+ *
+ * Self-contained scan engine: tables, row index, plan cache and worker pool
+ * owned by one object, so independent streams can scan concurrently
+ */
+
+#ifndef LPX_ENGINE_H
+#define LPX_ENGINE_H
+
+#include "lpx_image.h"
+#include "lpx_optimized.h"
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace lpx {
+
+// Reentrant counterpart of the global scan functions in lpx_image.h.
+// The worker pool, plan cache and image pool are private to the engine, so
+// one engine per camera stream scans without contending for them. The span
+// table still comes from the process-wide cache of getSharedScanSpanTable,
+// read-only once built and shared by engines on the same tables. Calls on
+// the same engine are safe and take turns on its worker pool.
+class LPXScanEngine {
+public:
+    // numThreads = 0 uses the hardware concurrency; planCacheSize = 0 plans every scan afresh.
+    // Up to imagePoolSize returned images are recycled once released.
+    explicit LPXScanEngine(std::shared_ptr<LPXTables> tables, unsigned int numThreads = 0,
+                           bool pinThreads = false, size_t planCacheSize = 8, size_t imagePoolSize = 8);
+
+    // Load the scan tables from file; returns nullptr if they cannot be read
+    static std::shared_ptr<LPXScanEngine> create(const std::string& scanTableFile, unsigned int numThreads = 0,
+                                                 bool pinThreads = false, size_t planCacheSize = 8,
+                                                 size_t imagePoolSize = 8);
+
+    std::shared_ptr<LPXTables> getScanTables() const { return tables; }
+    optimized::ScanThreadPool& getThreadPool() { return *pool; }
+    optimized::ScanPlanCache& getPlanCache() { return *plans; }
+    LPXImagePool& getImagePool() { return images; }
+    // For an LPXScanSession that shares this engine's plans
+    const optimized::ScanContext& getScanContext() const { return context; }
+
+    // Scan into an LPXImage created with this engine's tables
+    bool scanFromImage(LPXImage* lpxImage, const cv::Mat& image, float x_center, float y_center,
+                       PixelFormat format = PIXEL_FORMAT_AUTO);
+
+    // As scanFromImage, also setting the image size to the frame's.
+    // Allocation free once the plan for this frame size and center is cached.
+    bool scanInto(LPXImage& lpxImage, const cv::Mat& image, float x_center, float y_center,
+                  PixelFormat format = PIXEL_FORMAT_AUTO);
+
+    // Same behaviour as multithreadedScanImage, multithreadedScanResizedImage,
+    // multithreadedScanCellRange, multithreadedScanImagePyramid, scanCells and scanMultiple
+    std::shared_ptr<LPXImage> scanImage(const cv::Mat& image, float x_center, float y_center,
+                                        PixelFormat format = PIXEL_FORMAT_AUTO);
+    std::shared_ptr<LPXImage> scanResizedImage(const cv::Mat& image, cv::Size scanSize,
+                                               float x_center, float y_center,
+                                               PixelFormat format = PIXEL_FORMAT_AUTO);
+    std::shared_ptr<LPXImage> scanCellRange(const cv::Mat& image, float x_center, float y_center,
+                                            int firstCell, int lastCell,
+                                            PixelFormat format = PIXEL_FORMAT_AUTO,
+                                            cv::Size scanSize = cv::Size());
+    std::shared_ptr<LPXImage> scanImagePyramid(const cv::Mat& image, float x_center, float y_center,
+                                               int pyramidLevels, PixelFormat format = PIXEL_FORMAT_AUTO);
+    std::shared_ptr<LPXImage> scanCells(const cv::Mat& image, float x_center, float y_center,
+                                        const std::vector<int>& cells, PixelFormat format = PIXEL_FORMAT_AUTO);
+    std::vector<std::shared_ptr<LPXImage>> scanMultiple(const cv::Mat& image, const std::vector<cv::Point2f>& centers,
+                                                        PixelFormat format = PIXEL_FORMAT_AUTO);
+
+    // Same behaviour as scanBatch: whole frames spread across this engine's threads
+    std::vector<std::shared_ptr<LPXImage>> scanBatch(const std::vector<cv::Mat>& frames,
+                                                     const std::vector<cv::Point2f>& centers,
+                                                     PixelFormat format = PIXEL_FORMAT_AUTO);
+
+private:
+    std::shared_ptr<LPXTables> tables;
+    std::unique_ptr<optimized::ScanThreadPool> pool;
+    std::unique_ptr<optimized::ScanPlanCache> plans;
+    optimized::ScanContext context;
+    LPXImagePool images;
+
+    std::mutex pyramidMutex;           // Guards the pyramid level buffers
+    std::vector<cv::Mat> pyramid;      // Reused while the frame size is unchanged
+};
+
+} // namespace lpx
+
+#endif // LPX_ENGINE_H
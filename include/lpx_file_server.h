@@ -56,6 +56,7 @@ private:
     
     // Components 
     std::shared_ptr<LPXTables> scanTables;
+    std::shared_ptr<LPXScanEngine> scanEngine;  // Own pool and plans, independent of other servers
     cv::VideoCapture videoCapture;
     
     // Video file info
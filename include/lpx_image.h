@@ -12,6 +12,7 @@
 #include <cstdint>
 #include <vector>
 #include <memory>
+#include <mutex>
 #include <string>
 #include <opencv2/opencv.hpp>
 #include "lpx_common.h"  // Include common definitions
@@ -37,14 +38,112 @@ struct Rect {
     int yMax;  // High y boundary
 };
 
+// Pixel layouts the scanners read directly. Channel order and YUV colour
+// conversion are applied per cell to the averaged values, so frames never
+// need a converted full-size copy before scanning.
+enum PixelFormat {
+    PIXEL_FORMAT_AUTO = 0,  // BGR for 3 channels, BGRA for 4, grayscale for 1
+    PIXEL_FORMAT_BGR,
+    PIXEL_FORMAT_RGB,
+    PIXEL_FORMAT_BGRA,
+    PIXEL_FORMAT_GRAY,
+    PIXEL_FORMAT_NV12,      // 1-channel Mat, height * 3/2 rows: Y plane then interleaved UV
+    PIXEL_FORMAT_I420,      // 1-channel Mat, height * 3/2 rows: Y plane then U and V planes
+    PIXEL_FORMAT_YUYV       // 2-channel Mat: Y0 U Y1 V for each pair of pixels
+};
+
+// Lower-case format names ("bgr", "nv12", ...)
+const char* getPixelFormatName(PixelFormat format);
+bool parsePixelFormat(const std::string& name, PixelFormat& format);
+
+// Pixel dimensions of the frame held in image (planar YUV Mats carry extra
+// chroma rows); empty if the Mat does not hold a frame of that format
+cv::Size getFrameSize(const cv::Mat& image, PixelFormat format);
+
+// Array of scan-table data that either owns its elements or views read-only
+// memory kept alive by an owner, such as a mapped table file (see
+// lpx_table_file.h). Resizing makes the array own its elements again. The
+// accessors are read-only; only owned elements can be written, through
+// ownedData().
+template <typename T>
+class TableArray {
+public:
+    TableArray() {}
+    TableArray(const TableArray& other) { *this = other; }
+    TableArray& operator=(const TableArray& other) {
+        if (this != &other) {
+            storage = other.storage;
+            owner = other.owner;
+            items = owner ? other.items : storage.data();
+            count = other.count;
+        }
+        return *this;
+    }
+
+    size_t size() const { return count; }
+    bool empty() const { return count == 0; }
+    const T* data() const { return items; }
+    const T& operator[](size_t i) const { return items[i]; }
+    const T* begin() const { return items; }
+    const T* end() const { return items + count; }
+    const T& back() const { return items[count - 1]; }
+    // Owned elements, for filling the array after resize or assign; a view owns none
+    T* ownedData() { return storage.data(); }
+
+    void resize(size_t n) { storage.resize(n); own(); }
+    void assign(size_t n, const T& value) { storage.assign(n, value); own(); }
+
+    // View n elements at data, kept alive by owner
+    void view(const T* data, size_t n, std::shared_ptr<const void> viewOwner) {
+        storage.clear();
+        storage.shrink_to_fit();
+        owner = std::move(viewOwner);
+        items = data;
+        count = n;
+    }
+    bool isView() const { return owner != nullptr; }
+
+private:
+    void own() {
+        owner.reset();
+        items = storage.data();
+        count = storage.size();
+    }
+
+    std::vector<T> storage;
+    std::shared_ptr<const void> owner;
+    const T* items = nullptr;
+    size_t count = 0;
+};
+
+class LPXTableFile;
+
 // Scan Tables for mapping between standard and log-polar images
 class LPXTables {
 public:
     LPXTables(const std::string& filename);
     ~LPXTables();
 
-    // Load scan tables from file
+    // Load scan tables from file: the original binary format is read, a
+    // table file written by writeTableFile (lpx_table_file.h) is mapped.
+    // With LPX_SHARED_TABLES=1 the tables are loaded with loadShared,
+    // falling back to a private copy if shared memory is unavailable.
     bool load(const std::string& filename);
+
+    // Load scan tables from file into the shared-memory segment every
+    // process loading tables of the same map width and spiral period
+    // attaches (LPXTableFile::openShared); the first one publishes it
+    bool loadShared(const std::string& filename);
+
+    // Generate the tables of a spiral period (whole periods, as in scan
+    // table files) over a mapWidth-square map, rather than loading them.
+    // With period 63 and width 6000 they are the tables of ScanTables63.
+    // LPX_TABLE_CACHE names a directory in which generated tables are kept
+    // as table files and mapped by later calls with the same parameters.
+    bool generate(float spiralPer, int mapWidth);
+
+    // Write the tables in the original scan table format
+    bool save(const std::string& filename) const;
     
     // Check if tables are properly initialized
     bool isInitialized() const { return initialized; }
@@ -61,16 +160,46 @@ public:
     int lastCellIndex;       // Index of the last LPXImage cell
 
     // Mapping arrays
-    std::vector<int> outerPixelIndex;       // Pixel indexes at which the LPXImage cell index changed value
-    std::vector<int> outerPixelCellIdx;     // Cell indexes at the outerPixelIndex values
-    std::vector<PositionPair> innerCells;   // X,Y locations for pixels in the fovea region
+    TableArray<int> outerPixelIndex;        // Pixel indexes at which the LPXImage cell index changed value
+    TableArray<int> outerPixelCellIdx;      // Cell indexes at the outerPixelIndex values
+    TableArray<PositionPair> innerCells;    // X,Y locations for pixels in the fovea region
+
+    // Mapped table file the arrays view, or null if they were read
+    const std::shared_ptr<const LPXTableFile>& getTableFile() const { return tableFile; }
+
+    // True if the arrays view a shared-memory segment
+    bool isShared() const;
 
 private:
     bool initialized;
+    std::shared_ptr<const LPXTableFile> tableFile;
+    bool loadPrivate(const std::string& filename);
+    bool loadTableFile(const std::string& filename);
+    bool adoptTableFile(const std::shared_ptr<const LPXTableFile>& file);
     bool loadBinaryFormat(const std::string& filename);
     bool loadJsonFormat(const std::string& filename);
 };
 
+// Per-cell statistics a scan can gather in the same pass as the cell means.
+// Each array holds 3 floats per cell in B, G, R order, in the units of the
+// scanned frame. Fovea cells read a single pixel, so their variance is 0;
+// cells the scan did not reach are 0 throughout.
+struct LPXCellStatistics {
+    std::vector<float> variance;  // Population variance of each channel
+    std::vector<float> minimum;
+    std::vector<float> maximum;
+};
+
+// Opponent-colour planes a scan can emit alongside the packed cells, one
+// int16 per cell each, laid out for LPXVision to read directly. Each holds
+// what extractCellLuminance, extractCellGreenRed and extractCellYellowBlue
+// give for the packed cell.
+struct LPXOpponentCells {
+    std::vector<int16_t> luminance;   // 0 to 1023
+    std::vector<int16_t> greenRed;    // -1023 to 1023
+    std::vector<int16_t> yellowBlue;  // -1023 to 1023
+};
+
 // Log-Polar Image class
 class LPXImage {
 public:
@@ -79,7 +208,8 @@ public:
     ~LPXImage();
     
     // Convert from standard image to log-polar image
-    bool scanFromImage(const cv::Mat& image, float x_center, float y_center);
+    bool scanFromImage(const cv::Mat& image, float x_center, float y_center,
+                       PixelFormat format = PIXEL_FORMAT_AUTO);
     
     // Save log-polar image to file
     bool saveToFile(const std::string& filename) const;
@@ -104,6 +234,7 @@ public:
     
     void setLength(int len) { length = std::min(len, nMaxCells); }
     void setPosition(float x, float y) { x_ofs = x; y_ofs = y; }
+    void setSize(int imageWidth, int imageHeight) { width = imageWidth; height = imageHeight; }
     
     // Pack/unpack RGB values for cell encoding/decoding (already declared as private below)
     // Helper function to calculate scan bounding box (already declared as private below)
@@ -125,10 +256,43 @@ public:
     
     // Direct access to internal data - for multithreaded implementation only
     std::vector<uint32_t>& accessCellArray() { return cellArray; }
-    std::vector<int>& accessAccR() { return accR; }
-    std::vector<int>& accessAccG() { return accG; }
-    std::vector<int>& accessAccB() { return accB; }
-    std::vector<int>& accessCount() { return count; }
+    
+    // Optional high-precision output. While enabled, scans also store the
+    // mean B, G, R of every cell as floats (3 per cell) in the units of the
+    // scanned frame: 0-255 for 8-bit, 0-65535 for 16-bit, as-is for float.
+    // YUV frames give their converted 8-bit values.
+    void setPreciseOutput(bool enabled) {
+        preciseOutput = enabled;
+        if (!enabled) preciseCells.clear();
+    }
+    bool hasPreciseOutput() const { return preciseOutput; }
+    const std::vector<float>& getPreciseCellArray() const { return preciseCells; }
+    std::vector<float>& accessPreciseCellArray() { return preciseCells; }
+    
+    // Optional per-cell statistics. While enabled, scans of packed frames
+    // also fill the variance, minimum and maximum of every cell; YUV frames,
+    // multi-fixation and pyramid scans are rejected.
+    void setCellStatistics(bool enabled) {
+        cellStatistics = enabled;
+        if (!enabled) statistics = LPXCellStatistics();
+    }
+    bool hasCellStatistics() const { return cellStatistics; }
+    const LPXCellStatistics& getCellStatistics() const { return statistics; }
+    LPXCellStatistics& accessCellStatistics() { return statistics; }
+    
+    // Optional opponent-colour output. While enabled, every scan into this
+    // image also fills the luminance, green-red and yellow-blue planes from
+    // the packed cells it wrote.
+    void setOpponentOutput(bool enabled) {
+        opponentOutput = enabled;
+        if (!enabled) opponentCells = LPXOpponentCells();
+    }
+    bool hasOpponentOutput() const { return opponentOutput; }
+    const LPXOpponentCells& getOpponentCells() const { return opponentCells; }
+    
+    // Convert the packed cells into the opponent-colour planes (sized to the
+    // cell array); scans call this when opponent output is enabled
+    void updateOpponentCells();
     
     // Color extraction methods for LPXVision
     int extractCellLuminance(uint32_t cellValue) const;
@@ -147,13 +311,13 @@ private:
     float x_ofs;                // X-offset in source image for log-polar center
     float y_ofs;                // Y-offset in source image for log-polar center
     std::vector<uint32_t> cellArray;  // Array of cells for the LPXImage
+    bool preciseOutput = false;       // Scans fill preciseCells too
+    std::vector<float> preciseCells;  // B, G, R means per cell when preciseOutput is set
+    bool cellStatistics = false;      // Scans fill statistics too
+    LPXCellStatistics statistics;
+    bool opponentOutput = false;      // Scans fill opponentCells too
+    LPXOpponentCells opponentCells;
     std::shared_ptr<LPXTables> sct;   // Scan tables
-
-    // Accumulators for color processing
-    std::vector<int> accR;      // Red accumulator for each cell
-    std::vector<int> accG;      // Green accumulator for each cell
-    std::vector<int> accB;      // Blue accumulator for each cell
-    std::vector<int> count;     // Count of pixels in each cell
     
     // Helper function to calculate scan bounding box
     lpx::Rect getScannedBox(float x_center, float y_center, int width, int height, int length, float spiralPer);
@@ -165,6 +329,37 @@ private:
     void unpackColor(uint32_t packed, int& r, int& g, int& b) const;
 };
 
+// Shared between an LPXImagePool and the deleters of the images it hands out
+struct LPXImagePoolState;
+
+// Recycles LPXImages so that streaming scans stop allocating once warmed up.
+// acquire() hands out an image nobody else holds; the deleter of the returned
+// shared_ptr puts it back on the pool's free list when the last copy is
+// released. Up to capacity images are kept, beyond that acquire() returns
+// ordinary images. Images released after the pool is destroyed are deleted.
+class LPXImagePool {
+public:
+    explicit LPXImagePool(std::shared_ptr<LPXTables> tables, size_t capacity = 8);
+    ~LPXImagePool();
+    LPXImagePool(const LPXImagePool&) = delete;
+    LPXImagePool& operator=(const LPXImagePool&) = delete;
+
+    // Image with the pool's tables, sized imageWidth x imageHeight, with
+    // precise output, cell statistics and opponent output off; its cells hold whatever the
+    // previous user left and are rewritten by the next scan
+    std::shared_ptr<LPXImage> acquire(int imageWidth, int imageHeight);
+
+    std::shared_ptr<LPXTables> getScanTables() const { return tables; }
+    size_t capacity() const { return maxImages; }
+    size_t size() const;       // Images kept by the pool
+    size_t available() const;  // Kept images not held outside the pool
+
+private:
+    std::shared_ptr<LPXTables> tables;
+    size_t maxImages;
+    std::shared_ptr<LPXImagePoolState> state;
+};
+
 // Initialize the LPX system
 bool initLPX(const std::string& scanTableFile, int imageWidth, int imageHeight);
 
@@ -172,14 +367,71 @@ bool initLPX(const std::string& scanTableFile, int imageWidth, int imageHeight);
 void shutdownLPX();
 
 // Global scan function to create LPXImage from standard image
-std::shared_ptr<LPXImage> scanImage(const cv::Mat& image, float x_center, float y_center);
+std::shared_ptr<LPXImage> scanImage(const cv::Mat& image, float x_center, float y_center,
+                                    PixelFormat format = PIXEL_FORMAT_AUTO);
 
 // Global shared instance of scan tables
 extern std::shared_ptr<LPXTables> g_scanTables;
 
-// Multithreaded scan functions
-bool multithreadedScanFromImage(LPXImage* lpxImage, const cv::Mat& image, float x_center, float y_center);
-std::shared_ptr<LPXImage> multithreadedScanImage(const cv::Mat& image, float x_center, float y_center);
+// Scan into an existing LPXImage, reusing its storage, and set its size to
+// that of the frame. Uses the image's own tables; does not allocate once the
+// scan plan for this frame size and center is cached.
+bool scanInto(LPXImage& lpxImage, const cv::Mat& image, float x_center, float y_center,
+              PixelFormat format = PIXEL_FORMAT_AUTO);
+
+// Multithreaded scan functions. Images returned by these (and by scanImage)
+// come from a pool sized by LPX_IMAGE_POOL (default 8) and are recycled
+// once released.
+bool multithreadedScanFromImage(LPXImage* lpxImage, const cv::Mat& image, float x_center, float y_center,
+                                PixelFormat format = PIXEL_FORMAT_AUTO);
+std::shared_ptr<LPXImage> multithreadedScanImage(const cv::Mat& image, float x_center, float y_center,
+                                                 PixelFormat format = PIXEL_FORMAT_AUTO);
+
+// Scan image as if it had been resized to scanSize, without making the resized
+// copy: the resize is folded into the scan plan. Centers are in resized pixels.
+std::shared_ptr<LPXImage> multithreadedScanResizedImage(const cv::Mat& image, cv::Size scanSize,
+                                                        float x_center, float y_center,
+                                                        PixelFormat format = PIXEL_FORMAT_AUTO);
+
+// Scan only cells [firstCell, lastCell), e.g. a fovea-only or mid-ring pass.
+// Only the rows and spans under those cells are read, so the cost follows the
+// area of the range rather than the whole retina. Cells in the range match
+// multithreadedScanImage; the rest are zero. A non-empty scanSize scans as
+// multithreadedScanResizedImage does.
+std::shared_ptr<LPXImage> multithreadedScanCellRange(const cv::Mat& image, float x_center, float y_center,
+                                                     int firstCell, int lastCell,
+                                                     PixelFormat format = PIXEL_FORMAT_AUTO,
+                                                     cv::Size scanSize = cv::Size());
+
+// Scan only the listed cells, such as the few hundred an attention probe
+// samples. Each cell's pixels are found through an inverse cell-to-pixel
+// index, so the cost follows the area of those cells rather than the whole
+// retina. Listed cells match multithreadedScanImage; the rest are zero.
+// Returns nullptr if a cell is outside [0, getMaxCells()).
+std::shared_ptr<LPXImage> scanCells(const cv::Mat& image, float x_center, float y_center,
+                                    const std::vector<int>& cells, PixelFormat format = PIXEL_FORMAT_AUTO);
+
+// Scan with the outer rings read from up to pyramidLevels 2x downsampled
+// copies of image. Much less work on large frames; outer cell colours are
+// close to, but not exactly, those of multithreadedScanImage.
+std::shared_ptr<LPXImage> multithreadedScanImagePyramid(const cv::Mat& image, float x_center, float y_center,
+                                                        int pyramidLevels,
+                                                        PixelFormat format = PIXEL_FORMAT_AUTO);
+
+// Scan one image at several fixations, returning one LPXImage per center in
+// the same order. The image rows are read once for all centers, and each
+// result is identical to scanning that center on its own.
+std::vector<std::shared_ptr<LPXImage>> scanMultiple(const cv::Mat& image, const std::vector<cv::Point2f>& centers,
+                                                    PixelFormat format = PIXEL_FORMAT_AUTO);
+
+// Scan many frames, each at its own center (or all at centers[0] if only one
+// is given), spreading whole frames across the scan threads. For offline jobs
+// on small frames, where one frame is too little work to split. Results are
+// in input order and identical to multithreadedScanImage; frames that do not
+// match the format give nullptr. Empty if the arguments do not line up.
+std::vector<std::shared_ptr<LPXImage>> scanBatch(const std::vector<cv::Mat>& images,
+                                                 const std::vector<cv::Point2f>& centers,
+                                                 PixelFormat format = PIXEL_FORMAT_AUTO);
 
 } // namespace lpx
 
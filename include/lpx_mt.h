@@ -13,10 +13,13 @@
 namespace lpx {
 
 // Function to scan an image in a multithreaded fashion
-bool multithreadedScanFromImage(LPXImage* lpxImage, const cv::Mat& image, float x_center, float y_center);
+// (format defaults to PIXEL_FORMAT_AUTO, see lpx_image.h)
+bool multithreadedScanFromImage(LPXImage* lpxImage, const cv::Mat& image, float x_center, float y_center,
+                                PixelFormat format);
 
 // Helper function to create and scan an image in one go
-std::shared_ptr<LPXImage> multithreadedScanImage(const cv::Mat& image, float x_center, float y_center);
+std::shared_ptr<LPXImage> multithreadedScanImage(const cv::Mat& image, float x_center, float y_center,
+                                                 PixelFormat format);
 
 // Internal helper functions
 namespace internal {
@@ -10,33 +10,610 @@
 
 #include "lpx_image.h"
 #include <atomic>
+#include <algorithm>
+#include <climits>
+#include <condition_variable>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <thread>
 
 namespace lpx {
 namespace optimized {
 
-// Cache structure for fast pixel-to-cell lookup
-struct ScanCache {
-    std::vector<int> pixelToCellLUT;  // Direct lookup table: pixel index -> cell index
-    int mapSize;
+// Row index over the run-length scan tables.
+// The outerPixelIndex/outerPixelCellIdx arrays describe runs of map pixels that
+// share a cell. Instead of expanding them into one entry per map pixel, we keep
+// the index of the run covering the first pixel of every map row and walk the
+// runs of a row directly, emitting (startCol, endCol, cell) spans.
+// Tables mapped from a table file carry the index prebuilt; it is then viewed
+// in place rather than built.
+struct ScanSpanTable {
+    std::shared_ptr<LPXTables> sct;   // Tables the row index was built from
+    TableArray<int> rowFirstRun;      // Run covering the first pixel of each map row (mapWidth + 1 entries)
+    TableArray<int64_t> cellArea;     // Map pixels in each cell, used to pick pyramid levels
+    TableArray<int> cellReach;        // Furthest row or column from the map center over cells [0, i]
+    int mapWidth = 0;
     bool initialized = false;
-    
-    void initialize(const std::shared_ptr<LPXTables>& sct);
-    inline int getCellIndex(int pixelIdx) const;
+
+    void initialize(const std::shared_ptr<LPXTables>& tables);
+
+    // Call fn(startCol, endCol, cell) for every run of map row `row` that
+    // intersects the columns [colMin, colMax). Columns are map columns.
+    template <typename Fn>
+    inline void forEachSpan(int row, int colMin, int colMax, Fn&& fn) const;
+};
+
+template <typename Fn>
+inline void ScanSpanTable::forEachSpan(int row, int colMin, int colMax, Fn&& fn) const {
+    if (row < 0 || row >= mapWidth) return;
+    colMin = std::max(colMin, 0);
+    colMax = std::min(colMax, mapWidth);
+    if (colMin >= colMax) return;
+
+    const int* runStart = sct->outerPixelIndex.data();
+    const int* runCell = sct->outerPixelCellIdx.data();
+    const int length = sct->length;
+
+    const int rowBase = row * mapWidth;
+    const int lo = rowBase + colMin;
+    const int hi = rowBase + colMax;
+
+    // Binary search for the run covering `lo` among the runs of this row
+    const int* first = runStart + rowFirstRun[row];
+    const int* last = runStart + std::min(rowFirstRun[row + 1] + 1, length);
+    int i = static_cast<int>(std::upper_bound(first, last, lo) - runStart) - 1;
+    if (i < 0) i = 0;
+
+    for (; i < length && runStart[i] < hi; i++) {
+        const int next = (i + 1 < length) ? runStart[i + 1] : INT_MAX;
+        const int start = std::max(runStart[i], lo);
+        const int end = std::min(next, hi);
+
+        // Negative cells only mark the end-of-table sentinel
+        if (start < end && runCell[i] >= 0) {
+            fn(start - rowBase, end - rowBase, runCell[i]);
+        }
+    }
+}
+
+// Inverse of the scan tables: for every cell, the map pixels it covers.
+// Outer runs are split at map row ends into (row, col, count) spans, so a
+// scan of a few cells visits only their own pixels. Fovea cells list the
+// inner table entries that write them, last entry first, since the last one
+// inside the image is the pixel a full scan keeps. Like the row index, it is
+// viewed in place when the tables come from a table file.
+struct MapSpan {
+    int row;    // Map row
+    int col;    // First map column
+    int count;  // Number of map pixels
+};
+
+struct CellSpanIndex {
+    std::shared_ptr<LPXTables> sct;   // Tables the index was built from
+    TableArray<int> cellSpanStart;    // First span of each cell (cells + 1 entries)
+    TableArray<MapSpan> cellSpans;    // Spans grouped by cell, in map order within a cell
+    TableArray<int> cellInnerStart;   // First inner entry of each fovea cell (lastFoveaIndex + 2 entries)
+    TableArray<int> cellInner;        // Inner table entries grouped by fovea cell, descending
+    int spiralCells = 0;              // Spiral radius in pixels (rounded) of images
+    int spiralRadius = 0;             // of spiralCells cells, the tables' own count
+    bool initialized = false;
+
+    void initialize(const std::shared_ptr<LPXTables>& tables);
+
+    int cellCount() const { return static_cast<int>(cellSpanStart.size()) - 1; }
+};
+
+// Per-cell accumulator packed so a cell's sums and count share one cache line
+struct CellAccumulator {
+    int r;
+    int g;
+    int b;
+    int count;
+};
+
+// Accumulator for 16-bit and float frames. A double holds any 16-bit sum a
+// cell can reach exactly, and float frames keep their fractional values.
+struct WideCellAccumulator {
+    double r;
+    double g;
+    double b;
+    int64_t count;
+};
+
+// Per-cell statistics accumulated alongside the sums when an LPXImage asks for
+// them. Set from the first span of a cell rather than cleared, so statistics
+// buffers are never zeroed: a cell is new while its sum accumulator's count is 0.
+struct CellStatsAccumulator {
+    double squares[3];  // Sums of squares, B, G, R
+    float minimum[3];
+    float maximum[3];
+};
+
+// Cache-line aligned accumulator buffer owned by a single scan worker.
+// Each worker sums into its own buffer so no cache lines are shared between
+// cores while scanning; the buffers are reduced afterwards per cell range.
+template <typename Cell>
+class CellAccumulatorBuffer {
+public:
+    static const int CACHE_LINE_SIZE = 64;
+    static const int CELLS_PER_LINE = CACHE_LINE_SIZE / sizeof(Cell);
+
+    // Size the buffer for nCells cells, rounded up to whole cache lines
+    void resize(int nCells);
+
+    // Zero all cells, or cells [cellStart, cellEnd)
+    void clear();
+    void clear(int cellStart, int cellEnd);
+
+    Cell* data() { return cells; }
+    const Cell* data() const { return cells; }
+    int size() const { return nCells; }
+
+private:
+    std::vector<Cell> storage;  // Over-allocated to leave room for alignment
+    Cell* cells = nullptr;      // First cache-line aligned element of storage
+    int nCells = 0;
+};
+
+typedef CellAccumulatorBuffer<CellAccumulator> AccumulatorBuffer;          // 8-bit frames
+typedef CellAccumulatorBuffer<WideCellAccumulator> WideAccumulatorBuffer;  // 16-bit and float frames
+typedef CellAccumulatorBuffer<CellStatsAccumulator> StatsAccumulatorBuffer; // Cell statistics
+
+// Where the planes of a frame live in its cv::Mat. Packed formats only use
+// `pixels`; NV12 keeps interleaved UV in `chromaU`, I420 has separate planes.
+struct FrameLayout {
+    PixelFormat format = PIXEL_FORMAT_BGR;  // Never PIXEL_FORMAT_AUTO
+    int width = 0;                  // Frame size in pixels
+    int height = 0;
+    int scanWidth = 0;              // Size of the image the scan sees; differs from
+    int scanHeight = 0;             // width/height when a resize is fused into the scan
+    int depth = CV_8U;              // CV_8U, or CV_16U / CV_32F for packed formats
+    int pixelSize = 0;              // Bytes per pixel in the main plane
+    size_t step = 0;                // Bytes per row of the main plane
+    const uchar* pixels = nullptr;  // Packed pixels, or the Y plane
+    const uchar* chromaU = nullptr;
+    const uchar* chromaV = nullptr;
+    size_t chromaStep = 0;          // Bytes per row of the chroma plane(s)
+
+    bool isYUV() const {
+        return format == PIXEL_FORMAT_NV12 || format == PIXEL_FORMAT_I420 || format == PIXEL_FORMAT_YUYV;
+    }
+};
+
+// Describe image as a frame in format (AUTO picks from the channel count);
+// returns false if the Mat cannot hold a frame of that format. Packed formats
+// may be 8-bit, 16-bit or float; YUV formats are 8-bit only.
+bool describeFrame(const cv::Mat& image, PixelFormat format, FrameLayout& frame);
+
+// Describe a packed width x height frame of OpenCV type `type` whose pixels
+// are not in memory yet, such as one arriving row by row. Rows are taken to
+// be width * pixelSize bytes apart and `pixels` is null.
+bool describePackedFrame(int width, int height, int type, PixelFormat format, FrameLayout& frame);
+
+// Convert an averaged BT.601 video-range YUV colour to a packed BGR cell value
+uint32_t packYUVAsBGR(float y, float u, float v);
+
+// Run of pixels in one image row belonging to a single peripheral cell
+struct PlanSpan {
+    int col;    // First image column
+    int count;  // Number of pixels
+    int cell;   // Peripheral cell index
+};
+
+// Image pixel sampled directly into a fovea cell
+struct PlanFoveaPixel {
+    int offset;        // Byte offset of the pixel (or its Y sample) in the main plane
+    int chromaOffset;  // Byte offset of its U sample: in the chroma plane(s) for
+                       // NV12/I420, in the main plane for YUYV; 0 otherwise
+    int cell;
+};
+
+// Everything a scan plan depends on. The peripheral spans only depend on the
+// integer scan center, but fovea pixels are located by truncating the float
+// center plus the table offsets, so the exact center is part of the key.
+struct ScanPlanKey {
+    const LPXTables* tables = nullptr;
+    PixelFormat format = PIXEL_FORMAT_BGR;
+    int cols = 0;
+    int rows = 0;
+    int scanCols = 0;    // Scanned as if resized to scanCols x scanRows
+    int scanRows = 0;
+    size_t step = 0;     // Bytes per image row
+    int pixelSize = 0;   // Bytes per pixel
+    int nMaxCells = 0;
+    float centerX = 0.0f;
+    float centerY = 0.0f;
+    int pyramidLevels = 0;  // Outer cells read from this many downsampled levels
+    int firstCell = 0;      // Only cells [firstCell, lastCell) are scanned
+    int lastCell = 0;
+
+    bool operator==(const ScanPlanKey& other) const;
+};
+
+// Peripheral spans read from one downsampled pyramid level. Rows and
+// columns are level pixels; each covers a 2^level square of the frame.
+struct ScanPlanLevel {
+    int yMin = 0;                       // Level rows [yMin, yMax) hold spans
+    int yMax = 0;
+    std::vector<int> rowSpanStart;      // First span of each row (yMax - yMin + 1 entries)
+    std::vector<PlanSpan> spans;
+};
+
+// Precomputed scan of one image size at one fixation. The map offsets,
+// bounds checks and table lookups are resolved once, leaving the per-frame
+// scan a pure gather-and-sum over these arrays. A fused resize is folded in
+// as well: spans and fovea pixels address the source frame directly.
+struct ScanPlan {
+    ScanPlanKey key;
+    std::shared_ptr<LPXTables> sct;     // Keeps the tables (and key.tables) alive
+    int yMin = 0;                       // Image rows [yMin, yMax) hold peripheral spans
+    int yMax = 0;
+    std::vector<int> rowSpanStart;      // First span of each row (yMax - yMin + 1 entries)
+    std::vector<PlanSpan> spans;        // Peripheral spans in row order
+    std::vector<PlanFoveaPixel> fovea;  // In-image fovea pixels in table order (off-image ones dropped)
+    int cellStart = 0;                  // Cells [cellStart, cellEnd) are scanned (key.firstCell/lastCell)
+    int cellEnd = 0;
+    int foveaCells = 0;                 // Scanned cells below foveaCells are fovea cells
+    bool foveaCovered = false;          // Every scanned fovea cell receives at least one pixel
+    std::vector<ScanPlanLevel> coarseLevels;  // Pyramid levels 1..key.pyramidLevels; their
+                                              // cells are left out of `spans`
+};
+
+// The cell range is clamped to [0, nMaxCells); the defaults cover every cell
+ScanPlanKey makeScanPlanKey(const LPXTables* tables, int nMaxCells, const FrameLayout& frame,
+                            float x_center, float y_center, int pyramidLevels = 0,
+                            int firstCell = 0, int lastCell = INT_MAX);
+
+// Pyramid level an outer cell is read from: the coarsest of the first
+// maxLevel levels that still puts PYRAMID_SAMPLES_PER_CELL level pixels in it
+const int PYRAMID_SAMPLES_PER_CELL = 16;
+int getPyramidLevel(int64_t cellArea, int maxLevel);
+
+// Build the plan for scanning frames laid out like `frame` at (x_center, y_center).
+// With pyramidLevels > 0, cells large enough are moved to the coarse levels.
+// A cell range limits the plan to those cells and to the rows out to the
+// radius of lastCell, so its cost follows the area the range covers.
+std::shared_ptr<const ScanPlan> buildScanPlan(const ScanSpanTable& spans, int nMaxCells,
+                                              const FrameLayout& frame,
+                                              float x_center, float y_center,
+                                              int pyramidLevels = 0,
+                                              int firstCell = 0, int lastCell = INT_MAX);
+
+// Build into `plan` the scan of only `cells` (each in [0, nMaxCells), no
+// duplicates) for frames laid out like `frame` at (x_center, y_center).
+// Spans come from the inverse index rather than the map rows, so the cost
+// follows the area of those cells. Fovea cells get the one pixel a full scan
+// would leave in them. No fused resize; plan.key describes the whole scan.
+void buildCellScanPlan(const ScanSpanTable& spans, const CellSpanIndex& index, int nMaxCells,
+                       const FrameLayout& frame, float x_center, float y_center,
+                       const int* cells, int nCells, ScanPlan& plan);
+
+// Small LRU of scan plans for recently used fixations. The scan center
+// usually stays put for many frames, so the plan is built once and reused
+// until the center or image size changes.
+class ScanPlanCache {
+public:
+    explicit ScanPlanCache(size_t capacity);
+
+    // Plan for this scan, built on a miss (evicting the least recently used plan)
+    std::shared_ptr<const ScanPlan> get(const ScanSpanTable& spans, int nMaxCells,
+                                        const FrameLayout& frame,
+                                        float x_center, float y_center,
+                                        int pyramidLevels = 0,
+                                        int firstCell = 0, int lastCell = INT_MAX);
+
+    // Number of plans kept (0 = rebuild the plan for every scan)
+    void setCapacity(size_t capacity);
+    size_t capacity() const;
+    void clear();
+
+private:
+    mutable std::mutex mutex;
+    std::list<std::shared_ptr<const ScanPlan>> plans;  // Most recently used first
+    size_t maxPlans;
+};
+
+// Cache used by optimizedMultithreadedScan. Its capacity defaults to the
+// LPX_SCAN_PLAN_CACHE environment variable, or 8 plans.
+ScanPlanCache& getScanPlanCache();
+
+// Long-lived worker pool owned by the scan subsystem.
+// Scans are dispatched to warm threads instead of launching new ones per
+// frame, and the per-worker accumulator buffers are kept between scans so
+// the hot path does not allocate. The calling thread takes part as worker 0.
+// A scan holds acquire() across its parallelFor calls so the scratch buffers
+// stay private to it until the results are merged.
+class ScanThreadPool {
+public:
+    ScanThreadPool();  // Sized from LPX_SCAN_THREADS and LPX_PIN_SCAN_THREADS
+    ScanThreadPool(unsigned int numThreads, bool pinThreads);
+    ~ScanThreadPool();
+
+    // Set the total number of threads (0 = hardware concurrency) and whether
+    // each background worker is pinned to its own core (Linux only)
+    void configure(unsigned int numThreads, bool pinThreads);
+
+    unsigned int size() const { return numThreads; }
+    bool isPinned() const { return pinThreads; }
+
+    // Exclusive use of the pool and its scratch; blocks while another scan holds it
+    std::unique_lock<std::mutex> acquire() { return std::unique_lock<std::mutex>(ownerMutex); }
+
+    // Run fn(task, worker) for every task in [0, numTasks); returns when all are done
+    template <typename Fn>
+    void parallelFor(int numTasks, Fn& fn) { run(numTasks, &invokeTask<Fn>, &fn); }
+
+    // Per-worker scratch, one accumulator buffer per thread
+    std::vector<AccumulatorBuffer>& accumulators() { return scratch; }
+
+    // Scratch for multi-fixation scans, one buffer per (fixation, band); sized by the scan
+    std::vector<AccumulatorBuffer>& fixationAccumulators() { return fixationScratch; }
+
+    // Per-worker scratch for 16-bit and float frames
+    std::vector<WideAccumulatorBuffer>& wideAccumulators() { return wideScratch; }
+
+    // Per-worker scratch for cell statistics
+    std::vector<StatsAccumulatorBuffer>& statsAccumulators() { return statsScratch; }
+
+    // Plan and cell list of the current cell scan, rebuilt by every scan
+    ScanPlan& cellPlan() { return cellPlanScratch; }
+    std::vector<int>& cellList() { return cellListScratch; }
+
+private:
+    typedef void (*TaskFn)(void* context, int task, int worker);
+
+    template <typename Fn>
+    static void invokeTask(void* context, int task, int worker) {
+        (*static_cast<Fn*>(context))(task, worker);
+    }
+
+    void run(int numTasks, TaskFn fn, void* context);
+    void runTasks(int worker);
+    void workerLoop(int worker, unsigned long seenGeneration);
+    void startWorkers();
+    void stopWorkers();
+
+    unsigned int numThreads = 1;
+    bool pinThreads = false;
+    std::vector<std::thread> workers;
+    std::vector<AccumulatorBuffer> scratch;
+    std::vector<AccumulatorBuffer> fixationScratch;
+    std::vector<WideAccumulatorBuffer> wideScratch;
+    std::vector<StatsAccumulatorBuffer> statsScratch;
+    ScanPlan cellPlanScratch;
+    std::vector<int> cellListScratch;
+
+    std::mutex ownerMutex;                // Held by the scan using the pool
+    std::mutex dispatchMutex;             // Serializes jobs and reconfiguration
+    std::mutex stateMutex;
+    std::condition_variable wakeCondition;
+    std::condition_variable doneCondition;
+    TaskFn jobFn = nullptr;
+    void* jobContext = nullptr;
+    int jobTasks = 0;
+    std::atomic<int> nextTask;
+    int workersRunning = 0;               // Background workers still inside the current job
+    unsigned long generation = 0;         // Incremented for each job
+    bool stopping = false;
+};
+
+// Pool used by optimizedMultithreadedScan. Created on first use; its size and
+// pinning default to the LPX_SCAN_THREADS and LPX_PIN_SCAN_THREADS environment
+// variables.
+ScanThreadPool& getScanThreadPool();
+
+// Number of threads used by optimizedMultithreadedScan (0 = hardware concurrency)
+void setScanThreadCount(unsigned int numThreads);
+unsigned int getScanThreadCount();
+
+// What a scan needs besides the frame: the row index built from one set of
+// tables, a plan cache and a worker pool. Scans through contexts that share
+// no pool run concurrently; scans sharing a pool take turns.
+struct ScanContext {
+    std::shared_ptr<const ScanSpanTable> spans;
+    ScanPlanCache* plans = nullptr;
+    ScanThreadPool* pool = nullptr;
+};
+
+// Row index for tables, built once and shared while the tables are in use
+// (the most recently used few are kept)
+std::shared_ptr<const ScanSpanTable> getSharedScanSpanTable(const std::shared_ptr<LPXTables>& tables);
+
+// Inverse index for tables, built on first use and shared the same way
+std::shared_ptr<const CellSpanIndex> getSharedCellSpanIndex(const std::shared_ptr<LPXTables>& tables);
+
+// Context used by the scan functions that take none: the shared row index of
+// tables with getScanPlanCache() and getScanThreadPool()
+ScanContext getDefaultScanContext(const std::shared_ptr<LPXTables>& tables);
+
+// Span summation kernels. Each adds up a run of pixels belonging to one cell;
+// all kernels produce identical sums and only differ in instruction set.
+// The same holds for the row downsampling used to build scan pyramids.
+enum ScanKernel {
+    SCAN_KERNEL_AUTO = 0,    // Best kernel supported by the CPU
+    SCAN_KERNEL_SCALAR = 1,  // Portable fallback
+    SCAN_KERNEL_SSE41 = 2,   // x86-64 SSE4.1
+    SCAN_KERNEL_AVX2 = 3,    // x86-64 AVX2
+    SCAN_KERNEL_NEON = 4     // AArch64 NEON
 };
 
+typedef void (*SumSpanBGRFn)(const uchar* pixels, int n, int& sumB, int& sumG, int& sumR);
+typedef int (*SumSpanGrayFn)(const uchar* pixels, int n);
+// Average 2x2 blocks of row0 and row1 (rounded) into `width` pixels of out
+typedef void (*DownsampleRowFn)(const uchar* row0, const uchar* row1, uchar* out, int width);
+
+struct ScanKernelFunctions {
+    ScanKernel kernel;
+    SumSpanBGRFn sumBGR;    // Interleaved 3-channel pixels
+    SumSpanBGRFn sumBGRA;   // Interleaved 4-channel pixels (alpha ignored)
+    SumSpanGrayFn sumGray;  // Single-channel pixels
+    DownsampleRowFn downsampleBGR;   // Pyramid levels of 3-channel frames
+    DownsampleRowFn downsampleBGRA;  // 4-channel frames (alpha averaged too)
+    DownsampleRowFn downsampleGray;  // Single-channel frames
+};
+
+// Kernels currently used by the scan (selected at runtime; the LPX_SCAN_KERNEL
+// environment variable overrides CPU detection)
+const ScanKernelFunctions& getScanKernelFunctions();
+
+// Select a kernel; returns false if the CPU or build does not support it
+bool setScanKernel(ScanKernel kernel);
+ScanKernel getScanKernel();
+bool isScanKernelSupported(ScanKernel kernel);
+const char* getScanKernelName(ScanKernel kernel);
+bool parseScanKernel(const std::string& name, ScanKernel& kernel);
+
 // High-performance optimized scanning function
-bool optimizedMultithreadedScan(LPXImage* lpxImage, const cv::Mat& image, float x_center, float y_center);
-
-// Optimized region processing with minimal overhead
-void optimizedProcessImageRegion(const cv::Mat& image, int yStart, int yEnd,
-                               float centerX, float centerY,
-                               const ScanCache& cache,
-                               int scanMapCenterX, int scanMapCenterY,
-                               int w_m, int lastFoveaIndex,
-                               std::vector<std::atomic<int>>& atomicAccR,
-                               std::vector<std::atomic<int>>& atomicAccG,
-                               std::vector<std::atomic<int>>& atomicAccB,
-                               std::vector<std::atomic<int>>& atomicCount);
+// A non-empty scanSize scans the image as if it were first resized to that
+// size (centers are then in resized pixels) without making the resized copy.
+// Only cells [firstCell, lastCell) are scanned, reading just the rows and
+// spans those cells cover; the other cells are set to zero.
+// lpxImage must use the tables of the context.
+bool optimizedMultithreadedScan(const ScanContext& context, LPXImage* lpxImage, const cv::Mat& image,
+                                float x_center, float y_center,
+                                PixelFormat format = PIXEL_FORMAT_AUTO, cv::Size scanSize = cv::Size(),
+                                int firstCell = 0, int lastCell = INT_MAX);
+bool optimizedMultithreadedScan(LPXImage* lpxImage, const cv::Mat& image, float x_center, float y_center,
+                                PixelFormat format = PIXEL_FORMAT_AUTO, cv::Size scanSize = cv::Size(),
+                                int firstCell = 0, int lastCell = INT_MAX);
+
+// Scan one frame at several fixations, filling lpxImages[i] for centers[i].
+// Image rows are traversed once: colour and grayscale rows are reduced to
+// prefix sums that every fixation's spans then read in constant time, and
+// YUV rows are summed for all fixations while the row is in cache.
+// All images must share the same scan tables.
+bool optimizedMultithreadedScanMultiple(const ScanContext& context, const std::vector<LPXImage*>& lpxImages,
+                                        const cv::Mat& image, const std::vector<cv::Point2f>& centers,
+                                        PixelFormat format = PIXEL_FORMAT_AUTO);
+bool optimizedMultithreadedScanMultiple(const std::vector<LPXImage*>& lpxImages, const cv::Mat& image,
+                                        const std::vector<cv::Point2f>& centers,
+                                        PixelFormat format = PIXEL_FORMAT_AUTO);
+
+// Scan a batch of frames, one whole frame per worker with its own scratch,
+// filling lpxImages[i] from images[i] at centers[i] (or at centers[0] for
+// every frame if only one center is given). Each result is identical to
+// optimizedMultithreadedScan of that frame. Frames that cannot be scanned
+// are marked 0 in frameScanned (if given); returns true if all were scanned.
+bool optimizedScanBatch(const ScanContext& context, const std::vector<LPXImage*>& lpxImages,
+                        const std::vector<cv::Mat>& images, const std::vector<cv::Point2f>& centers,
+                        PixelFormat format = PIXEL_FORMAT_AUTO, std::vector<char>* frameScanned = nullptr);
+bool optimizedScanBatch(const std::vector<LPXImage*>& lpxImages, const std::vector<cv::Mat>& images,
+                        const std::vector<cv::Point2f>& centers, PixelFormat format = PIXEL_FORMAT_AUTO,
+                        std::vector<char>* frameScanned = nullptr);
+
+// Scan only the listed cells, reading just their pixels through the inverse
+// index (see CellSpanIndex). Listed cells match optimizedMultithreadedScan;
+// the rest are zero. Cells must be in [0, lpxImage->getMaxCells()); repeats
+// are ignored. Runs on the calling thread: a few hundred cells are too
+// little work to split. Not for images gathering cell statistics.
+bool optimizedScanCells(const ScanContext& context, LPXImage* lpxImage, const cv::Mat& image,
+                        float x_center, float y_center, const int* cells, int nCells,
+                        PixelFormat format = PIXEL_FORMAT_AUTO);
+bool optimizedScanCells(LPXImage* lpxImage, const cv::Mat& image, float x_center, float y_center,
+                        const int* cells, int nCells, PixelFormat format = PIXEL_FORMAT_AUTO);
+
+// Pyramid scans. Outer cells span thousands of pixels, so they are read from
+// 2x2 box-averaged copies of the frame instead: level L is
+// (width >> L) x (height >> L) and each cell uses the coarsest level that
+// still samples it densely (see getPyramidLevel). Inner rings and the fovea
+// are read from the frame itself. Packed formats only (BGR, RGB, BGRA, gray).
+
+// Fill pyramid[0] with image (no copy) and pyramid[1..numLevels] with the
+// downsampled levels, reusing the level buffers already in pyramid
+bool buildScanPyramid(ScanThreadPool& pool, const cv::Mat& image, int numLevels,
+                      std::vector<cv::Mat>& pyramid, PixelFormat format = PIXEL_FORMAT_AUTO);
+bool buildScanPyramid(const cv::Mat& image, int numLevels, std::vector<cv::Mat>& pyramid,
+                      PixelFormat format = PIXEL_FORMAT_AUTO);
+
+// Scan a pyramid built by buildScanPyramid (or one laid out the same way)
+bool optimizedPyramidScan(const ScanContext& context, LPXImage* lpxImage, const std::vector<cv::Mat>& pyramid,
+                          float x_center, float y_center, PixelFormat format = PIXEL_FORMAT_AUTO);
+bool optimizedPyramidScan(LPXImage* lpxImage, const std::vector<cv::Mat>& pyramid,
+                          float x_center, float y_center, PixelFormat format = PIXEL_FORMAT_AUTO);
+
+// Plan the scans of lpxImage's tables would use, for tools that inspect it
+std::shared_ptr<const ScanPlan> getScanPlan(const ScanContext& context, int nMaxCells, const FrameLayout& frame,
+                                            float x_center, float y_center, int pyramidLevels = 0);
+std::shared_ptr<const ScanPlan> getScanPlan(const LPXImage& lpxImage, const FrameLayout& frame,
+                                            float x_center, float y_center, int pyramidLevels = 0);
+
+// Copy the fovea pixels of the plan into their cells, packed as BGR. With
+// `precise`, also write each scanned fovea cell's B, G, R there (3 per cell)
+// in the frame's own units. 16-bit and float frames are packed as if
+// converted to 8-bit (v / 257 and v * 255, rounded).
+void gatherFoveaPixels(const FrameLayout& frame, const ScanPlan& plan, std::vector<uint32_t>& cellArray,
+                       float* precise = nullptr);
+
+// Same for n fovea pixels given explicitly, such as those in one band of
+// rows, with offsets from frame.pixels. Uncovered fovea cells are not cleared.
+void gatherFoveaPixels(const FrameLayout& frame, const PlanFoveaPixel* pixels, int n,
+                       std::vector<uint32_t>& cellArray, float* precise = nullptr);
+
+// Optimized region processing with minimal overhead.
+// Accumulates the peripheral spans of image rows [yStart, yEnd) of the plan into acc.
+// Colour formats sum B, G, R; YUV formats sum Y, U, V into the b, g, r fields.
+// The pixel format is resolved once per call, not per span.
+void optimizedProcessImageRegion(const FrameLayout& frame, int yStart, int yEnd,
+                               const ScanPlan& plan,
+                               AccumulatorBuffer& acc);
+
+// Same for 16-bit and float frames, summed by kernels specialised for the
+// pixel type and channel count
+void optimizedProcessImageRegion(const FrameLayout& frame, int yStart, int yEnd,
+                               const ScanPlan& plan,
+                               WideAccumulatorBuffer& acc);
+
+// Same for rows [yStart, yEnd) of a pyramid level, read from that level's frame
+void optimizedProcessImageRegion(const FrameLayout& frame, int yStart, int yEnd,
+                               const ScanPlanLevel& level,
+                               AccumulatorBuffer& acc);
+
+// Accumulate image rows [yStart, yEnd) of the plan from a band holding only
+// some of the frame's rows: image row r starts at
+// band.pixels + (r - bandFirstRow) * band.step. Packed formats only.
+void optimizedProcessImageBand(const FrameLayout& band, int bandFirstRow, int yStart, int yEnd,
+                               const ScanPlan& plan,
+                               AccumulatorBuffer& acc);
+void optimizedProcessImageBand(const FrameLayout& band, int bandFirstRow, int yStart, int yEnd,
+                               const ScanPlan& plan,
+                               WideAccumulatorBuffer& acc);
+
+// Same as the packed-format overloads above, also gathering the sums of
+// squares, minimum and maximum of every cell into stats in the same pass.
+// Kernels are specialised for the pixel type and channel count.
+void optimizedProcessImageRegion(const FrameLayout& frame, int yStart, int yEnd,
+                               const ScanPlan& plan,
+                               AccumulatorBuffer& acc, StatsAccumulatorBuffer& stats);
+void optimizedProcessImageRegion(const FrameLayout& frame, int yStart, int yEnd,
+                               const ScanPlan& plan,
+                               WideAccumulatorBuffer& acc, StatsAccumulatorBuffer& stats);
+
+// Statistics of the plan's fovea cells, which read one pixel each; fovea
+// cells with no pixel in the image get zeros when the plan says so
+void gatherFoveaStatistics(const FrameLayout& frame, const ScanPlan& plan, LPXCellStatistics& statistics);
+
+// LPX_RAINBOW_MODE=1 replaces cell colours with a test pattern in the merge
+bool isRainbowModeEnabled();
+
+// Reduce the worker buffers over cells [cellStart, cellEnd) and pack the
+// averaged colors into cellArray (converting YUV sums when yuvSums is set).
+// With `precise`, the unrounded means go there as well, 3 floats per cell.
+void mergeCellRange(const AccumulatorBuffer* buffers, int numBuffers,
+                    int cellStart, int cellEnd, int lastFoveaIndex, bool yuvSums, bool rainbowMode,
+                    std::vector<uint32_t>& cellArray, float* precise = nullptr);
+
+// Same for 16-bit and float frames of the given depth
+void mergeCellRange(const WideAccumulatorBuffer* buffers, int numBuffers,
+                    int cellStart, int cellEnd, int lastFoveaIndex, int depth, bool rainbowMode,
+                    std::vector<uint32_t>& cellArray, float* precise = nullptr);
+
+// Reduce the statistics of cells [cellStart, cellEnd) gathered alongside
+// buffers into variances, minima and maxima; empty peripheral cells get zeros
+void mergeCellStatistics(const AccumulatorBuffer* buffers, const StatsAccumulatorBuffer* stats, int numBuffers,
+                         int cellStart, int cellEnd, int lastFoveaIndex, LPXCellStatistics& statistics);
+void mergeCellStatistics(const WideAccumulatorBuffer* buffers, const StatsAccumulatorBuffer* stats, int numBuffers,
+                         int cellStart, int cellEnd, int lastFoveaIndex, LPXCellStatistics& statistics);
 
 } // namespace optimized
 } // namespace lpx
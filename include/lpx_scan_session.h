@@ -0,0 +1,91 @@
+/**
+ * lpx_scan_session.h
+ *
+ * Streaming scan of a frame that arrives a band of rows at a time, such as
+ * from a decoder or a rolling sensor readout
+ */
+
+#ifndef LPX_SCAN_SESSION_H
+#define LPX_SCAN_SESSION_H
+
+#include "lpx_image.h"
+#include "lpx_optimized.h"
+#include <climits>
+#include <memory>
+#include <vector>
+
+namespace lpx {
+
+// Each pushed band is summed into its cells straight away on the calling
+// thread, so scanning overlaps decoding. The image is finished by the push
+// that delivers the last row the fixation reads. Fixations near the top of
+// the frame are therefore done before the rest of the frame arrives. The
+// result is identical to scanning the complete frame.
+//
+// Packed formats only (8-bit, 16-bit or float). One session scans one frame
+// at a time and is not shared between threads; run one session per stream.
+class LPXScanSession {
+public:
+    // Session using the global plan cache for these tables
+    explicit LPXScanSession(std::shared_ptr<LPXTables> tables);
+    // Session using a scan context's plan cache, such as an engine's
+    explicit LPXScanSession(const optimized::ScanContext& context);
+
+    // Start scanning a width x height frame of OpenCV type `type` into
+    // lpxImage, which must use the session's tables and stay alive until the
+    // scan completes. Any scan in progress is abandoned.
+    bool begin(LPXImage* lpxImage, int width, int height, int type, float x_center, float y_center,
+               PixelFormat format = PIXEL_FORMAT_AUTO, int firstCell = 0, int lastCell = INT_MAX);
+
+    // Rows [firstRow, firstRow + nRows) of the frame, row r starting at
+    // rows + (r - firstRow) * stride (0 = tightly packed). Bands may arrive in
+    // any order; rows already received and rows the scan does not read are
+    // skipped. Returns false if no scan was begun or the band is outside the frame.
+    bool pushRows(const uint8_t* rows, int firstRow, int nRows, size_t stride = 0);
+
+    // Complete the image from the rows received so far; cells of missing
+    // rows only hold what arrived. Does nothing once the scan is complete.
+    bool finish();
+
+    bool isScanning() const { return state == SCANNING; }
+    bool isComplete() const { return state == COMPLETE; }
+
+    // Frame rows [getFirstRow(), getEndRow()) are read by the current scan
+    int getFirstRow() const { return scanFirstRow; }
+    int getEndRow() const { return scanEndRow; }
+    int getRowsPending() const { return rowsPending; }
+    const optimized::FrameLayout& getFrameLayout() const { return frame; }
+
+private:
+    enum State { IDLE, SCANNING, COMPLETE };
+
+    void indexFoveaRows();
+    void scanRows(const uint8_t* rows, int bandFirstRow, size_t stride, int runStart, int runEnd);
+    void complete();
+
+    optimized::ScanContext context;
+    State state = IDLE;
+
+    LPXImage* lpxImage = nullptr;
+    float* precise = nullptr;
+    optimized::FrameLayout frame;
+    std::shared_ptr<const optimized::ScanPlan> plan;
+    optimized::AccumulatorBuffer buffer;          // 8-bit frames
+    optimized::WideAccumulatorBuffer wideBuffer;  // 16-bit and float frames
+
+    int scanFirstRow = 0;
+    int scanEndRow = 0;
+    int rowsPending = 0;
+    std::vector<char> rowReceived;  // One entry per row in [scanFirstRow, scanEndRow)
+
+    // Fovea pixels of the plan sorted by row, with their offsets within the row,
+    // rebuilt when the plan changes
+    std::shared_ptr<const optimized::ScanPlan> foveaPlan;
+    std::vector<optimized::PlanFoveaPixel> foveaByRow;
+    std::vector<int> foveaRowStart;                    // First entry of each row from scanFirstRow
+    std::vector<optimized::PlanFoveaPixel> bandFovea;  // Fovea pixels of one band, offsets in the band
+};
+
+} // namespace lpx
+
+#endif // LPX_SCAN_SESSION_H
@@ -0,0 +1,134 @@
+/**
+ * lpx_table_file.h
+ *
+ * Versioned scan-table file that is mapped read-only rather than read
+ */
+
+#ifndef LPX_TABLE_FILE_H
+#define LPX_TABLE_FILE_H
+
+#include "lpx_image.h"
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace lpx {
+
+// The file holds the scan tables together with the structures the scans
+// derive from them: the row index (optimized::ScanSpanTable) and the
+// inverse cell index (optimized::CellSpanIndex). LPXTables::load maps it and
+// the arrays of the tables and of both indexes view the mapping, so loading
+// costs only the pages a scan touches and every process on a host shares the
+// same page-cache pages. Sections are little-endian, as in the original file.
+//
+// The same image can also live in a POSIX shared-memory segment named after
+// the tables' map width and spiral period (LPXTableFile::openShared), so
+// processes that load the original format share one copy as well.
+
+const uint32_t TABLE_FILE_MAGIC = 0x5458504C;  // "LPXT"
+const uint32_t TABLE_FILE_VERSION = 1;         // Bumped when the layout or a derived structure changes
+const uint32_t TABLE_FILE_ALIGNMENT = 64;      // Section offsets are multiples of this
+
+enum TableFileSection {
+    TABLE_SECTION_OUTER_PIXEL_INDEX = 0,  // int32[length]
+    TABLE_SECTION_OUTER_PIXEL_CELL,       // int32[length]
+    TABLE_SECTION_INNER_CELLS,            // PositionPair[innerLength]
+    TABLE_SECTION_ROW_FIRST_RUN,          // int32[mapWidth + 1]
+    TABLE_SECTION_CELL_AREA,              // int64[cells]
+    TABLE_SECTION_CELL_REACH,             // int32[cells]
+    TABLE_SECTION_CELL_SPAN_START,        // int32[cells + 1]
+    TABLE_SECTION_CELL_SPANS,             // optimized::MapSpan[]
+    TABLE_SECTION_CELL_INNER_START,       // int32[lastFoveaIndex + 2]
+    TABLE_SECTION_CELL_INNER,             // int32[]
+    TABLE_SECTION_COUNT
+};
+
+struct TableFileSectionInfo {
+    uint64_t offset;  // Bytes from the start of the file
+    uint64_t count;   // Elements
+};
+
+struct TableFileHeader {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t headerSize;       // sizeof(TableFileHeader)
+    uint32_t headerChecksum;   // FNV-1a of the header with this field zero
+    uint64_t fileSize;
+    uint64_t payloadChecksum;  // FNV-1a of every byte after the header
+    int32_t mapWidth;
+    float spiralPer;
+    int32_t length;
+    int32_t innerLength;
+    int32_t lastFoveaIndex;
+    int32_t lastCellIndex;
+    int32_t spiralCells;       // Spiral radius (rounded) of images of
+    int32_t spiralRadius;      // spiralCells cells
+    TableFileSectionInfo sections[TABLE_SECTION_COUNT];
+};
+
+class LPXTableFile {
+public:
+    // Map filename read-only. Returns nullptr (logging why) if it cannot be
+    // mapped or its header is not a valid table file of this version. With
+    // hugePages, the kernel is asked to back the mapping with huge pages
+    // where it supports that for files. The payload checksum is only checked
+    // with verifyPayload, since that reads every page.
+    static std::shared_ptr<const LPXTableFile> open(const std::string& filename, bool hugePages = false,
+                                                    bool verifyPayload = false);
+    // Attach the shared-memory segment name, publishing it first if it is
+    // missing or was left half-written: build fills in a table-file image
+    // (see buildTableFileImage) and runs in one process only, the others
+    // waiting for it. Every attached object holds a shared lock on the
+    // segment, which the kernel drops if its process dies, and the last one
+    // released unlinks the segment. Returns nullptr (logging why) if the
+    // segment cannot be created, attached or published.
+    static std::shared_ptr<const LPXTableFile> openShared(const std::string& name,
+                                                          const std::function<bool(std::vector<uint8_t>&)>& build,
+                                                          bool hugePages = false, bool verifyPayload = false);
+    ~LPXTableFile();
+
+    const TableFileHeader& header() const { return *static_cast<const TableFileHeader*>(base); }
+    size_t mappedSize() const { return size; }
+
+    // True if this maps a shared-memory segment rather than a file
+    bool isShared() const { return sharedFd >= 0; }
+
+    // First element of a section, and its element count
+    template <typename T>
+    const T* section(TableFileSection id) const {
+        return reinterpret_cast<const T*>(static_cast<const uint8_t*>(base) + header().sections[id].offset);
+    }
+    size_t sectionCount(TableFileSection id) const { return static_cast<size_t>(header().sections[id].count); }
+
+    // Checksum every byte after the header against the one it records
+    bool verifyPayload() const;
+
+private:
+    LPXTableFile() {}
+
+    const void* base = nullptr;
+    size_t size = 0;
+    int sharedFd = -1;       // Open (and locked) while the segment is attached
+    std::string sharedName;
+};
+
+// True if filename starts like a table file (of any version)
+bool isTableFile(const std::string& filename);
+
+// Write tables and their derived structures as a table file. The file is
+// written beside filename and renamed over it, so processes mapping the old
+// file keep a consistent copy.
+bool writeTableFile(const std::shared_ptr<LPXTables>& tables, const std::string& filename);
+
+// Table file contents for tables, as writeTableFile would write them
+bool buildTableFileImage(const std::shared_ptr<LPXTables>& tables, std::vector<uint8_t>& image);
+
+// Shared-memory segment name for tables of this map width and spiral
+// period, e.g. "/lpx-tables-6000-635" for ScanTables63
+std::string getSharedTableName(int mapWidth, float spiralPer);
+
+} // namespace lpx
+
+#endif // LPX_TABLE_FILE_H
@@ -2,6 +2,7 @@
 #pragma once
 
 #include "../include/lpx_mt.h"
+#include "../include/lpx_engine.h"
 #include "../include/lpx_renderer.h"
 #include "../include/lpx_version.h"
 #include <opencv2/opencv.hpp>
@@ -79,6 +80,7 @@ private:
     
     // Components 
     std::shared_ptr<LPXTables> scanTables;
+    std::shared_ptr<LPXScanEngine> scanEngine;  // Own pool and plans, independent of other servers
     
     // Frame and image queues
     std::mutex frameMutex;
@@ -11,6 +11,11 @@
 #include "../include/lpx_image.h"
 #include "../include/lpx_renderer.h"
 #include "../include/lpx_mt.h"
+#include "../include/lpx_optimized.h"
+#include "../include/lpx_engine.h"
+#include "../include/lpx_scan_session.h"
+#include "../include/lpx_delta_scan.h"
+#include "../include/lpx_table_file.h"
 #include "../include/lpx_webcam_server.h"
 #include "../include/lpx_file_server.h"  // Include file server header
 #include "../include/lpx_version.h"       // Include version header
@@ -18,6 +23,7 @@
 #include "../include/lpx_vision_core.h"   // Include LPXVision core header
 #include "../include/lpx_vision_utils.h"  // Include LPXVision utils header
 #include <opencv2/opencv.hpp>
+#include <cmath>
 #include <cstring>
 #include <iostream>
 
@@ -40,8 +46,42 @@ py::array_t<uint8_t> mat_to_numpy(const cv::Mat& image) {
     return result;
 }
 
-// Helper function to convert numpy array to OpenCV Mat
-cv::Mat numpy_to_mat(py::array_t<uint8_t, py::array::c_style>& array) {
+// Helper function to copy per-cell values (3 floats per cell) to a (cells, 3) array
+py::array_t<float> cells_to_numpy(const std::vector<float>& values) {
+    const int numCells = static_cast<int>(values.size() / 3);
+    py::array_t<float> result({numCells, 3});
+    std::memcpy(result.mutable_data(), values.data(), values.size() * sizeof(float));
+    return result;
+}
+
+// Opponent-colour planes as a (3, cells) int16 array: luminance, green-red, yellow-blue
+py::array_t<int16_t> opponent_to_numpy(const lpx::LPXOpponentCells& opponent) {
+    const int numCells = static_cast<int>(opponent.luminance.size());
+    py::array_t<int16_t> result({3, numCells});
+    int16_t* out = result.mutable_data();
+    std::memcpy(out, opponent.luminance.data(), numCells * sizeof(int16_t));
+    std::memcpy(out + numCells, opponent.greenRed.data(), numCells * sizeof(int16_t));
+    std::memcpy(out + 2 * numCells, opponent.yellowBlue.data(), numCells * sizeof(int16_t));
+    return result;
+}
+
+// Helper function to convert numpy array to OpenCV Mat.
+// Frames may be uint8, uint16 or float32; the Mat gets the matching depth.
+cv::Mat numpy_to_mat(const py::array& input) {
+    int depth;
+    py::array array;
+    if (py::isinstance<py::array_t<uint8_t>>(input)) {
+        depth = CV_8U;
+        array = py::array_t<uint8_t, py::array::c_style | py::array::forcecast>::ensure(input);
+    } else if (py::isinstance<py::array_t<uint16_t>>(input)) {
+        depth = CV_16U;
+        array = py::array_t<uint16_t, py::array::c_style | py::array::forcecast>::ensure(input);
+    } else if (py::isinstance<py::array_t<float>>(input)) {
+        depth = CV_32F;
+        array = py::array_t<float, py::array::c_style | py::array::forcecast>::ensure(input);
+    } else {
+        throw std::invalid_argument("Array must be uint8, uint16 or float32");
+    }
     py::buffer_info info = array.request();
     
     // Check dimensions
@@ -50,7 +90,7 @@ cv::Mat numpy_to_mat(py::array_t<uint8_t, py::array::c_style>& array) {
     
     // Create Mat from numpy array
     cv::Mat mat(
-        info.shape[0], info.shape[1], CV_8UC(info.shape[2]),
+        info.shape[0], info.shape[1], CV_MAKETYPE(depth, static_cast<int>(info.shape[2])),
         info.ptr, info.strides[0]
     );
     
@@ -65,7 +105,27 @@ PYBIND11_MODULE(lpximage, m) {
         .def(py::init<const std::string&>())
         .def("isInitialized", &lpx::LPXTables::isInitialized)
         .def_readonly("spiralPer", &lpx::LPXTables::spiralPer)
-        .def_readonly("length", &lpx::LPXTables::length);
+        .def_readonly("length", &lpx::LPXTables::length)
+        .def_readonly("lastFoveaIndex", &lpx::LPXTables::lastFoveaIndex)
+        .def_readonly("mapWidth", &lpx::LPXTables::mapWidth)
+        .def_readonly("innerLength", &lpx::LPXTables::innerLength)
+        .def_readonly("lastCellIndex", &lpx::LPXTables::lastCellIndex)
+        .def("isMapped", [](const lpx::LPXTables& self) { return self.getTableFile() != nullptr; },
+             "Whether the tables view a mapped table file")
+        .def("isShared", &lpx::LPXTables::isShared,
+             "Whether the tables view the shared-memory segment other processes attach")
+        .def("generate", [](lpx::LPXTables& self, float spiralPer, int mapWidth) {
+                py::gil_scoped_release release;
+                return self.generate(spiralPer, mapWidth);
+             }, py::arg("spiralPer"), py::arg("mapWidth"),
+             "Generate the tables of a spiral period over a mapWidth-square map instead of loading them")
+        .def("save", &lpx::LPXTables::save, py::arg("filename"),
+             "Write the tables in the original scan table format");
+
+    m.def("writeTableFile", &lpx::writeTableFile, py::arg("tables"), py::arg("filename"),
+          "Write the tables and their derived scan indexes as a memory-mappable table file");
+    m.def("isTableFile", &lpx::isTableFile, py::arg("filename"),
+          "Whether the file is a table file rather than the original scan table format");
 
     // Bind LPXImage class
     py::class_<lpx::LPXImage, std::shared_ptr<lpx::LPXImage>>(m, "LPXImage")
@@ -85,7 +145,41 @@ PYBIND11_MODULE(lpximage, m) {
             size_t data_size = self.getRawDataSize();
             return py::bytes(reinterpret_cast<const char*>(raw_ptr), data_size);
         }, "Get raw image data as bytes")
-        .def("getCellValue", &lpx::LPXImage::getCellValue, "Get the value of a specific cell");
+        .def("getCellValue", &lpx::LPXImage::getCellValue, "Get the value of a specific cell")
+        .def("setPreciseOutput", &lpx::LPXImage::setPreciseOutput,
+             "Also store unrounded B, G, R means per cell in later scans")
+        .def("hasPreciseOutput", &lpx::LPXImage::hasPreciseOutput)
+        .def("getPreciseCellValues", [](const lpx::LPXImage& self) {
+            return cells_to_numpy(self.getPreciseCellArray());
+        }, "Precise B, G, R means of every cell as a (cells, 3) float32 array; empty unless enabled")
+        .def("setCellStatistics", &lpx::LPXImage::setCellStatistics,
+             "Also gather the variance, minimum and maximum of every cell in later scans")
+        .def("hasCellStatistics", &lpx::LPXImage::hasCellStatistics)
+        .def("getCellVariances", [](const lpx::LPXImage& self) {
+            return cells_to_numpy(self.getCellStatistics().variance);
+        }, "B, G, R variance of every cell as a (cells, 3) float32 array; empty unless enabled")
+        .def("getCellMinima", [](const lpx::LPXImage& self) {
+            return cells_to_numpy(self.getCellStatistics().minimum);
+        }, "B, G, R minimum of every cell as a (cells, 3) float32 array; empty unless enabled")
+        .def("getCellMaxima", [](const lpx::LPXImage& self) {
+            return cells_to_numpy(self.getCellStatistics().maximum);
+        }, "B, G, R maximum of every cell as a (cells, 3) float32 array; empty unless enabled")
+        .def("setOpponentOutput", &lpx::LPXImage::setOpponentOutput,
+             "Also fill luminance, green-red and yellow-blue planes in later scans")
+        .def("hasOpponentOutput", &lpx::LPXImage::hasOpponentOutput)
+        .def("getOpponentCells", [](const lpx::LPXImage& self) {
+            return opponent_to_numpy(self.getOpponentCells());
+        }, "Luminance, green-red and yellow-blue of every cell as a (3, cells) int16 array; empty unless enabled")
+        .def("scanFromImage", [](lpx::LPXImage& self, const py::array& input,
+                                 float centerX, float centerY, const std::string& format) {
+            lpx::PixelFormat pixelFormat;
+            if (!lpx::parsePixelFormat(format, pixelFormat)) {
+                throw std::invalid_argument("Unknown pixel format: " + format);
+            }
+            cv::Mat inputMat = numpy_to_mat(input);
+            return self.scanFromImage(inputMat, centerX, centerY, pixelFormat);
+        }, py::arg("image"), py::arg("centerX"), py::arg("centerY"), py::arg("format") = "auto",
+        "Scan an image into this LPXImage");
 
     // Bind LPXRenderer class
     py::class_<lpx::LPXRenderer, std::shared_ptr<lpx::LPXRenderer>>(m, "LPXRenderer")
@@ -108,18 +202,491 @@ PYBIND11_MODULE(lpximage, m) {
         });
 
     // Bind multithreaded scanning function
-    m.def("scanImage", [](py::array_t<uint8_t, py::array::c_style>& input, float centerX, float centerY) {
+    m.def("scanImage", [](const py::array& input, float centerX, float centerY,
+                          const std::string& format, float scale, int pyramidLevels,
+                          int firstCell, int lastCell, bool precise, bool statistics, bool opponent) {
         // Ensure global scan tables are set before calling the scan function
         if (!lpx::g_scanTables || !lpx::g_scanTables->isInitialized()) {
             throw std::runtime_error("Global scan tables not initialized. Call initLPX() first.");
         }
 
+        lpx::PixelFormat pixelFormat;
+        if (!lpx::parsePixelFormat(format, pixelFormat)) {
+            throw std::invalid_argument("Unknown pixel format: " + format);
+        }
+
+        if (pyramidLevels < 0 || (pyramidLevels > 0 && scale != 1.0f)) {
+            throw std::invalid_argument("pyramidLevels must be >= 0 and cannot be combined with scale");
+        }
+
+        // lastCell = -1 scans out to the last cell
+        const bool cellRange = firstCell != 0 || lastCell >= 0;
+        if ((cellRange || precise || statistics || opponent) && pyramidLevels > 0) {
+            throw std::invalid_argument("A cell range, precise output, statistics or opponent output cannot be combined with pyramidLevels");
+        }
+        if (statistics && (pixelFormat == lpx::PIXEL_FORMAT_NV12 || pixelFormat == lpx::PIXEL_FORMAT_I420 ||
+                           pixelFormat == lpx::PIXEL_FORMAT_YUYV)) {
+            throw std::invalid_argument("Cell statistics need a packed pixel format");
+        }
+
         cv::Mat inputMat = numpy_to_mat(input);
-        auto result = lpx::multithreadedScanImage(inputMat, centerX, centerY);
+        cv::Size scanSize;
+        if (scale != 1.0f) {
+            // Fused resize: scan at native resolution as if resized by scale
+            const cv::Size frameSize = lpx::getFrameSize(inputMat, pixelFormat);
+            scanSize = cv::Size(static_cast<int>(std::lround(frameSize.width * scale)),
+                                static_cast<int>(std::lround(frameSize.height * scale)));
+        }
+
+        std::shared_ptr<lpx::LPXImage> result;
+        if (precise || statistics || opponent) {
+            // A fresh image, so the pooled ones never carry the extra output
+            const cv::Size frameSize = (scale != 1.0f) ? scanSize : lpx::getFrameSize(inputMat, pixelFormat);
+            result = std::make_shared<lpx::LPXImage>(lpx::g_scanTables, frameSize.width, frameSize.height);
+            result->setPreciseOutput(precise);
+            result->setCellStatistics(statistics);
+            result->setOpponentOutput(opponent);
+            if (!lpx::optimized::optimizedMultithreadedScan(result.get(), inputMat, centerX, centerY, pixelFormat,
+                                                            scanSize, firstCell, lastCell < 0 ? INT_MAX : lastCell)) {
+                result.reset();
+            }
+        } else if (cellRange) {
+            result = lpx::multithreadedScanCellRange(inputMat, centerX, centerY, firstCell,
+                                                     lastCell < 0 ? INT_MAX : lastCell, pixelFormat, scanSize);
+        } else if (pyramidLevels > 0) {
+            // Outer rings from downsampled copies of the frame
+            result = lpx::multithreadedScanImagePyramid(inputMat, centerX, centerY, pyramidLevels, pixelFormat);
+        } else if (scale == 1.0f) {
+            result = lpx::multithreadedScanImage(inputMat, centerX, centerY, pixelFormat);
+        } else {
+            result = lpx::multithreadedScanResizedImage(inputMat, scanSize, centerX, centerY, pixelFormat);
+        }
+        if (!result) {
+            throw std::runtime_error("Image shape does not match pixel format: " + format);
+        }
         return result;
-    }, py::arg("image"), py::arg("centerX"), py::arg("centerY"),
+    }, py::arg("image"), py::arg("centerX"), py::arg("centerY"), py::arg("format") = "auto", py::arg("scale") = 1.0f,
+    py::arg("pyramidLevels") = 0, py::arg("firstCell") = 0, py::arg("lastCell") = -1, py::arg("precise") = false,
+    py::arg("statistics") = false, py::arg("opponent") = false,
     "Scan an image and create an LPXImage using multithreaded processing");
 
+    m.def("scanCells", [](const py::array& input, float centerX, float centerY,
+                          const std::vector<int>& cells, const std::string& format) {
+        if (!lpx::g_scanTables || !lpx::g_scanTables->isInitialized()) {
+            throw std::runtime_error("Global scan tables not initialized. Call initLPX() first.");
+        }
+
+        lpx::PixelFormat pixelFormat;
+        if (!lpx::parsePixelFormat(format, pixelFormat)) {
+            throw std::invalid_argument("Unknown pixel format: " + format);
+        }
+        const int nMaxCells = lpx::g_scanTables->lastCellIndex + 1;
+        for (int cell : cells) {
+            if (cell < 0 || cell >= nMaxCells) {
+                throw std::invalid_argument("Cell " + std::to_string(cell) + " is outside [0, " +
+                                            std::to_string(nMaxCells) + ")");
+            }
+        }
+
+        cv::Mat inputMat = numpy_to_mat(input);
+        std::shared_ptr<lpx::LPXImage> result;
+        {
+            py::gil_scoped_release release;
+            result = lpx::scanCells(inputMat, centerX, centerY, cells, pixelFormat);
+        }
+        if (!result) {
+            throw std::runtime_error("Image shape does not match pixel format: " + format);
+        }
+        return result;
+    }, py::arg("image"), py::arg("centerX"), py::arg("centerY"), py::arg("cells"), py::arg("format") = "auto",
+    "Scan only the listed cells; the others are zero. Cost follows the area of those cells");
+
+    m.def("scanMultiple", [](py::array_t<uint8_t, py::array::c_style>& input,
+                             const std::vector<std::pair<float, float>>& centers,
+                             const std::string& format) {
+        if (!lpx::g_scanTables || !lpx::g_scanTables->isInitialized()) {
+            throw std::runtime_error("Global scan tables not initialized. Call initLPX() first.");
+        }
+
+        lpx::PixelFormat pixelFormat;
+        if (!lpx::parsePixelFormat(format, pixelFormat)) {
+            throw std::invalid_argument("Unknown pixel format: " + format);
+        }
+
+        std::vector<cv::Point2f> points;
+        points.reserve(centers.size());
+        for (const auto& center : centers) {
+            points.emplace_back(center.first, center.second);
+        }
+
+        cv::Mat inputMat = numpy_to_mat(input);
+        std::vector<std::shared_ptr<lpx::LPXImage>> results = lpx::scanMultiple(inputMat, points, pixelFormat);
+        if (results.size() != points.size()) {
+            throw std::runtime_error("Image shape does not match pixel format: " + format);
+        }
+        return results;
+    }, py::arg("image"), py::arg("centers"), py::arg("format") = "auto",
+    "Scan an image at several (centerX, centerY) fixations in one pass, returning one LPXImage per center");
+
+    m.def("scanBatch", [](std::vector<py::array>& inputs,
+                          const std::vector<std::pair<float, float>>& centers,
+                          const std::string& format) {
+        if (!lpx::g_scanTables || !lpx::g_scanTables->isInitialized()) {
+            throw std::runtime_error("Global scan tables not initialized. Call initLPX() first.");
+        }
+
+        lpx::PixelFormat pixelFormat;
+        if (!lpx::parsePixelFormat(format, pixelFormat)) {
+            throw std::invalid_argument("Unknown pixel format: " + format);
+        }
+        if (centers.empty() || (centers.size() != 1 && centers.size() != inputs.size())) {
+            throw std::invalid_argument("centers must hold one center per image, or a single center");
+        }
+
+        std::vector<cv::Point2f> points;
+        points.reserve(centers.size());
+        for (const auto& center : centers) {
+            points.emplace_back(center.first, center.second);
+        }
+        std::vector<cv::Mat> inputMats;
+        inputMats.reserve(inputs.size());
+        for (auto& input : inputs) {
+            inputMats.push_back(numpy_to_mat(input));
+        }
+
+        // Frames that do not match the format come back as None
+        py::gil_scoped_release release;
+        return lpx::scanBatch(inputMats, points, pixelFormat);
+    }, py::arg("images"), py::arg("centers"), py::arg("format") = "auto",
+    "Scan a list of images, each at its own (centerX, centerY) or all at a single one, one image per scan thread");
+
+    m.def("scanInto", [](lpx::LPXImage& lpxImage, const py::array& input,
+                         float centerX, float centerY, const std::string& format) {
+        lpx::PixelFormat pixelFormat;
+        if (!lpx::parsePixelFormat(format, pixelFormat)) {
+            throw std::invalid_argument("Unknown pixel format: " + format);
+        }
+        cv::Mat inputMat = numpy_to_mat(input);
+        return lpx::scanInto(lpxImage, inputMat, centerX, centerY, pixelFormat);
+    }, py::arg("lpxImage"), py::arg("image"), py::arg("centerX"), py::arg("centerY"), py::arg("format") = "auto",
+    "Scan into an existing LPXImage, reusing its storage");
+
+    // Bind the reentrant scan engine; scans release the GIL so engines in
+    // different Python threads run concurrently
+    py::class_<lpx::LPXScanEngine, std::shared_ptr<lpx::LPXScanEngine>>(m, "LPXScanEngine")
+        .def(py::init([](const std::string& scanTableFile, unsigned int numThreads, bool pinThreads,
+                         size_t planCacheSize, size_t imagePoolSize) {
+            auto engine = lpx::LPXScanEngine::create(scanTableFile, numThreads, pinThreads, planCacheSize,
+                                                     imagePoolSize);
+            if (!engine) {
+                throw std::runtime_error("Failed to initialize scan tables from: " + scanTableFile);
+            }
+            return engine;
+        }), py::arg("scanTableFile"), py::arg("numThreads") = 0, py::arg("pinThreads") = false,
+        py::arg("planCacheSize") = 8, py::arg("imagePoolSize") = 8)
+        .def(py::init<std::shared_ptr<lpx::LPXTables>, unsigned int, bool, size_t, size_t>(),
+             py::arg("tables"), py::arg("numThreads") = 0, py::arg("pinThreads") = false,
+             py::arg("planCacheSize") = 8, py::arg("imagePoolSize") = 8)
+        .def("getScanTables", &lpx::LPXScanEngine::getScanTables)
+        .def("getThreadCount", [](lpx::LPXScanEngine& self) { return self.getThreadPool().size(); })
+        .def("scanImage", [](lpx::LPXScanEngine& self, const py::array& input,
+                             float centerX, float centerY, const std::string& format, int pyramidLevels,
+                             int firstCell, int lastCell) {
+            lpx::PixelFormat pixelFormat;
+            if (!lpx::parsePixelFormat(format, pixelFormat)) {
+                throw std::invalid_argument("Unknown pixel format: " + format);
+            }
+            if (pyramidLevels < 0) {
+                throw std::invalid_argument("pyramidLevels must be >= 0");
+            }
+            const bool cellRange = firstCell != 0 || lastCell >= 0;
+            if (cellRange && pyramidLevels > 0) {
+                throw std::invalid_argument("A cell range cannot be combined with pyramidLevels");
+            }
+
+            cv::Mat inputMat = numpy_to_mat(input);
+            std::shared_ptr<lpx::LPXImage> result;
+            {
+                py::gil_scoped_release release;
+                if (cellRange) {
+                    result = self.scanCellRange(inputMat, centerX, centerY, firstCell,
+                                                lastCell < 0 ? INT_MAX : lastCell, pixelFormat);
+                } else if (pyramidLevels > 0) {
+                    result = self.scanImagePyramid(inputMat, centerX, centerY, pyramidLevels, pixelFormat);
+                } else {
+                    result = self.scanImage(inputMat, centerX, centerY, pixelFormat);
+                }
+            }
+            if (!result) {
+                throw std::runtime_error("Image shape does not match pixel format: " + format);
+            }
+            return result;
+        }, py::arg("image"), py::arg("centerX"), py::arg("centerY"), py::arg("format") = "auto",
+        py::arg("pyramidLevels") = 0, py::arg("firstCell") = 0, py::arg("lastCell") = -1,
+        "Scan an image with this engine's tables, plans and threads")
+        .def("scanInto", [](lpx::LPXScanEngine& self, lpx::LPXImage& lpxImage,
+                            const py::array& input,
+                            float centerX, float centerY, const std::string& format) {
+            lpx::PixelFormat pixelFormat;
+            if (!lpx::parsePixelFormat(format, pixelFormat)) {
+                throw std::invalid_argument("Unknown pixel format: " + format);
+            }
+            cv::Mat inputMat = numpy_to_mat(input);
+            py::gil_scoped_release release;
+            return self.scanInto(lpxImage, inputMat, centerX, centerY, pixelFormat);
+        }, py::arg("lpxImage"), py::arg("image"), py::arg("centerX"), py::arg("centerY"),
+        py::arg("format") = "auto",
+        "Scan into an existing LPXImage made with this engine's tables, reusing its storage")
+        .def("scanCells", [](lpx::LPXScanEngine& self, const py::array& input,
+                             float centerX, float centerY, const std::vector<int>& cells,
+                             const std::string& format) {
+            lpx::PixelFormat pixelFormat;
+            if (!lpx::parsePixelFormat(format, pixelFormat)) {
+                throw std::invalid_argument("Unknown pixel format: " + format);
+            }
+            const int nMaxCells = self.getScanTables()->lastCellIndex + 1;
+            for (int cell : cells) {
+                if (cell < 0 || cell >= nMaxCells) {
+                    throw std::invalid_argument("Cell " + std::to_string(cell) + " is outside [0, " +
+                                                std::to_string(nMaxCells) + ")");
+                }
+            }
+
+            cv::Mat inputMat = numpy_to_mat(input);
+            std::shared_ptr<lpx::LPXImage> result;
+            {
+                py::gil_scoped_release release;
+                result = self.scanCells(inputMat, centerX, centerY, cells, pixelFormat);
+            }
+            if (!result) {
+                throw std::runtime_error("Image shape does not match pixel format: " + format);
+            }
+            return result;
+        }, py::arg("image"), py::arg("centerX"), py::arg("centerY"), py::arg("cells"), py::arg("format") = "auto",
+        "Scan only the listed cells with this engine's tables; the others are zero")
+        .def("scanMultiple", [](lpx::LPXScanEngine& self, py::array_t<uint8_t, py::array::c_style>& input,
+                                const std::vector<std::pair<float, float>>& centers,
+                                const std::string& format) {
+            lpx::PixelFormat pixelFormat;
+            if (!lpx::parsePixelFormat(format, pixelFormat)) {
+                throw std::invalid_argument("Unknown pixel format: " + format);
+            }
+
+            std::vector<cv::Point2f> points;
+            points.reserve(centers.size());
+            for (const auto& center : centers) {
+                points.emplace_back(center.first, center.second);
+            }
+
+            cv::Mat inputMat = numpy_to_mat(input);
+            std::vector<std::shared_ptr<lpx::LPXImage>> results;
+            {
+                py::gil_scoped_release release;
+                results = self.scanMultiple(inputMat, points, pixelFormat);
+            }
+            if (results.size() != points.size()) {
+                throw std::runtime_error("Image shape does not match pixel format: " + format);
+            }
+            return results;
+        }, py::arg("image"), py::arg("centers"), py::arg("format") = "auto",
+        "Scan an image at several (centerX, centerY) fixations in one pass")
+        .def("scanBatch", [](lpx::LPXScanEngine& self, std::vector<py::array>& inputs,
+                             const std::vector<std::pair<float, float>>& centers,
+                             const std::string& format) {
+            lpx::PixelFormat pixelFormat;
+            if (!lpx::parsePixelFormat(format, pixelFormat)) {
+                throw std::invalid_argument("Unknown pixel format: " + format);
+            }
+            if (centers.empty() || (centers.size() != 1 && centers.size() != inputs.size())) {
+                throw std::invalid_argument("centers must hold one center per image, or a single center");
+            }
+
+            std::vector<cv::Point2f> points;
+            points.reserve(centers.size());
+            for (const auto& center : centers) {
+                points.emplace_back(center.first, center.second);
+            }
+            std::vector<cv::Mat> inputMats;
+            inputMats.reserve(inputs.size());
+            for (auto& input : inputs) {
+                inputMats.push_back(numpy_to_mat(input));
+            }
+
+            py::gil_scoped_release release;
+            return self.scanBatch(inputMats, points, pixelFormat);
+        }, py::arg("images"), py::arg("centers"), py::arg("format") = "auto",
+        "Scan a list of images, one image per engine thread");
+
+    // Bind the streaming scan session
+    py::class_<lpx::LPXScanSession, std::shared_ptr<lpx::LPXScanSession>>(m, "LPXScanSession")
+        .def(py::init([](std::shared_ptr<lpx::LPXTables> tables) {
+            if (!tables) {
+                tables = lpx::g_scanTables;
+            }
+            if (!tables || !tables->isInitialized()) {
+                throw std::runtime_error("Global scan tables not initialized. Call initLPX() first.");
+            }
+            return std::make_shared<lpx::LPXScanSession>(tables);
+        }), py::arg("tables") = py::none())
+        .def(py::init([](const lpx::LPXScanEngine& engine) {
+            return std::make_shared<lpx::LPXScanSession>(engine.getScanContext());
+        }), py::arg("engine"), py::keep_alive<1, 2>())
+        .def("begin", [](lpx::LPXScanSession& self, lpx::LPXImage& lpxImage, int width, int height,
+                         int channels, float centerX, float centerY, const std::string& format,
+                         const std::string& dtype, int firstCell, int lastCell) {
+            lpx::PixelFormat pixelFormat;
+            if (!lpx::parsePixelFormat(format, pixelFormat)) {
+                throw std::invalid_argument("Unknown pixel format: " + format);
+            }
+            int depth;
+            if (dtype == "uint8") {
+                depth = CV_8U;
+            } else if (dtype == "uint16") {
+                depth = CV_16U;
+            } else if (dtype == "float32") {
+                depth = CV_32F;
+            } else {
+                throw std::invalid_argument("dtype must be uint8, uint16 or float32");
+            }
+            return self.begin(&lpxImage, width, height, CV_MAKETYPE(depth, channels), centerX, centerY,
+                              pixelFormat, firstCell, lastCell < 0 ? INT_MAX : lastCell);
+        }, py::arg("lpxImage"), py::arg("width"), py::arg("height"), py::arg("channels"),
+        py::arg("centerX"), py::arg("centerY"), py::arg("format") = "auto", py::arg("dtype") = "uint8",
+        py::arg("firstCell") = 0, py::arg("lastCell") = -1, py::keep_alive<1, 2>(),
+        "Start scanning a frame that will arrive as bands of rows")
+        .def("pushRows", [](lpx::LPXScanSession& self, const py::array& rows, int firstRow) {
+            cv::Mat band = numpy_to_mat(rows);
+            const lpx::optimized::FrameLayout& frame = self.getFrameLayout();
+            if (band.cols != frame.width || band.depth() != frame.depth ||
+                static_cast<int>(band.elemSize()) != frame.pixelSize) {
+                throw std::invalid_argument("Rows do not match the frame begun");
+            }
+            return self.pushRows(band.data, firstRow, band.rows, band.step);
+        }, py::arg("rows"), py::arg("firstRow"),
+        "Add rows [firstRow, firstRow + len(rows)) of the frame; returns False outside the frame")
+        .def("finish", &lpx::LPXScanSession::finish,
+             "Complete the image from the rows received so far")
+        .def("isScanning", &lpx::LPXScanSession::isScanning)
+        .def("isComplete", &lpx::LPXScanSession::isComplete)
+        .def("getFirstRow", &lpx::LPXScanSession::getFirstRow)
+        .def("getEndRow", &lpx::LPXScanSession::getEndRow)
+        .def("getRowsPending", &lpx::LPXScanSession::getRowsPending);
+
+    // Bind the delta scanner for mostly static video
+    py::class_<lpx::LPXDeltaScanner, std::shared_ptr<lpx::LPXDeltaScanner>>(m, "LPXDeltaScanner")
+        .def(py::init([](std::shared_ptr<lpx::LPXTables> tables, int tileSize) {
+            if (!tables) {
+                tables = lpx::g_scanTables;
+            }
+            if (!tables || !tables->isInitialized()) {
+                throw std::runtime_error("Global scan tables not initialized. Call initLPX() first.");
+            }
+            return std::make_shared<lpx::LPXDeltaScanner>(tables, tileSize);
+        }), py::arg("tables") = py::none(), py::arg("tileSize") = lpx::LPXDeltaScanner::DEFAULT_TILE_SIZE)
+        .def(py::init([](const lpx::LPXScanEngine& engine, int tileSize) {
+            return std::make_shared<lpx::LPXDeltaScanner>(engine.getScanContext(), tileSize);
+        }), py::arg("engine"), py::arg("tileSize") = lpx::LPXDeltaScanner::DEFAULT_TILE_SIZE,
+        py::keep_alive<1, 2>())
+        .def("scanImage", [](lpx::LPXDeltaScanner& self, const py::array& input, float centerX, float centerY,
+                             const std::string& format, int firstCell, int lastCell) {
+            lpx::PixelFormat pixelFormat;
+            if (!lpx::parsePixelFormat(format, pixelFormat)) {
+                throw std::invalid_argument("Unknown pixel format: " + format);
+            }
+            cv::Mat inputMat = numpy_to_mat(input);
+            auto result = std::make_shared<lpx::LPXImage>(self.getScanTables(), inputMat.cols, inputMat.rows);
+            bool scanned;
+            {
+                py::gil_scoped_release release;
+                scanned = self.scan(result.get(), inputMat, centerX, centerY, pixelFormat, firstCell,
+                                    lastCell < 0 ? INT_MAX : lastCell);
+            }
+            if (!scanned) {
+                throw std::runtime_error("Delta scans need an 8-bit packed image; cannot scan as " + format);
+            }
+            return result;
+        }, py::arg("image"), py::arg("centerX"), py::arg("centerY"), py::arg("format") = "auto",
+        py::arg("firstCell") = 0, py::arg("lastCell") = -1,
+        "Scan an image, summing only the tiles that changed since the last one")
+        .def("scanInto", [](lpx::LPXDeltaScanner& self, lpx::LPXImage& lpxImage, const py::array& input,
+                            float centerX, float centerY, const std::string& format, int firstCell, int lastCell) {
+            lpx::PixelFormat pixelFormat;
+            if (!lpx::parsePixelFormat(format, pixelFormat)) {
+                throw std::invalid_argument("Unknown pixel format: " + format);
+            }
+            cv::Mat inputMat = numpy_to_mat(input);
+            py::gil_scoped_release release;
+            return self.scan(&lpxImage, inputMat, centerX, centerY, pixelFormat, firstCell,
+                             lastCell < 0 ? INT_MAX : lastCell);
+        }, py::arg("lpxImage"), py::arg("image"), py::arg("centerX"), py::arg("centerY"),
+        py::arg("format") = "auto", py::arg("firstCell") = 0, py::arg("lastCell") = -1,
+        "Delta scan into an existing LPXImage, reusing its storage")
+        .def("reset", &lpx::LPXDeltaScanner::reset, "Make the next scan a full one")
+        .def("getScanTables", &lpx::LPXDeltaScanner::getScanTables)
+        .def("getTileSize", &lpx::LPXDeltaScanner::getTileSize)
+        .def("getTileCount", &lpx::LPXDeltaScanner::getTileCount)
+        .def("getChangedTileCount", &lpx::LPXDeltaScanner::getChangedTileCount)
+        .def("wasFullScan", &lpx::LPXDeltaScanner::wasFullScan);
+
+    // Bind scan thread pool configuration
+    m.def("configureScanThreads", [](unsigned int numThreads, bool pinThreads) {
+        lpx::optimized::getScanThreadPool().configure(numThreads, pinThreads);
+    }, py::arg("numThreads") = 0, py::arg("pinThreads") = false,
+    "Set the number of scan worker threads (0 = all cores) and optional core pinning");
+
+    m.def("getScanThreadCount", &lpx::optimized::getScanThreadCount,
+    "Get the number of threads used for scanning");
+
+    // Bind span kernel selection
+    m.def("setScanKernel", [](const std::string& name) {
+        lpx::optimized::ScanKernel kernel;
+        if (!lpx::optimized::parseScanKernel(name, kernel)) {
+            throw std::invalid_argument("Unknown scan kernel: " + name);
+        }
+        return lpx::optimized::setScanKernel(kernel);
+    }, py::arg("name"),
+    "Select the span kernel ('auto', 'scalar', 'sse4.1', 'avx2', 'neon'); returns False if unsupported");
+
+    m.def("getScanKernel", []() {
+        return std::string(lpx::optimized::getScanKernelName(lpx::optimized::getScanKernel()));
+    }, "Get the name of the span kernel used for scanning");
+
+    m.def("getAvailableScanKernels", []() {
+        std::vector<std::string> names;
+        const lpx::optimized::ScanKernel kernels[] = {
+            lpx::optimized::SCAN_KERNEL_SCALAR, lpx::optimized::SCAN_KERNEL_SSE41,
+            lpx::optimized::SCAN_KERNEL_AVX2, lpx::optimized::SCAN_KERNEL_NEON
+        };
+        for (lpx::optimized::ScanKernel kernel : kernels) {
+            if (lpx::optimized::isScanKernelSupported(kernel)) {
+                names.push_back(lpx::optimized::getScanKernelName(kernel));
+            }
+        }
+        return names;
+    }, "List the span kernels supported by this CPU");
+
+    // Bind cell lookup for points
+    m.def("getXCellIndex", [](float x, float y, float spiralPer) {
+        return lpx::getXCellIndex(x, y, spiralPer);
+    }, py::arg("x"), py::arg("y"), py::arg("spiralPer"),
+    "Index of the cell containing the point (x, y) relative to the spiral's center");
+
+    m.def("getXCellIndices", [](py::array_t<float, py::array::c_style | py::array::forcecast> xs,
+                                py::array_t<float, py::array::c_style | py::array::forcecast> ys,
+                                float spiralPer) {
+        if (xs.size() != ys.size()) {
+            throw std::invalid_argument("xs and ys must have the same number of points");
+        }
+        py::array_t<int32_t> cells(xs.size());
+        {
+            py::gil_scoped_release release;
+            lpx::getXCellIndices(xs.data(), ys.data(), static_cast<int>(xs.size()), spiralPer,
+                                 cells.mutable_data());
+        }
+        return cells;
+    }, py::arg("xs"), py::arg("ys"), py::arg("spiralPer"),
+    "getXCellIndex of every point, a vector of points at a time with the AVX2 or NEON kernel");
+
     // Bind initialization function
     m.def("initLPX", [](const std::string& scanTableFile, int width, int height) {
         bool success = lpx::initLPX(scanTableFile, width, height);
@@ -0,0 +1,359 @@
+/**
+ * cell_index_kernels.cpp
+ *
+ * getXCellIndex for arrays of points.
+ * The vector path evaluates atan2, log and exp with polynomials, which are
+ * close to the library functions but not equal to them. A cell boundary is
+ * where a quantity crosses an integer or a threshold, so each lane also
+ * bounds how far its quantities can be from those of the scalar function.
+ * Lanes within that distance of a boundary are computed again by the scalar
+ * function, and every lane returns exactly what getXCellIndex would.
+ */
+
+#include "../include/lpx_common.h"
+#include "../include/lpx_optimized.h"
+#include <cstdint>
+#include <cstring>
+
+#if defined(__x86_64__)
+#define LPX_CELL_X86 1
+#define LPX_CELL_TARGET __attribute__((target("avx2,fma")))
+#include <immintrin.h>
+#elif defined(__aarch64__)
+#define LPX_CELL_NEON 1
+#define LPX_CELL_TARGET
+#include <arm_neon.h>
+#endif
+
+namespace lpx {
+
+// Points are taken one at a time, through getXCellIndex<P> when the period
+// has a fixed version (fixed) and otherwise through the spiral's constants,
+// which are worked out once per call
+static void getXCellIndicesScalar(const float* xs, const float* ys, int n, XCellIndexFunction fixed,
+                                  const SpiralConstants& spiral, float logGrowth, int* out) {
+    if (fixed) {
+        for (int i = 0; i < n; i++) {
+            out[i] = fixed(xs[i], ys[i]);
+        }
+        return;
+    }
+    for (int i = 0; i < n; i++) {
+        out[i] = getXCellIndex(xs[i], ys[i], spiral, logGrowth);
+    }
+}
+
+#if defined(LPX_CELL_X86) || defined(LPX_CELL_NEON)
+
+// ---------------------------------------------------------------------------
+// Vector path, written once with GCC vector extensions: eight lanes of AVX2
+// (and FMA) on x86-64 and four of NEON on AArch64. Contracting a multiply and
+// add into an FMA changes a result by less than the margins allow for.
+
+#ifdef LPX_CELL_X86
+typedef float CellFloats __attribute__((vector_size(32)));
+typedef int32_t CellInts __attribute__((vector_size(32)));
+#else
+typedef float CellFloats __attribute__((vector_size(16)));
+typedef int32_t CellInts __attribute__((vector_size(16)));
+#endif
+static const int CELL_LANES = sizeof(CellFloats) / sizeof(float);
+
+// Bounds on how far the polynomials (and the rounding they change) can put a
+// lane's quantities from those of getXCellIndex, with a margin of safety
+static const float ANGLE_BOUND = 2e-6f;   // Radians, on the angle of the point
+static const float LOG_BOUND = 1e-6f;     // On log(radius / r0), times 1 + its size
+static const float RADIUS_BOUND = 4e-6f;  // Relative, on the radius through the cell center
+static const float ULP = 1.0f / (1 << 23);  // Spacing of floats at 1, twice their relative rounding error
+
+static const float RADIUS_SAFE_MIN = r0;       // The few points inside the spiral are left to getXCellIndex
+static const float RADIUS_SAFE_MAX = 9999.0f;  // Larger ones too (getXCellIndex returns 0 past 10000)
+
+LPX_CELL_TARGET
+static inline CellFloats sqrtLanes(CellFloats v) {
+#ifdef LPX_CELL_X86
+    return (CellFloats)_mm256_sqrt_ps((__m256)v);
+#else
+    return (CellFloats)vsqrtq_f32((float32x4_t)v);
+#endif
+}
+
+// True if any lane of the mask is set
+LPX_CELL_TARGET
+static inline bool anyLanes(CellInts mask) {
+#ifdef LPX_CELL_X86
+    return _mm256_movemask_ps((__m256)mask) != 0;
+#else
+    return vmaxvq_u32((uint32x4_t)mask) != 0;
+#endif
+}
+
+LPX_CELL_TARGET
+static inline CellFloats selectLanes(CellInts mask, CellFloats a, CellFloats b) {
+    return (CellFloats)((mask & (CellInts)a) | (~mask & (CellInts)b));
+}
+
+LPX_CELL_TARGET
+static inline CellInts selectLanes(CellInts mask, CellInts a, CellInts b) {
+    return (mask & a) | (~mask & b);
+}
+
+LPX_CELL_TARGET
+static inline CellFloats absLanes(CellFloats v) {
+    return (CellFloats)((CellInts)v & 0x7fffffff);
+}
+
+LPX_CELL_TARGET
+static inline CellFloats toFloats(CellInts v) {
+    return __builtin_convertvector(v, CellFloats);
+}
+
+// Rounded toward zero, as static_cast<int> does
+LPX_CELL_TARGET
+static inline CellInts toInts(CellFloats v) {
+    return __builtin_convertvector(v, CellInts);
+}
+
+// Distance from v to the nearest integer
+LPX_CELL_TARGET
+static inline CellFloats integerDistance(CellFloats v) {
+    const CellFloats fraction = absLanes(v - toFloats(toInts(v)));
+    return selectLanes(fraction < 0.5f, fraction, 1.0f - fraction);
+}
+
+// atan2(y, x) for points other than the origin (Cephes atanf, reduced to
+// [0, tan(pi/8)])
+LPX_CELL_TARGET
+static inline CellFloats atan2Lanes(CellFloats y, CellFloats x) {
+    const CellFloats ax = absLanes(x);
+    const CellFloats ay = absLanes(y);
+    const CellInts steep = ay > ax;
+    const CellFloats z = selectLanes(steep, ax, ay) / selectLanes(steep, ay, ax);  // [0, 1]
+
+    const CellInts reduce = z > 0.41421356f;
+    const CellFloats t = selectLanes(reduce, (z - 1.0f) / (z + 1.0f), z);
+    const CellFloats t2 = t * t;
+    CellFloats a = (((8.05374449538e-2f * t2 - 1.38776856032e-1f) * t2 + 1.99777106478e-1f) * t2 -
+                    3.33329491539e-1f) * t2 * t + t;
+    a = selectLanes(reduce, a + 0.78539816f, a);
+
+    a = selectLanes(steep, 1.57079633f - a, a);
+    a = selectLanes(x < 0.0f, 3.14159265f - a, a);
+    return (CellFloats)((CellInts)a | ((CellInts)y & (int32_t)0x80000000));  // Sign of y, as atan2
+}
+
+// Natural log of positive normal numbers (Cephes logf)
+LPX_CELL_TARGET
+static inline CellFloats logLanes(CellFloats v) {
+    const CellInts bits = (CellInts)v;
+    CellInts exponent = ((bits >> 23) & 0xff) - 126;
+    CellFloats m = (CellFloats)((bits & 0x807fffff) | 0x3f000000);  // [0.5, 1)
+
+    const CellInts small = m < 0.70710678f;
+    exponent += small;  // Masks are -1
+    m = m + selectLanes(small, m, CellFloats{}) - 1.0f;
+    const CellFloats e = toFloats(exponent);
+
+    const CellFloats z = m * m;
+    CellFloats y = ((((((((7.0376836292e-2f * m - 1.1514610310e-1f) * m + 1.1676998740e-1f) * m -
+                        1.2420140846e-1f) * m + 1.4249322787e-1f) * m - 1.6668057665e-1f) * m +
+                      2.0000714765e-1f) * m - 2.4999993993e-1f) * m + 3.3333331174e-1f) * m * z;
+    y += e * -2.12194440e-4f;
+    y += -0.5f * z;
+    return (m + y) + e * 0.693359375f;
+}
+
+// e^v for |v| well inside the float range (Cephes expf)
+LPX_CELL_TARGET
+static inline CellFloats expLanes(CellFloats v) {
+    const CellFloats scaled = v * 1.44269504088896341f + 0.5f;
+    CellInts n = toInts(scaled);
+    n += (CellInts)(toFloats(n) > scaled);  // Round down
+    const CellFloats fn = toFloats(n);
+
+    const CellFloats x = v - fn * 0.693359375f - fn * -2.12194440e-4f;
+    const CellFloats z = x * x;
+    const CellFloats p = (((((1.9875691500e-4f * x + 1.3981999507e-3f) * x + 8.3334519073e-3f) * x +
+                            4.1665795894e-2f) * x + 1.6666665459e-1f) * x + 5.0000001201e-1f) * z + x + 1.0f;
+    return p * (CellFloats)((n + 127) << 23);
+}
+
+// The spiral's constants, and how near a boundary each quantity of a lane
+// may come before the lane is left to getXCellIndex. The margins hold for the
+// largest values the quantities take between RADIUS_SAFE_MIN and
+// RADIUS_SAFE_MAX, so the lanes need not work out their own.
+struct CellLaneConstants {
+    float spiralPer;
+    float pitchAng;
+    float invPitchAng;
+    float halfPitch;
+    float growth;
+    float width;
+    float logGrowth;
+    float logScale;      // 4 pi / log(growth) / pitch angle, the factor getXCellIndex applies to log(radius / r0)
+    int wholePer;
+    float jMargin;       // Of the half-cell angle j to an integer
+    float periodMargin;  // Of the spiral periods to an integer
+    float regionMargin;  // Of radius - r1 to s_2 or 2 s_2, over r1
+    float limitMargin;   // Of da to the bound in the middle third
+
+    CellLaneConstants(const SpiralConstants& spiral, float growthLog) {
+        spiralPer = spiral.spiralPer;
+        pitchAng = spiral.pitchAng;
+        invPitchAng = spiral.invPitchAng;
+        halfPitch = spiral.pitch * 0.5f;
+        growth = spiral.sv_A_pitch_1;
+        width = spiral.width;
+        logGrowth = growthLog;
+        logScale = static_cast<float>(4.0f * M_PI / growthLog * spiral.invPitchAng);
+        wholePer = spiral.wholePer;
+
+        const double ulp = ULP;
+        const double maxLog = std::log(RADIUS_SAFE_MAX / r0) + 1.0;
+        const double maxJ = 2.0 * spiralPer + 1.0;
+        const double j = 2.0 * invPitchAng * ANGLE_BOUND + 4.0 * ulp * (maxJ + 1.0);
+
+        const double maxPeriods = logScale * maxLog;
+        const double maxQ = (maxPeriods + maxJ) * halfPitch;
+        const double q = halfPitch * (logScale * LOG_BOUND * (maxLog + 1.0) + j + 4.0 * ulp * (maxPeriods + maxJ)) +
+                         4.0 * ulp * maxQ;
+
+        const double maxSum = (maxQ + 1.0) * 2.0 * spiralPer + maxJ;
+        const double maxAbsAng = 0.5 * maxSum * pitchAng;
+        const double absAng = 0.5 * pitchAng * (j + 2.0 * ulp * maxSum) + 2.0 * ulp * maxAbsAng;
+        const double r1 = logGrowth * (absAng / TWO_PI + 2.0 * ulp * maxAbsAng / TWO_PI) + RADIUS_BOUND;
+
+        // Near either boundary radius is below r2 = growth r1
+        const double thirdOverR1 = (growth - 1.0) / 3.0;  // s_2 / r1
+        const double dr = r1 + 2.0 * ulp * growth;
+        const double s_2 = thirdOverR1 * r1 + 2.0 * ulp * growth;
+        const double da = absAng + 2.0 * ulp * maxAbsAng;
+        const double bound = width * ((dr + 2.0 * s_2) / thirdOverR1 + 6.0 * ulp);
+
+        jMargin = static_cast<float>(j);
+        periodMargin = static_cast<float>(q);
+        regionMargin = static_cast<float>(dr + 2.0 * s_2);
+        limitMargin = static_cast<float>(da + bound);
+    }
+};
+
+// Cells of CELL_LANES points, and in fallback the lanes getXCellIndex must
+// decide. Each step mirrors getXCellIndex, in the same order of float operations.
+LPX_CELL_TARGET
+static inline CellInts cellIndexLanes(CellFloats x, CellFloats y, const CellLaneConstants& c, CellInts& fallback) {
+    CellFloats radius = sqrtLanes(x * x + y * y);
+    fallback = ~((radius > RADIUS_SAFE_MIN) & (radius < RADIUS_SAFE_MAX));  // Also catches NaN
+    x = selectLanes(fallback, CellFloats{} + 1.0f, x);  // (1, 0) in their place keeps the lanes finite
+    y = selectLanes(fallback, CellFloats{}, y);
+    radius = selectLanes(fallback, CellFloats{} + 1.0f, radius);
+
+    const CellFloats angle = atan2Lanes(y, x);
+    const CellFloats ang = selectLanes(angle < 0.0f, angle + TWO_PI, angle);
+    const CellFloats arg = ang * c.invPitchAng;
+    const CellFloats j = 2.0f * arg - 0.0000001f;
+    fallback |= integerDistance(j) < c.jMargin;
+
+    // Periods of the spiral, found in double by getXCellIndex
+    const CellFloats logRadius = logLanes(radius * (1.0f / r0));  // Within LOG_BOUND of log(radius / r0)
+    const CellFloats q = (c.logScale * logRadius - j) * c.halfPitch;
+    fallback |= integerDistance(q) < c.periodMargin;
+
+    const CellInts iPer = toInts(q);
+    const CellInts iPer_2_spiralPer = toInts(toFloats(iPer * 2) * c.spiralPer);
+    const CellInts iCell_2 = iPer_2_spiralPer + toInts(j);
+
+    const CellFloats absAng = 0.5f * (toFloats(iPer_2_spiralPer) + j) * c.pitchAng;
+    const CellFloats ang1 = 0.5f * toFloats(iCell_2) * c.pitchAng;
+
+    const CellFloats r1 = r0 * expLanes(absAng * (1.0f / TWO_PI) * c.logGrowth);
+    const CellFloats r2 = r1 * c.growth;
+    const CellFloats s_2 = (r2 - r1) * ONE_THIRD;
+
+    const CellFloats dr = radius - r1;
+    const CellFloats da = absAng - ang1;
+
+    // Regions 1, the middle third (2 to 5) and the outer third (4 or 5)
+    const CellInts inner = dr < s_2;
+    const CellInts outer = dr >= 2.0f * s_2;
+    const CellFloats regionMargin = r1 * c.regionMargin;
+    fallback |= (absLanes(dr - s_2) < regionMargin) | (absLanes(dr - 2.0f * s_2) < regionMargin);
+
+    const CellInts iCell = (iCell_2 + ((iCell_2 >> 31) & 1)) >> 1;  // iCell_2 / 2
+    const CellInts upper = ((iCell_2 & 1) != 0) & (iCell_2 > 0);  // iCell_2 % 2 > 0
+    const CellInts next = iCell + c.wholePer + (upper & 1);
+
+    // Dividing by way of the reciprocal moves bound by 2 ulps at most
+    const CellFloats bound = c.width * (dr - s_2) * (1.0f / s_2);
+    const CellFloats limit = selectLanes(upper, c.width - bound, bound);
+    const CellInts middle = ~inner & ~outer;
+    fallback |= middle & (absLanes(da - limit) < c.limitMargin);
+
+    // Region 4 (upper) is da >= width - bound, region 5 (lower) da < bound
+    const CellInts crossed = selectLanes(upper, da >= limit, da < limit);
+    CellInts result = selectLanes(inner | (middle & ~crossed), iCell, next);
+    result = selectLanes(outer & ((next < 0) | (next > 100000)), CellInts{}, result);
+    return result;
+}
+
+// Kept out of line, so the scalar path is not compiled into the vector loop
+__attribute__((noinline))
+static int getFallbackXCellIndex(float x, float y, XCellIndexFunction fixed, const SpiralConstants& spiral,
+                                 float logGrowth) {
+    return fixed ? fixed(x, y) : getXCellIndex(x, y, spiral, logGrowth);
+}
+
+LPX_CELL_TARGET
+static void getXCellIndicesVector(const float* xs, const float* ys, int n, XCellIndexFunction fixed,
+                                  const SpiralConstants& spiral, float logGrowth, int* out) {
+    const CellLaneConstants constants(spiral, logGrowth);
+
+    int i = 0;
+    for (; i + CELL_LANES <= n; i += CELL_LANES) {
+        CellFloats x, y;
+        std::memcpy(&x, xs + i, sizeof(x));
+        std::memcpy(&y, ys + i, sizeof(y));
+
+        CellInts fallback;
+        const CellInts cells = cellIndexLanes(x, y, constants, fallback);
+        std::memcpy(out + i, &cells, sizeof(cells));
+        if (!anyLanes(fallback)) {
+            continue;
+        }
+        for (int lane = 0; lane < CELL_LANES; lane++) {
+            if (fallback[lane]) {
+                out[i + lane] = getFallbackXCellIndex(xs[i + lane], ys[i + lane], fixed, spiral, logGrowth);
+            }
+        }
+    }
+    getXCellIndicesScalar(xs + i, ys + i, n - i, fixed, spiral, logGrowth, out + i);
+}
+
+#endif // LPX_CELL_X86 || LPX_CELL_NEON
+
+void getXCellIndices(const float* xs, const float* ys, int n, float spiralPer, int* out) {
+    if (n <= 0) {
+        return;
+    }
+    const SpiralConstants spiral(static_cast<int>(std::floor(spiralPer)));
+    const float logGrowth = std::log(spiral.sv_A_pitch_1);
+    const XCellIndexFunction fixed = getFixedXCellIndex(spiralPer);
+
+    // The vector path follows the span kernel selection (LPX_SCAN_KERNEL)
+    const optimized::ScanKernel kernel = optimized::getScanKernel();
+#ifdef LPX_CELL_X86
+    if (kernel == optimized::SCAN_KERNEL_AVX2 && __builtin_cpu_supports("fma")) {
+        getXCellIndicesVector(xs, ys, n, fixed, spiral, logGrowth, out);
+        return;
+    }
+#endif
+#ifdef LPX_CELL_NEON
+    if (kernel == optimized::SCAN_KERNEL_NEON) {
+        getXCellIndicesVector(xs, ys, n, fixed, spiral, logGrowth, out);
+        return;
+    }
+#endif
+    (void)kernel;
+    getXCellIndicesScalar(xs, ys, n, fixed, spiral, logGrowth, out);
+}
+
+} // namespace lpx
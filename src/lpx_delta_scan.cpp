@@ -0,0 +1,330 @@
+/**
+ * lpx_delta_scan.cpp
+ *
+ * Delta scan: only the tiles that changed since the last frame are summed
+ */
+
+#include "../include/lpx_delta_scan.h"
+#include "../include/lpx_common.h"
+#include <algorithm>
+#include <cstring>
+
+namespace lpx {
+
+// B, G, R sums of n pixels of an 8-bit FORMAT row from column col
+template <PixelFormat FORMAT>
+static inline void sumPixels(const optimized::ScanKernelFunctions& kernel, const uchar* row, int col, int n,
+                             int& sumB, int& sumG, int& sumR) {
+    switch (FORMAT) {
+        case PIXEL_FORMAT_BGR:
+            kernel.sumBGR(row + 3 * col, n, sumB, sumG, sumR);
+            break;
+        case PIXEL_FORMAT_RGB:
+            kernel.sumBGR(row + 3 * col, n, sumR, sumG, sumB);
+            break;
+        case PIXEL_FORMAT_BGRA:
+            kernel.sumBGRA(row + 4 * col, n, sumB, sumG, sumR);
+            break;
+        default:
+            sumB = kernel.sumGray(row + col, n);
+            sumG = sumB;
+            sumR = sumB;
+            break;
+    }
+}
+
+// Replace the previous pixels of image row `row` with the current ones in
+// the sums of the spans crossing the column runs [runs[2i], runs[2i + 1]).
+// Spans of a row are in column order, so each run starts with a binary search.
+// Cells whose sums change are added to dirtyCells.
+template <PixelFormat FORMAT>
+static void updateRowSpans(const optimized::ScanPlan& plan, int row, const uchar* current, const uchar* previous,
+                           const int* runs, int nRuns, optimized::CellAccumulator* cells,
+                           char* cellDirty, std::vector<int>& dirtyCells) {
+    const optimized::ScanKernelFunctions& kernel = optimized::getScanKernelFunctions();
+    const optimized::PlanSpan* first = plan.spans.data() + plan.rowSpanStart[row - plan.yMin];
+    const optimized::PlanSpan* last = plan.spans.data() + plan.rowSpanStart[row - plan.yMin + 1];
+
+    for (int i = 0; i < nRuns; i++) {
+        const int runStart = runs[2 * i];
+        const int runEnd = runs[2 * i + 1];
+        const optimized::PlanSpan* span = std::partition_point(first, last,
+            [runStart](const optimized::PlanSpan& s) { return s.col + s.count <= runStart; });
+        for (; span != last && span->col < runEnd; ++span) {
+            const int col = std::max(span->col, runStart);
+            const int n = std::min(span->col + span->count, runEnd) - col;
+            int newB, newG, newR, oldB, oldG, oldR;
+            sumPixels<FORMAT>(kernel, current, col, n, newB, newG, newR);
+            sumPixels<FORMAT>(kernel, previous, col, n, oldB, oldG, oldR);
+            if (newB == oldB && newG == oldG && newR == oldR) continue;
+
+            optimized::CellAccumulator& cell = cells[span->cell];
+            cell.b += newB - oldB;
+            cell.g += newG - oldG;
+            cell.r += newR - oldR;
+            if (!cellDirty[span->cell]) {
+                cellDirty[span->cell] = 1;
+                dirtyCells.push_back(span->cell);
+            }
+        }
+    }
+}
+
+typedef void (*UpdateRowSpansFn)(const optimized::ScanPlan&, int, const uchar*, const uchar*, const int*, int,
+                                 optimized::CellAccumulator*, char*, std::vector<int>&);
+
+static UpdateRowSpansFn selectUpdateRowSpans(PixelFormat format) {
+    switch (format) {
+        case PIXEL_FORMAT_BGR: return updateRowSpans<PIXEL_FORMAT_BGR>;
+        case PIXEL_FORMAT_RGB: return updateRowSpans<PIXEL_FORMAT_RGB>;
+        case PIXEL_FORMAT_BGRA: return updateRowSpans<PIXEL_FORMAT_BGRA>;
+        default: return updateRowSpans<PIXEL_FORMAT_GRAY>;
+    }
+}
+
+const int LPXDeltaScanner::DEFAULT_TILE_SIZE;
+
+LPXDeltaScanner::LPXDeltaScanner(std::shared_ptr<LPXTables> tables, int tileSize)
+    : tileSize(tileSize > 0 ? tileSize : DEFAULT_TILE_SIZE) {
+    if (tables && tables->isInitialized()) {
+        context = optimized::getDefaultScanContext(tables);
+    }
+}
+
+LPXDeltaScanner::LPXDeltaScanner(const optimized::ScanContext& context, int tileSize)
+    : context(context), tileSize(tileSize > 0 ? tileSize : DEFAULT_TILE_SIZE) {
+}
+
+void LPXDeltaScanner::reset() {
+    plan.reset();
+}
+
+bool LPXDeltaScanner::scan(LPXImage* lpxImage, const cv::Mat& image, float x_center, float y_center,
+                           PixelFormat format, int firstCell, int lastCell) {
+    if (!lpxImage || !context.spans || !context.plans || lpxImage->getScanTables() != context.spans->sct ||
+        image.empty()) {
+        LOG_ERROR("LPXImage was not created with the scan tables of this delta scanner");
+        return false;
+    }
+    if (lpxImage->hasCellStatistics()) {
+        LOG_ERROR("Delta scans do not gather cell statistics");
+        return false;
+    }
+    optimized::FrameLayout frame;
+    if (!optimized::describeFrame(image, format, frame)) {
+        LOG_ERROR(std::string("Image does not match pixel format ") + getPixelFormatName(format));
+        return false;
+    }
+    if (frame.isYUV() || frame.depth != CV_8U) {
+        LOG_ERROR(std::string("Delta scans need an 8-bit packed frame; cannot scan ") +
+                  getPixelFormatName(frame.format));
+        return false;
+    }
+
+    const int nMaxCells = lpxImage->getMaxCells();
+    std::shared_ptr<const optimized::ScanPlan> framePlan =
+        context.plans->get(*context.spans, nMaxCells, frame, x_center, y_center, 0, firstCell, lastCell);
+    const bool frameRainbowMode = optimized::isRainbowModeEnabled();
+
+    // Anything that changes the plan or the output needs a full scan; a plan
+    // evicted from the cache and rebuilt the same still has the same key
+    fullScan = !plan || !(framePlan->key == plan->key) || lpxImage->hasPreciseOutput() != precise ||
+               frameRainbowMode != rainbowMode;
+    if (fullScan) {
+        plan = framePlan;
+        precise = lpxImage->hasPreciseOutput();
+        rainbowMode = frameRainbowMode;
+        scanFull(frame, rainbowMode);
+    } else {
+        scanChanges(frame, rainbowMode);
+    }
+
+    // The scanner keeps the cells; the image gets a copy
+    lpxImage->accessCellArray() = cells;
+    if (precise) {
+        lpxImage->accessPreciseCellArray() = preciseCells;
+    }
+    lpxImage->setSize(frame.width, frame.height);
+    lpxImage->setPosition(x_center, y_center);
+    lpxImage->setLength(nMaxCells);
+    if (lpxImage->hasOpponentOutput()) {
+        lpxImage->updateOpponentCells();
+    }
+    return true;
+}
+
+void LPXDeltaScanner::scanFull(const optimized::FrameLayout& frame, bool rainbowMode) {
+    const int nMaxCells = plan->key.nMaxCells;
+    const int cellStart = plan->cellStart;
+    const int cellEnd = plan->cellEnd;
+    cells.assign(nMaxCells, 0u);
+    preciseCells.assign(precise ? 3 * static_cast<size_t>(nMaxCells) : 0, 0.0f);
+    float* preciseOut = precise ? preciseCells.data() : nullptr;
+    cellDirty.assign(nMaxCells, 0);
+    dirtyCells.reserve(nMaxCells);
+
+    buffer.resize(nMaxCells);
+    buffer.clear(cellStart, cellEnd);
+    optimized::optimizedProcessImageRegion(frame, plan->yMin, plan->yMax, *plan, buffer);
+    optimized::gatherFoveaPixels(frame, *plan, cells, preciseOut);
+    optimized::mergeCellRange(&buffer, 1, cellStart, cellEnd, plan->sct->lastFoveaIndex, false,
+                              rainbowMode, cells, preciseOut);
+
+    // Keep the rows the plan reads for comparing with the next frame
+    indexFoveaTiles();
+    const size_t rowBytes = static_cast<size_t>(frame.width) * frame.pixelSize;
+    previousStep = rowBytes;
+    previous.resize(rowBytes * (endRow - firstRow));
+    for (int row = firstRow; row < endRow; row++) {
+        memcpy(previous.data() + (row - firstRow) * previousStep, frame.pixels + row * frame.step, rowBytes);
+    }
+    changedTiles = tileCount;
+}
+
+// Rows the plan reads and its fovea pixels grouped by tile. Only the last
+// table entry for each cell is kept: it is the one a full gather leaves in place.
+void LPXDeltaScanner::indexFoveaTiles() {
+    const std::vector<optimized::PlanFoveaPixel>& fovea = plan->fovea;
+    const int step = static_cast<int>(plan->key.step);
+    const int pixelSize = plan->key.pixelSize;
+    const int width = plan->key.cols;
+
+    std::vector<char> cellSeen(plan->key.nMaxCells, 0);
+    std::vector<int> kept;
+    kept.reserve(fovea.size());
+    int rowMin = (plan->yMin < plan->yMax) ? plan->yMin : INT_MAX;
+    int rowEnd = (plan->yMin < plan->yMax) ? plan->yMax : 0;
+    for (int i = static_cast<int>(fovea.size()) - 1; i >= 0; i--) {
+        if (cellSeen[fovea[i].cell]) continue;
+        cellSeen[fovea[i].cell] = 1;
+        kept.push_back(i);
+        const int row = fovea[i].offset / step;
+        rowMin = std::min(rowMin, row);
+        rowEnd = std::max(rowEnd, row + 1);
+    }
+    firstRow = std::min(rowMin, rowEnd);
+    endRow = rowEnd;
+
+    // Counting sort by tile
+    tilesPerRow = (width + tileSize - 1) / tileSize;
+    tileCount = tilesPerRow * ((endRow - firstRow + tileSize - 1) / tileSize);
+    auto tileOf = [&](const optimized::PlanFoveaPixel& pixel) {
+        const int row = pixel.offset / step;
+        const int col = (pixel.offset % step) / pixelSize;
+        return ((row - firstRow) / tileSize) * tilesPerRow + col / tileSize;
+    };
+    foveaTileStart.assign(tileCount + 1, 0);
+    for (int i : kept) {
+        foveaTileStart[tileOf(fovea[i]) + 1]++;
+    }
+    for (size_t t = 1; t < foveaTileStart.size(); t++) {
+        foveaTileStart[t] += foveaTileStart[t - 1];
+    }
+    std::vector<int> next(foveaTileStart.begin(), foveaTileStart.end() - 1);
+    foveaByTile.resize(kept.size());
+    for (int i : kept) {
+        foveaByTile[next[tileOf(fovea[i])]++] = fovea[i];
+    }
+
+    tileChanged.assign(tilesPerRow, 0);
+    changedRuns.reserve(2 * tilesPerRow);
+    foveaChanged.reserve(foveaByTile.size());
+}
+
+void LPXDeltaScanner::markDirty(int cell) {
+    if (!cellDirty[cell]) {
+        cellDirty[cell] = 1;
+        dirtyCells.push_back(cell);
+    }
+}
+
+void LPXDeltaScanner::scanChanges(const optimized::FrameLayout& frame, bool rainbowMode) {
+    const int pixelSize = frame.pixelSize;
+    const UpdateRowSpansFn updateRow = selectUpdateRowSpans(frame.format);
+    optimized::CellAccumulator* sums = buffer.data();
+    float* preciseOut = precise ? preciseCells.data() : nullptr;
+    changedTiles = 0;
+    foveaChanged.clear();
+
+    for (int bandRow = firstRow; bandRow < endRow; bandRow += tileSize) {
+        const int bandEnd = std::min(bandRow + tileSize, endRow);
+
+        // Tiles of this band that differ from the previous frame; comparing
+        // stops at a tile's first differing row
+        std::fill(tileChanged.begin(), tileChanged.end(), 0);
+        int bandChanged = 0;
+        for (int row = bandRow; row < bandEnd && bandChanged < tilesPerRow; row++) {
+            const uchar* current = frame.pixels + row * frame.step;
+            const uchar* before = previous.data() + (row - firstRow) * previousStep;
+            for (int t = 0; t < tilesPerRow; t++) {
+                if (tileChanged[t]) continue;
+                const int col = t * tileSize;
+                const size_t bytes = static_cast<size_t>(std::min(tileSize, frame.width - col)) * pixelSize;
+                if (memcmp(current + col * pixelSize, before + col * pixelSize, bytes) != 0) {
+                    tileChanged[t] = 1;
+                    bandChanged++;
+                }
+            }
+        }
+        if (bandChanged == 0) continue;
+        changedTiles += bandChanged;
+
+        // Runs of adjacent changed tiles, as image columns
+        changedRuns.clear();
+        for (int t = 0; t < tilesPerRow; t++) {
+            if (!tileChanged[t]) continue;
+            if (!changedRuns.empty() && changedRuns.back() == t * tileSize) {
+                changedRuns.back() = std::min((t + 1) * tileSize, frame.width);
+            } else {
+                changedRuns.push_back(t * tileSize);
+                changedRuns.push_back(std::min((t + 1) * tileSize, frame.width));
+            }
+        }
+        const int nRuns = static_cast<int>(changedRuns.size()) / 2;
+
+        // Swap the old pixels for the new in the peripheral sums, then keep the new
+        for (int row = bandRow; row < bandEnd; row++) {
+            const uchar* current = frame.pixels + row * frame.step;
+            uchar* before = previous.data() + (row - firstRow) * previousStep;
+            if (row >= plan->yMin && row < plan->yMax) {
+                updateRow(*plan, row, current, before, changedRuns.data(), nRuns, sums,
+                          cellDirty.data(), dirtyCells);
+            }
+            for (int i = 0; i < nRuns; i++) {
+                const int col = changedRuns[2 * i];
+                memcpy(before + col * pixelSize, current + col * pixelSize,
+                       static_cast<size_t>(changedRuns[2 * i + 1] - col) * pixelSize);
+            }
+        }
+
+        // Fovea pixels of the changed tiles are read again
+        const int tileRow = (bandRow - firstRow) / tileSize;
+        for (int t = 0; t < tilesPerRow; t++) {
+            if (!tileChanged[t]) continue;
+            const int tile = tileRow * tilesPerRow + t;
+            foveaChanged.insert(foveaChanged.end(), foveaByTile.begin() + foveaTileStart[tile],
+                                foveaByTile.begin() + foveaTileStart[tile + 1]);
+        }
+    }
+
+    if (!foveaChanged.empty()) {
+        optimized::gatherFoveaPixels(frame, foveaChanged.data(), static_cast<int>(foveaChanged.size()),
+                                     cells, preciseOut);
+        // Cells the merge also writes (peripheral cells with a fovea entry,
+        // or every cell in rainbow mode) are merged again after the gather
+        for (const optimized::PlanFoveaPixel& pixel : foveaChanged) {
+            markDirty(pixel.cell);
+        }
+    }
+
+    // Average the touched cells again
+    const int lastFoveaIndex = plan->sct->lastFoveaIndex;
+    for (int cell : dirtyCells) {
+        optimized::mergeCellRange(&buffer, 1, cell, cell + 1, lastFoveaIndex, false, rainbowMode,
+                                  cells, preciseOut);
+        cellDirty[cell] = 0;
+    }
+    dirtyCells.clear();
+}
+
+} // namespace lpx
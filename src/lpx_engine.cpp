@@ -0,0 +1,187 @@
+/**
+ * lpx_engine.cpp
+ *
+ * Scan engine owning its tables, plan cache and worker pool
+ */
+
+#include "../include/lpx_engine.h"
+#include "../include/lpx_common.h"
+
+namespace lpx {
+
+LPXScanEngine::LPXScanEngine(std::shared_ptr<LPXTables> tables, unsigned int numThreads,
+                             bool pinThreads, size_t planCacheSize, size_t imagePoolSize)
+    : tables(tables),
+      pool(new optimized::ScanThreadPool(numThreads, pinThreads)),
+      plans(new optimized::ScanPlanCache(planCacheSize)),
+      images(tables, imagePoolSize) {
+    if (tables && tables->isInitialized()) {
+        // The row index is built here rather than on the first scan, and shared
+        // with any other engine or global scan using the same tables
+        context.spans = optimized::getSharedScanSpanTable(tables);
+    }
+    context.plans = plans.get();
+    context.pool = pool.get();
+}
+
+std::shared_ptr<LPXScanEngine> LPXScanEngine::create(const std::string& scanTableFile, unsigned int numThreads,
+                                                     bool pinThreads, size_t planCacheSize,
+                                                     size_t imagePoolSize) {
+    auto tables = std::make_shared<LPXTables>(scanTableFile);
+    if (!tables->isInitialized()) {
+        LOG_ERROR("Failed to load scan tables for scan engine: " + scanTableFile);
+        return nullptr;
+    }
+    return std::make_shared<LPXScanEngine>(tables, numThreads, pinThreads, planCacheSize, imagePoolSize);
+}
+
+bool LPXScanEngine::scanFromImage(LPXImage* lpxImage, const cv::Mat& image, float x_center, float y_center,
+                                  PixelFormat format) {
+    if (!context.spans) {
+        return false;
+    }
+    return optimized::optimizedMultithreadedScan(context, lpxImage, image, x_center, y_center, format);
+}
+
+bool LPXScanEngine::scanInto(LPXImage& lpxImage, const cv::Mat& image, float x_center, float y_center,
+                             PixelFormat format) {
+    const cv::Size frameSize = getFrameSize(image, format);
+    if (!context.spans || frameSize.width <= 0) {
+        return false;
+    }
+    lpxImage.setSize(frameSize.width, frameSize.height);
+    return optimized::optimizedMultithreadedScan(context, &lpxImage, image, x_center, y_center, format);
+}
+
+std::shared_ptr<LPXImage> LPXScanEngine::scanImage(const cv::Mat& image, float x_center, float y_center,
+                                                   PixelFormat format) {
+    if (!context.spans) {
+        return nullptr;
+    }
+
+    const cv::Size frameSize = getFrameSize(image, format);
+    auto lpxImage = images.acquire(frameSize.width, frameSize.height);
+    if (optimized::optimizedMultithreadedScan(context, lpxImage.get(), image, x_center, y_center, format)) {
+        return lpxImage;
+    }
+    return nullptr;
+}
+
+std::shared_ptr<LPXImage> LPXScanEngine::scanResizedImage(const cv::Mat& image, cv::Size scanSize,
+                                                          float x_center, float y_center,
+                                                          PixelFormat format) {
+    if (!context.spans || scanSize.width <= 0 || scanSize.height <= 0) {
+        return nullptr;
+    }
+
+    auto lpxImage = images.acquire(scanSize.width, scanSize.height);
+    if (optimized::optimizedMultithreadedScan(context, lpxImage.get(), image, x_center, y_center,
+                                              format, scanSize)) {
+        return lpxImage;
+    }
+    return nullptr;
+}
+
+std::shared_ptr<LPXImage> LPXScanEngine::scanCellRange(const cv::Mat& image, float x_center, float y_center,
+                                                       int firstCell, int lastCell,
+                                                       PixelFormat format, cv::Size scanSize) {
+    if (!context.spans) {
+        return nullptr;
+    }
+
+    const bool resized = scanSize.width > 0 && scanSize.height > 0;
+    const cv::Size frameSize = resized ? scanSize : getFrameSize(image, format);
+    auto lpxImage = images.acquire(frameSize.width, frameSize.height);
+    if (optimized::optimizedMultithreadedScan(context, lpxImage.get(), image, x_center, y_center,
+                                              format, scanSize, firstCell, lastCell)) {
+        return lpxImage;
+    }
+    return nullptr;
+}
+
+std::shared_ptr<LPXImage> LPXScanEngine::scanImagePyramid(const cv::Mat& image, float x_center, float y_center,
+                                                          int pyramidLevels, PixelFormat format) {
+    if (!context.spans) {
+        return nullptr;
+    }
+
+    std::lock_guard<std::mutex> lock(pyramidMutex);
+    if (!optimized::buildScanPyramid(*pool, image, pyramidLevels, pyramid, format)) {
+        return nullptr;
+    }
+
+    auto lpxImage = images.acquire(image.cols, image.rows);
+    const bool scanned = optimized::optimizedPyramidScan(context, lpxImage.get(), pyramid,
+                                                         x_center, y_center, format);
+    pyramid[0] = cv::Mat();  // Do not keep the caller's frame alive
+    return scanned ? lpxImage : nullptr;
+}
+
+std::shared_ptr<LPXImage> LPXScanEngine::scanCells(const cv::Mat& image, float x_center, float y_center,
+                                                   const std::vector<int>& cells, PixelFormat format) {
+    if (!context.spans) {
+        return nullptr;
+    }
+
+    const cv::Size frameSize = getFrameSize(image, format);
+    auto lpxImage = images.acquire(frameSize.width, frameSize.height);
+    if (optimized::optimizedScanCells(context, lpxImage.get(), image, x_center, y_center,
+                                      cells.data(), static_cast<int>(cells.size()), format)) {
+        return lpxImage;
+    }
+    return nullptr;
+}
+
+std::vector<std::shared_ptr<LPXImage>> LPXScanEngine::scanMultiple(const cv::Mat& image,
+                                                                   const std::vector<cv::Point2f>& centers,
+                                                                   PixelFormat format) {
+    if (!context.spans) {
+        return {};
+    }
+
+    const cv::Size frameSize = getFrameSize(image, format);
+    std::vector<std::shared_ptr<LPXImage>> results;
+    std::vector<LPXImage*> lpxImages;
+    results.reserve(centers.size());
+    lpxImages.reserve(centers.size());
+    for (size_t i = 0; i < centers.size(); i++) {
+        results.push_back(images.acquire(frameSize.width, frameSize.height));
+        lpxImages.push_back(results.back().get());
+    }
+
+    if (!optimized::optimizedMultithreadedScanMultiple(context, lpxImages, image, centers, format)) {
+        return {};
+    }
+    return results;
+}
+
+std::vector<std::shared_ptr<LPXImage>> LPXScanEngine::scanBatch(const std::vector<cv::Mat>& frames,
+                                                                const std::vector<cv::Point2f>& centers,
+                                                                PixelFormat format) {
+    if (!context.spans || centers.empty() || (centers.size() != 1 && centers.size() != frames.size())) {
+        return {};
+    }
+
+    std::vector<std::shared_ptr<LPXImage>> results;
+    std::vector<LPXImage*> lpxImages;
+    results.reserve(frames.size());
+    lpxImages.reserve(frames.size());
+    for (const cv::Mat& frame : frames) {
+        const cv::Size frameSize = getFrameSize(frame, format);
+        results.push_back(images.acquire(frameSize.width, frameSize.height));
+        lpxImages.push_back(results.back().get());
+    }
+
+    std::vector<char> scanned;
+    if (!optimized::optimizedScanBatch(context, lpxImages, frames, centers, format, &scanned)) {
+        if (scanned.size() != results.size()) {
+            return {};
+        }
+        for (size_t i = 0; i < results.size(); i++) {
+            if (!scanned[i]) results[i].reset();
+        }
+    }
+    return results;
+}
+
+} // namespace lpx
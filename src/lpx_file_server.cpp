@@ -31,6 +31,7 @@ FileLPXServer::FileLPXServer(const std::string& scanTableFile, int port)
         throw std::runtime_error("Failed to initialize scan tables from: " + scanTableFile);
     }
 
+    scanEngine = std::make_shared<LPXScanEngine>(scanTables);
     g_scanTables = scanTables;
 }
 
@@ -260,16 +261,13 @@ void FileLPXServer::captureThread() {
             }
         }
         
-        // Convert from RGB to BGR since video files provide RGB data 
-        // but OpenCV and our scanning pipeline expect BGR format
-        cv::cvtColor(frame, frame, cv::COLOR_RGB2BGR);
+        // Video files provide RGB data; frames stay RGB and the scan swaps
+        // channels per cell, so there is no full-frame conversion here
         
         currentFrame++;
         
-        // Resize if necessary
-        if (frame.cols != outputWidth || frame.rows != outputHeight) {
-            cv::resize(frame, frame, cv::Size(outputWidth, outputHeight));
-        }
+        // Frames are queued at their native resolution; the scan folds the
+        // resize to outputWidth x outputHeight into its plan
         
         // Simple approach: Add every frame to processing queue (like early webcam servers)
         {
@@ -338,12 +336,13 @@ void FileLPXServer::processingThread() {
         // Process the frame
         auto startTime = std::chrono::high_resolution_clock::now();
         
-        // Center the LPX scan at the center of the image with offsets
-        float centerX = frameToProcess.cols / 2.0f + centerXOffset;
-        float centerY = frameToProcess.rows / 2.0f + centerYOffset;
+        // Center the LPX scan at the center of the output image with offsets
+        float centerX = outputWidth / 2.0f + centerXOffset;
+        float centerY = outputHeight / 2.0f + centerYOffset;
         
-        // Use the existing multithreaded scanning function
-        auto lpxImage = multithreadedScanImage(frameToProcess, centerX, centerY);
+        // Scan the native RGB frame as if resized to the output size
+        auto lpxImage = scanEngine->scanResizedImage(frameToProcess, cv::Size(outputWidth, outputHeight),
+                                                     centerX, centerY, PIXEL_FORMAT_RGB);
         
         if (lpxImage) {
             // Add to broadcast queue
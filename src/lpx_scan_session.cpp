@@ -0,0 +1,234 @@
+/**
+ * lpx_scan_session.cpp
+ *
+ * Streaming scan: cells accumulate as bands of rows arrive
+ */
+
+#include "../include/lpx_scan_session.h"
+#include "../include/lpx_common.h"
+#include <algorithm>
+
+namespace lpx {
+
+LPXScanSession::LPXScanSession(std::shared_ptr<LPXTables> tables) {
+    if (tables && tables->isInitialized()) {
+        context = optimized::getDefaultScanContext(tables);
+    }
+}
+
+LPXScanSession::LPXScanSession(const optimized::ScanContext& context) : context(context) {
+}
+
+bool LPXScanSession::begin(LPXImage* image, int width, int height, int type, float x_center, float y_center,
+                           PixelFormat format, int firstCell, int lastCell) {
+    state = IDLE;
+    lpxImage = nullptr;
+    if (!image || !context.spans || !context.plans || image->getScanTables() != context.spans->sct) {
+        LOG_ERROR("LPXImage was not created with the scan tables of this scan session");
+        return false;
+    }
+    if (image->hasCellStatistics()) {
+        LOG_ERROR("Streaming scans do not gather cell statistics");
+        return false;
+    }
+    if (!optimized::describePackedFrame(width, height, type, format, frame)) {
+        LOG_ERROR(std::string("Streaming scans need a packed frame; cannot scan ") + getPixelFormatName(format));
+        return false;
+    }
+
+    lpxImage = image;
+    const int nMaxCells = lpxImage->getMaxCells();
+    auto& cellArray = lpxImage->accessCellArray();
+    cellArray.resize(nMaxCells);
+    precise = nullptr;
+    if (lpxImage->hasPreciseOutput()) {
+        lpxImage->accessPreciseCellArray().resize(3 * static_cast<size_t>(nMaxCells));
+        precise = lpxImage->accessPreciseCellArray().data();
+    }
+    lpxImage->setSize(width, height);
+    lpxImage->setPosition(x_center, y_center);
+
+    plan = context.plans->get(*context.spans, nMaxCells, frame, x_center, y_center, 0, firstCell, lastCell);
+    if (plan != foveaPlan) {
+        indexFoveaRows();
+    }
+    rowReceived.assign(scanEndRow - scanFirstRow, 0);
+    rowsPending = scanEndRow - scanFirstRow;
+
+    // Fovea cells with no pixel in the image stay empty
+    if (!plan->foveaCovered) {
+        std::fill(cellArray.begin() + plan->cellStart, cellArray.begin() + plan->foveaCells, 0u);
+        if (precise) {
+            std::fill(precise + 3 * plan->cellStart, precise + 3 * plan->foveaCells, 0.0f);
+        }
+    }
+    if (frame.depth != CV_8U) {
+        wideBuffer.resize(nMaxCells);
+        wideBuffer.clear(plan->cellStart, plan->cellEnd);
+    } else {
+        buffer.resize(nMaxCells);
+        buffer.clear(plan->cellStart, plan->cellEnd);
+    }
+
+    state = SCANNING;
+    if (rowsPending == 0) {
+        complete();  // Nothing of the frame lies under the scan
+    }
+    return true;
+}
+
+// Rows the plan reads, and its fovea pixels grouped by row. Only the last
+// table entry for each cell is kept: it is the one a whole-frame gather
+// leaves in place, and without the others arrival order does not matter.
+void LPXScanSession::indexFoveaRows() {
+    const std::vector<optimized::PlanFoveaPixel>& fovea = plan->fovea;
+    const int step = static_cast<int>(frame.step);
+
+    std::vector<char> cellSeen(lpxImage->getMaxCells(), 0);
+    std::vector<int> kept;
+    kept.reserve(fovea.size());
+    int firstRow = (plan->yMin < plan->yMax) ? plan->yMin : INT_MAX;
+    int endRow = (plan->yMin < plan->yMax) ? plan->yMax : 0;
+    for (int i = static_cast<int>(fovea.size()) - 1; i >= 0; i--) {
+        if (cellSeen[fovea[i].cell]) continue;
+        cellSeen[fovea[i].cell] = 1;
+        kept.push_back(i);
+        const int row = fovea[i].offset / step;
+        firstRow = std::min(firstRow, row);
+        endRow = std::max(endRow, row + 1);
+    }
+    scanFirstRow = std::min(firstRow, endRow);
+    scanEndRow = endRow;
+
+    // Counting sort by row, offsets made relative to the start of the row
+    foveaRowStart.assign(scanEndRow - scanFirstRow + 1, 0);
+    for (int i : kept) {
+        foveaRowStart[fovea[i].offset / step - scanFirstRow + 1]++;
+    }
+    for (size_t r = 1; r < foveaRowStart.size(); r++) {
+        foveaRowStart[r] += foveaRowStart[r - 1];
+    }
+    std::vector<int> next(foveaRowStart.begin(), foveaRowStart.end() - 1);
+    foveaByRow.resize(kept.size());
+    for (int i : kept) {
+        optimized::PlanFoveaPixel pixel = fovea[i];
+        pixel.offset %= step;
+        foveaByRow[next[fovea[i].offset / step - scanFirstRow]++] = pixel;
+    }
+    bandFovea.reserve(foveaByRow.size());
+    foveaPlan = plan;
+}
+
+bool LPXScanSession::pushRows(const uint8_t* rows, int firstRow, int nRows, size_t stride) {
+    if (state == IDLE || !rows || nRows < 0 || firstRow < 0 || firstRow + nRows > frame.height) {
+        return false;
+    }
+    if (stride == 0) {
+        stride = frame.step;
+    }
+    if (state == COMPLETE) {
+        return true;  // Later rows of a finished scan are not needed
+    }
+
+    // Scan each run of rows not received before
+    const int start = std::max(firstRow, scanFirstRow);
+    const int end = std::min(firstRow + nRows, scanEndRow);
+    int r = start;
+    while (r < end) {
+        if (rowReceived[r - scanFirstRow]) {
+            r++;
+            continue;
+        }
+        int runEnd = r;
+        while (runEnd < end && !rowReceived[runEnd - scanFirstRow]) {
+            rowReceived[runEnd - scanFirstRow] = 1;
+            runEnd++;
+        }
+        scanRows(rows, firstRow, stride, r, runEnd);
+        rowsPending -= runEnd - r;
+        r = runEnd;
+    }
+
+    if (rowsPending == 0) {
+        complete();
+    }
+    return true;
+}
+
+void LPXScanSession::scanRows(const uint8_t* rows, int bandFirstRow, size_t stride, int runStart, int runEnd) {
+    // The run as a frame of its own, starting at image row runStart
+    optimized::FrameLayout band = frame;
+    band.pixels = rows + (runStart - bandFirstRow) * stride;
+    band.step = stride;
+
+    const int yStart = std::max(runStart, plan->yMin);
+    const int yEnd = std::min(runEnd, plan->yMax);
+    if (yStart < yEnd) {
+        if (frame.depth != CV_8U) {
+            optimized::optimizedProcessImageBand(band, runStart, yStart, yEnd, *plan, wideBuffer);
+        } else {
+            optimized::optimizedProcessImageBand(band, runStart, yStart, yEnd, *plan, buffer);
+        }
+    }
+
+    bandFovea.clear();
+    for (int row = runStart; row < runEnd; row++) {
+        const int first = foveaRowStart[row - scanFirstRow];
+        const int last = foveaRowStart[row - scanFirstRow + 1];
+        const int rowOffset = static_cast<int>((row - runStart) * stride);
+        for (int i = first; i < last; i++) {
+            optimized::PlanFoveaPixel pixel = foveaByRow[i];
+            pixel.offset += rowOffset;
+            bandFovea.push_back(pixel);
+        }
+    }
+    if (!bandFovea.empty()) {
+        optimized::gatherFoveaPixels(band, bandFovea.data(), static_cast<int>(bandFovea.size()),
+                                     lpxImage->accessCellArray(), precise);
+    }
+}
+
+bool LPXScanSession::finish() {
+    if (state == IDLE) {
+        return false;
+    }
+    if (state == SCANNING) {
+        complete();
+    }
+    return true;
+}
+
+void LPXScanSession::complete() {
+    auto& cellArray = lpxImage->accessCellArray();
+    const int nMaxCells = lpxImage->getMaxCells();
+    const int cellStart = plan->cellStart;
+    const int cellEnd = plan->cellEnd;
+    const int lastFoveaIndex = context.spans->sct->lastFoveaIndex;
+    const bool rainbowMode = optimized::isRainbowModeEnabled();
+
+    if (frame.depth != CV_8U) {
+        optimized::mergeCellRange(&wideBuffer, 1, cellStart, cellEnd, lastFoveaIndex, frame.depth,
+                                  rainbowMode, cellArray, precise);
+    } else {
+        optimized::mergeCellRange(&buffer, 1, cellStart, cellEnd, lastFoveaIndex, false,
+                                  rainbowMode, cellArray, precise);
+    }
+
+    // Cells outside a partial scan's range are left empty
+    std::fill(cellArray.begin(), cellArray.begin() + cellStart, 0u);
+    std::fill(cellArray.begin() + cellEnd, cellArray.end(), 0u);
+    if (precise) {
+        std::fill(precise, precise + 3 * cellStart, 0.0f);
+        std::fill(precise + 3 * cellEnd, precise + 3 * nMaxCells, 0.0f);
+    }
+    lpxImage->setLength(nMaxCells);
+    if (lpxImage->hasOpponentOutput()) {
+        lpxImage->updateOpponentCells();
+    }
+
+    state = COMPLETE;
+    lpxImage = nullptr;
+    precise = nullptr;
+}
+
+} // namespace lpx
@@ -0,0 +1,461 @@
+/**
+ * lpx_table_file.cpp
+ *
+ * Writing, mapping and loading of versioned scan-table files
+ */
+
+#include "../include/lpx_table_file.h"
+#include "../include/lpx_optimized.h"
+#include "../include/lpx_common.h"
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cmath>    // For std::lround
+#include <cstdio>   // For std::rename, std::remove
+#include <cstdlib>  // For getenv
+#include <cstring>
+#include <fstream>
+#include <thread>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/file.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace lpx {
+
+// Element size of each section, in TableFileSection order
+static const size_t sectionElementSize[TABLE_SECTION_COUNT] = {
+    sizeof(int32_t), sizeof(int32_t), sizeof(PositionPair), sizeof(int32_t), sizeof(int64_t),
+    sizeof(int32_t), sizeof(int32_t), sizeof(optimized::MapSpan), sizeof(int32_t), sizeof(int32_t)
+};
+
+static uint64_t fnv1a64(const uint8_t* data, size_t n, uint64_t hash = 14695981039346656037ull) {
+    for (size_t i = 0; i < n; i++) {
+        hash = (hash ^ data[i]) * 1099511628211ull;
+    }
+    return hash;
+}
+
+static uint32_t fnv1a32(const uint8_t* data, size_t n) {
+    uint32_t hash = 2166136261u;
+    for (size_t i = 0; i < n; i++) {
+        hash = (hash ^ data[i]) * 16777619u;
+    }
+    return hash;
+}
+
+static uint32_t headerChecksum(TableFileHeader header) {
+    header.headerChecksum = 0;
+    return fnv1a32(reinterpret_cast<const uint8_t*>(&header), sizeof(header));
+}
+
+static bool envFlag(const char* name) {
+    const char* env_var = std::getenv(name);
+    return env_var != nullptr && (std::string(env_var) == "1" || std::string(env_var) == "true");
+}
+
+// The header describes sections that lie inside the file and agree with
+// the table sizes, so no view can reach past the mapping
+static bool isValidHeader(const TableFileHeader& header, size_t fileSize) {
+    if (header.headerSize != sizeof(TableFileHeader) || header.fileSize != fileSize ||
+        header.headerChecksum != headerChecksum(header)) {
+        return false;
+    }
+    for (int s = 0; s < TABLE_SECTION_COUNT; s++) {
+        const TableFileSectionInfo& info = header.sections[s];
+        if (info.offset < sizeof(TableFileHeader) || info.offset % TABLE_FILE_ALIGNMENT != 0 ||
+            info.offset > fileSize || info.count > (fileSize - info.offset) / sectionElementSize[s]) {
+            return false;
+        }
+    }
+    const TableFileSectionInfo* sections = header.sections;
+    return header.mapWidth > 0 && header.length > 0 && header.innerLength >= 0 && header.lastFoveaIndex >= 0 &&
+           sections[TABLE_SECTION_OUTER_PIXEL_INDEX].count == static_cast<uint64_t>(header.length) &&
+           sections[TABLE_SECTION_OUTER_PIXEL_CELL].count == static_cast<uint64_t>(header.length) &&
+           sections[TABLE_SECTION_INNER_CELLS].count == static_cast<uint64_t>(header.innerLength) &&
+           sections[TABLE_SECTION_ROW_FIRST_RUN].count == static_cast<uint64_t>(header.mapWidth) + 1 &&
+           sections[TABLE_SECTION_CELL_REACH].count == sections[TABLE_SECTION_CELL_AREA].count &&
+           sections[TABLE_SECTION_CELL_SPAN_START].count == sections[TABLE_SECTION_CELL_AREA].count + 1 &&
+           sections[TABLE_SECTION_CELL_INNER_START].count == static_cast<uint64_t>(header.lastFoveaIndex) + 2;
+}
+
+// Validate a mapping the file has taken ownership of
+static std::shared_ptr<LPXTableFile> adoptMapping(std::shared_ptr<LPXTableFile> file, const std::string& name,
+                                                  bool verify) {
+    const TableFileHeader& header = file->header();
+    if (header.magic != TABLE_FILE_MAGIC || header.version != TABLE_FILE_VERSION) {
+        LOG_ERROR("Table file " + name + " is not a version " + std::to_string(TABLE_FILE_VERSION) +
+                  " table file");
+        return nullptr;
+    }
+    if (!isValidHeader(header, file->mappedSize())) {
+        LOG_ERROR("Table file " + name + " has a corrupt header");
+        return nullptr;
+    }
+    // The index start arrays must end at their sections' counts
+    const int* spanStart = file->section<int>(TABLE_SECTION_CELL_SPAN_START);
+    const int* innerStart = file->section<int>(TABLE_SECTION_CELL_INNER_START);
+    if (static_cast<uint64_t>(spanStart[file->sectionCount(TABLE_SECTION_CELL_SPAN_START) - 1]) !=
+            header.sections[TABLE_SECTION_CELL_SPANS].count ||
+        static_cast<uint64_t>(innerStart[file->sectionCount(TABLE_SECTION_CELL_INNER_START) - 1]) !=
+            header.sections[TABLE_SECTION_CELL_INNER].count) {
+        LOG_ERROR("Table file " + name + " has a corrupt cell index");
+        return nullptr;
+    }
+    if (verify && !file->verifyPayload()) {
+        LOG_ERROR("Table file " + name + " does not match its checksum");
+        return nullptr;
+    }
+    return file;
+}
+
+static void adviseHugePages(void* base, size_t size, bool hugePages) {
+#ifdef MADV_HUGEPAGE
+    if (hugePages) {
+        madvise(base, size, MADV_HUGEPAGE);  // Advisory; ignored where the kernel cannot use huge pages here
+    }
+#else
+    (void)base;
+    (void)size;
+    (void)hugePages;
+#endif
+}
+
+std::shared_ptr<const LPXTableFile> LPXTableFile::open(const std::string& filename, bool hugePages,
+                                                       bool verify) {
+    const int fd = ::open(filename.c_str(), O_RDONLY);
+    if (fd < 0) {
+        LOG_ERROR("Cannot open table file " + filename);
+        return nullptr;
+    }
+    struct stat info;
+    if (fstat(fd, &info) != 0 || info.st_size < static_cast<off_t>(sizeof(TableFileHeader))) {
+        ::close(fd);
+        LOG_ERROR("Table file " + filename + " is too short");
+        return nullptr;
+    }
+    const size_t size = static_cast<size_t>(info.st_size);
+    void* base = mmap(nullptr, size, PROT_READ, MAP_SHARED, fd, 0);
+    ::close(fd);  // The mapping keeps the file open
+    if (base == MAP_FAILED) {
+        LOG_ERROR("Cannot map table file " + filename);
+        return nullptr;
+    }
+    adviseHugePages(base, size, hugePages);
+
+    std::shared_ptr<LPXTableFile> file(new LPXTableFile());
+    file->base = base;
+    file->size = size;
+    return adoptMapping(file, filename, verify);
+}
+
+// Longest wait for another process to publish a shared segment
+static const int SHARED_PUBLISH_TIMEOUT_SECONDS = 30;
+
+// A segment another process has finished publishing
+static bool isPublished(int fd) {
+    struct stat info;
+    if (fstat(fd, &info) != 0 || info.st_size < static_cast<off_t>(sizeof(TableFileHeader))) {
+        return false;
+    }
+    TableFileHeader header;
+    if (pread(fd, &header, sizeof(header), 0) != static_cast<ssize_t>(sizeof(header))) {
+        return false;
+    }
+    return header.magic == TABLE_FILE_MAGIC && header.version == TABLE_FILE_VERSION &&
+           isValidHeader(header, static_cast<size_t>(info.st_size));
+}
+
+// Size the segment and copy the image in, header last, so that a process
+// dying part way leaves a segment that is not published
+static bool publishSegment(int fd, const std::vector<uint8_t>& image) {
+    if (ftruncate(fd, 0) != 0 || ftruncate(fd, static_cast<off_t>(image.size())) != 0) {
+        return false;
+    }
+    void* target = mmap(nullptr, image.size(), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if (target == MAP_FAILED) {
+        return false;
+    }
+    uint8_t* bytes = static_cast<uint8_t*>(target);
+    std::memcpy(bytes + sizeof(TableFileHeader), image.data() + sizeof(TableFileHeader),
+                image.size() - sizeof(TableFileHeader));
+    std::memcpy(bytes, image.data(), sizeof(TableFileHeader));
+    munmap(target, image.size());
+    return true;
+}
+
+std::shared_ptr<const LPXTableFile> LPXTableFile::openShared(
+        const std::string& name, const std::function<bool(std::vector<uint8_t>&)>& build,
+        bool hugePages, bool verify) {
+    bool writable = true;
+    int fd = shm_open(name.c_str(), O_RDWR | O_CREAT, 0644);
+    if (fd < 0 && errno == EACCES) {
+        writable = false;  // Published by another user: attach only
+        fd = shm_open(name.c_str(), O_RDONLY, 0);
+    }
+    if (fd < 0) {
+        LOG_ERROR("Cannot open shared tables " + name);
+        return nullptr;
+    }
+    // From here the file owns fd, so every return releases it
+    std::shared_ptr<LPXTableFile> file(new LPXTableFile());
+    file->sharedFd = fd;
+    file->sharedName = name;
+
+    // Hold a shared lock on a published segment. Publishing takes the lock
+    // exclusively, which fails while others hold it; they let go and retry
+    // until the publisher is done, rather than block with theirs held.
+    const auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(SHARED_PUBLISH_TIMEOUT_SECONDS);
+    std::chrono::milliseconds delay(1);
+    for (;;) {
+        if (flock(fd, LOCK_SH) != 0) {
+            LOG_ERROR("Cannot lock shared tables " + name);
+            return nullptr;
+        }
+        if (isPublished(fd)) {
+            break;
+        }
+        if (!writable) {
+            LOG_ERROR("Shared tables " + name + " are not published and cannot be written");
+            return nullptr;
+        }
+        if (flock(fd, LOCK_EX | LOCK_NB) == 0) {
+            if (!isPublished(fd)) {
+                std::vector<uint8_t> image;
+                if (!build(image) || image.size() < sizeof(TableFileHeader) || !publishSegment(fd, image)) {
+                    LOG_ERROR("Cannot publish shared tables " + name);
+                    return nullptr;
+                }
+                LOG_INFO("Published shared tables " + name);
+            }
+            continue;  // Back to a shared lock
+        }
+        flock(fd, LOCK_UN);
+        if (std::chrono::steady_clock::now() > deadline) {
+            LOG_ERROR("Timed out waiting for shared tables " + name + " to be published");
+            return nullptr;
+        }
+        std::this_thread::sleep_for(delay);
+        delay = std::min(delay * 2, std::chrono::milliseconds(50));
+    }
+
+    struct stat info;
+    if (fstat(fd, &info) != 0) {
+        LOG_ERROR("Cannot read the size of shared tables " + name);
+        return nullptr;
+    }
+    const size_t size = static_cast<size_t>(info.st_size);
+    void* base = mmap(nullptr, size, PROT_READ, MAP_SHARED, fd, 0);
+    if (base == MAP_FAILED) {
+        LOG_ERROR("Cannot map shared tables " + name);
+        return nullptr;
+    }
+    adviseHugePages(base, size, hugePages);
+    file->base = base;
+    file->size = size;
+    return adoptMapping(file, name, verify);
+}
+
+std::string getSharedTableName(int mapWidth, float spiralPer) {
+    return "/lpx-tables-" + std::to_string(mapWidth) + "-" +
+           std::to_string(static_cast<int>(std::lround(spiralPer * 10.0f)));
+}
+
+LPXTableFile::~LPXTableFile() {
+    if (base) {
+        munmap(const_cast<void*>(base), size);
+    }
+    if (sharedFd >= 0) {
+        // Only the last process attached can take the lock exclusively
+        if (flock(sharedFd, LOCK_EX | LOCK_NB) == 0) {
+            shm_unlink(sharedName.c_str());
+        }
+        ::close(sharedFd);
+    }
+}
+
+bool LPXTableFile::verifyPayload() const {
+    const uint8_t* bytes = static_cast<const uint8_t*>(base);
+    return fnv1a64(bytes + sizeof(TableFileHeader), size - sizeof(TableFileHeader)) == header().payloadChecksum;
+}
+
+bool isTableFile(const std::string& filename) {
+    std::ifstream file(filename, std::ios::binary);
+    uint32_t magic = 0;
+    return file.read(reinterpret_cast<char*>(&magic), sizeof(magic)) && magic == TABLE_FILE_MAGIC;
+}
+
+// The whole file in memory: header, then each section aligned
+bool buildTableFileImage(const std::shared_ptr<LPXTables>& tables, std::vector<uint8_t>& image) {
+    if (!tables || !tables->isInitialized()) {
+        return false;
+    }
+
+    // Derived structures built afresh, so they never view another file
+    optimized::ScanSpanTable spans;
+    optimized::CellSpanIndex index;
+    spans.initialize(tables);
+    index.initialize(tables);
+
+    TableFileHeader header;
+    std::memset(&header, 0, sizeof(header));
+    header.magic = TABLE_FILE_MAGIC;
+    header.version = TABLE_FILE_VERSION;
+    header.headerSize = sizeof(TableFileHeader);
+    header.mapWidth = tables->mapWidth;
+    header.spiralPer = tables->spiralPer;
+    header.length = tables->length;
+    header.innerLength = tables->innerLength;
+    header.lastFoveaIndex = tables->lastFoveaIndex;
+    header.lastCellIndex = tables->lastCellIndex;
+    header.spiralCells = index.spiralCells;
+    header.spiralRadius = index.spiralRadius;
+
+    const void* data[TABLE_SECTION_COUNT] = {
+        tables->outerPixelIndex.data(), tables->outerPixelCellIdx.data(), tables->innerCells.data(),
+        spans.rowFirstRun.data(), spans.cellArea.data(), spans.cellReach.data(),
+        index.cellSpanStart.data(), index.cellSpans.data(), index.cellInnerStart.data(), index.cellInner.data()
+    };
+    const size_t counts[TABLE_SECTION_COUNT] = {
+        tables->outerPixelIndex.size(), tables->outerPixelCellIdx.size(), tables->innerCells.size(),
+        spans.rowFirstRun.size(), spans.cellArea.size(), spans.cellReach.size(),
+        index.cellSpanStart.size(), index.cellSpans.size(), index.cellInnerStart.size(), index.cellInner.size()
+    };
+
+    image.assign(sizeof(TableFileHeader), 0);
+    for (int s = 0; s < TABLE_SECTION_COUNT; s++) {
+        const size_t offset = (image.size() + TABLE_FILE_ALIGNMENT - 1) / TABLE_FILE_ALIGNMENT * TABLE_FILE_ALIGNMENT;
+        const size_t bytes = counts[s] * sectionElementSize[s];
+        header.sections[s].offset = offset;
+        header.sections[s].count = counts[s];
+        image.resize(offset + bytes, 0);
+        if (bytes > 0) {
+            std::memcpy(image.data() + offset, data[s], bytes);
+        }
+    }
+    header.fileSize = image.size();
+    header.payloadChecksum = fnv1a64(image.data() + sizeof(TableFileHeader), image.size() - sizeof(TableFileHeader));
+    header.headerChecksum = headerChecksum(header);
+    std::memcpy(image.data(), &header, sizeof(header));
+    return true;
+}
+
+bool writeTableFile(const std::shared_ptr<LPXTables>& tables, const std::string& filename) {
+    std::vector<uint8_t> image;
+    if (!buildTableFileImage(tables, image)) {
+        return false;
+    }
+
+    const std::string temporary = filename + ".tmp";
+    {
+        std::ofstream file(temporary, std::ios::binary | std::ios::trunc);
+        if (!file.write(reinterpret_cast<const char*>(image.data()), image.size())) {
+            LOG_ERROR("Cannot write table file " + temporary);
+            file.close();
+            std::remove(temporary.c_str());
+            return false;
+        }
+    }
+    if (std::rename(temporary.c_str(), filename.c_str()) != 0) {
+        LOG_ERROR("Cannot rename " + temporary + " to " + filename);
+        std::remove(temporary.c_str());
+        return false;
+    }
+    return true;
+}
+
+// Tables whose arrays view a mapped table file. LPX_TABLE_HUGEPAGES=1 asks
+// for huge-page backing and LPX_TABLE_VERIFY=1 checks the payload checksum.
+bool LPXTables::loadTableFile(const std::string& filename) {
+    std::shared_ptr<const LPXTableFile> file =
+        LPXTableFile::open(filename, envFlag("LPX_TABLE_HUGEPAGES"), envFlag("LPX_TABLE_VERIFY"));
+    return file && adoptTableFile(file);
+}
+
+// What the shared segment for a scan table file is checked against
+struct SharedTableKey {
+    int mapWidth;
+    float spiralPer;
+    int length;
+    int innerLength;
+    int lastFoveaIndex;
+    int lastCellIndex;
+};
+
+static bool readTableKey(const std::string& filename, SharedTableKey& key) {
+    std::ifstream file(filename, std::ios::binary);
+    if (isTableFile(filename)) {
+        TableFileHeader header;
+        if (!file.read(reinterpret_cast<char*>(&header), sizeof(header))) {
+            return false;
+        }
+        key = {header.mapWidth, header.spiralPer, header.length, header.innerLength,
+               header.lastFoveaIndex, header.lastCellIndex};
+    } else {
+        // totalLength, mapWidth, spiral period less 0.5, then the lengths
+        int values[7];
+        if (!file.read(reinterpret_cast<char*>(values), sizeof(values))) {
+            return false;
+        }
+        key = {values[1], static_cast<float>(values[2]) + 0.5f, values[3], values[4], values[5], values[6]};
+    }
+    return key.mapWidth > 0;
+}
+
+// Tables whose arrays view the shared segment for their map width and
+// spiral period, published from filename by the first process to load it
+bool LPXTables::loadShared(const std::string& filename) {
+    tableFile.reset();
+    SharedTableKey key{};
+    if (!readTableKey(filename, key)) {
+        LOG_ERROR("Cannot read scan table file " + filename);
+        return false;
+    }
+
+    const std::string name = getSharedTableName(key.mapWidth, key.spiralPer);
+    auto build = [&filename](std::vector<uint8_t>& image) {
+        std::shared_ptr<LPXTables> tables = std::make_shared<LPXTables>("");
+        return tables->loadPrivate(filename) && buildTableFileImage(tables, image);
+    };
+    std::shared_ptr<const LPXTableFile> file =
+        LPXTableFile::openShared(name, build, envFlag("LPX_TABLE_HUGEPAGES"), envFlag("LPX_TABLE_VERIFY"));
+    if (!file) {
+        return false;
+    }
+    // Other tables with the same key may have published the segment
+    const TableFileHeader& header = file->header();
+    if (header.mapWidth != key.mapWidth || header.spiralPer != key.spiralPer || header.length != key.length ||
+        header.innerLength != key.innerLength || header.lastFoveaIndex != key.lastFoveaIndex ||
+        header.lastCellIndex != key.lastCellIndex) {
+        LOG_ERROR("Shared tables " + name + " were published from other scan tables than " + filename);
+        return false;
+    }
+    return adoptTableFile(file);
+}
+
+bool LPXTables::adoptTableFile(const std::shared_ptr<const LPXTableFile>& file) {
+    const TableFileHeader& header = file->header();
+    mapWidth = header.mapWidth;
+    spiralPer = (header.spiralPer < 0.1f || header.spiralPer > 1000.0f) ? 63.5f : header.spiralPer;
+    length = header.length;
+    innerLength = header.innerLength;
+    lastFoveaIndex = header.lastFoveaIndex;
+    lastCellIndex = header.lastCellIndex;
+
+    outerPixelIndex.view(file->section<int>(TABLE_SECTION_OUTER_PIXEL_INDEX), length, file);
+    outerPixelCellIdx.view(file->section<int>(TABLE_SECTION_OUTER_PIXEL_CELL), length, file);
+    innerCells.view(file->section<PositionPair>(TABLE_SECTION_INNER_CELLS), innerLength, file);
+    tableFile = file;
+
+    initialized = true;
+    return true;
+}
+
+bool LPXTables::isShared() const {
+    return tableFile && tableFile->isShared();
+}
+
+} // namespace lpx
@@ -0,0 +1,211 @@
+/**
+ * lpx_table_generator.cpp
+ *
+ * Generation of scan tables for any spiral period and map size
+ */
+
+#include "../include/lpx_image.h"
+#include "../include/lpx_table_file.h"
+#include "../include/lpx_optimized.h"
+#include "../include/lpx_common.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>  // For getenv
+#include <vector>
+
+namespace lpx {
+
+// The fovea is every whole turn of the spiral that starts with cells of
+// less than this many pixels. Such cells are too small to average the
+// pixels under them, so each is sampled at the pixel under its center.
+static const double FOVEA_CELL_AREA = 2.0;
+
+// Map pixel index of the sentinel run that ends outerPixelIndex
+static const int MAP_END_SENTINEL = 1000000000;
+
+// Rows of the map each generator task covers
+static const int GENERATOR_BAND_ROWS = 64;
+
+// Index of the cell containing map point (x, y). This is getXCellIndex in
+// double precision and rounding down rather than toward zero, as the
+// shipped tables were generated, so that the ray at angle zero belongs to
+// the cells below it. There is no radius bound, since every map point
+// must be given its cell.
+static int getMapCellIndex(double x, double y, double spiralPer) {
+    if (x == 0 && y == 0) {
+        return 0;
+    }
+
+    const double radius = std::sqrt(x * x + y * y);
+    const double angle = std::atan2(y, x);
+
+    const double pitch = 1.0 / spiralPer;
+    const double pitchAng = 0.99999999 * 2.0 * M_PI * pitch;  // Fixup for round off error
+    const double invPitchAng = 1.0 / pitchAng;
+
+    const double ang = (angle < 0.0) ? angle + 2.0 * M_PI : angle;  // Map angles to range 0 to 2 PI
+
+    const double arg = ang * invPitchAng;
+    const double j = 2 * arg - 0.0000001;  // Offset the angle enough that the low boundary is included in the cell
+    const double sv_A_pitch_1 = M_PI * std::sqrt(3.0) * pitch + 1;
+
+    const int iPer = static_cast<int>(std::floor(
+        ((4.0 * M_PI * std::log(radius / 0.455) / std::log(sv_A_pitch_1) * invPitchAng) - j) * pitch * 0.5));
+    const int iPer_2_spiralPer = static_cast<int>(iPer * 2 * spiralPer);
+    const int iCell_2 = iPer_2_spiralPer + static_cast<int>(std::floor(j));  // Half-period index
+
+    const double absAng = 0.5 * (iPer_2_spiralPer + j) * pitchAng;
+    const double ang1 = 0.5 * iCell_2 * pitchAng;  // Absolute ang1 on half-cell boundaries
+    const double r1 = 0.455 * std::pow(sv_A_pitch_1, absAng / (2.0 * M_PI));  // Radius through center of cell at ang
+    const double r2 = r1 * sv_A_pitch_1;  // Radius through center of cells at next spiral period
+    const double s_2 = (r2 - r1) / 3.0;
+
+    int iCell = static_cast<int>(std::floor(iCell_2 / 2.0));  // Index of bounding cell
+    const bool upperHalf = (iCell_2 % 2) != 0;
+
+    const double dr = radius - r1;  // The part of radius within r1 to r2
+    const double da = absAng - ang1;  // The part of ang in the half-cell with lower bound ang1
+
+    if (dr < s_2) {  // Region 1
+        return iCell;
+    }
+    if (dr < 2.0 * s_2) {
+        const double width = M_PI * pitch;
+        const double bound = width * (dr - s_2) / s_2;
+        if (upperHalf) {
+            return (da >= width - bound) ? iCell + static_cast<int>(spiralPer) + 1 : iCell;  // Region 4 or 3
+        }
+        return (da < bound) ? iCell + static_cast<int>(spiralPer) : iCell;  // Region 5 or 2
+    }
+    return upperHalf ? iCell + static_cast<int>(spiralPer) + 1 : iCell + static_cast<int>(spiralPer);
+}
+
+// Last cell of the fovea: the cells of spiral turn t have their centers at
+// t * spiralPer - 0.5 onwards
+static int getGeneratedLastFoveaIndex(double spiralPer) {
+    const double growth = M_PI * std::sqrt(3.0) / spiralPer + 1;  // Radius ratio of one turn
+    const double areaFactor = M_PI * (growth * growth - 1) / spiralPer;  // Cell area over radius squared
+    int turn = 0;
+    double radius = 0.455;
+    while (areaFactor * radius * radius < FOVEA_CELL_AREA) {
+        turn++;
+        radius *= growth;
+    }
+    return std::max(0, static_cast<int>(std::ceil(turn * spiralPer - 0.5)) - 1);  // At least the center cell
+}
+
+// Runs of one band of map rows: an entry where the cell changes from the
+// previous pixel, and one for every pixel of a fovea cell
+struct GeneratedBand {
+    std::vector<int> pixelIndex;
+    std::vector<int> cellIndex;
+};
+
+static void generateBand(int firstRow, int endRow, int mapWidth, double spiralPer, int lastFoveaIndex,
+                         GeneratedBand& band) {
+    const int half = mapWidth / 2;
+    auto mapCell = [&](int row, int col) {
+        const int cell = getMapCellIndex(col - half, row - half, spiralPer);
+        return std::max(cell, lastFoveaIndex);
+    };
+
+    band.pixelIndex.clear();
+    band.cellIndex.clear();
+    int previous = (firstRow > 0) ? mapCell(firstRow - 1, mapWidth - 1) : -1;
+    for (int row = firstRow; row < endRow; row++) {
+        for (int col = 0; col < mapWidth; col++) {
+            const int raw = getMapCellIndex(col - half, row - half, spiralPer);
+            const int cell = std::max(raw, lastFoveaIndex);
+            if (cell != previous || raw < lastFoveaIndex) {
+                band.pixelIndex.push_back(row * mapWidth + col);
+                band.cellIndex.push_back(cell);
+            }
+            previous = cell;
+        }
+    }
+}
+
+bool LPXTables::generate(float spiralPeriod, int width) {
+    if (spiralPeriod < 1.0f || spiralPeriod > 1000.0f || width < 2 ||
+        static_cast<long long>(width) * width >= MAP_END_SENTINEL) {
+        LOG_ERROR("Cannot generate scan tables with spiral period " + std::to_string(spiralPeriod) +
+                  " and map width " + std::to_string(width));
+        return false;
+    }
+    // Scan table files keep the whole periods; the spiral is offset by half a cell
+    const float period = std::floor(spiralPeriod) + 0.5f;
+
+    // LPX_TABLE_CACHE names a directory of table files already generated
+    std::string cachePath;
+    const char* env_var = std::getenv("LPX_TABLE_CACHE");
+    if (env_var && *env_var) {
+        cachePath = std::string(env_var) + "/ScanTables-" + std::to_string(width) + "-" +
+                    std::to_string(static_cast<int>(period)) + ".lpxt";
+        if (isTableFile(cachePath) && loadTableFile(cachePath) && mapWidth == width && spiralPer == period) {
+            return true;
+        }
+    }
+
+    tableFile.reset();
+    initialized = false;
+    mapWidth = width;
+    spiralPer = period;
+    lastFoveaIndex = getGeneratedLastFoveaIndex(period);
+
+    // Row bands in parallel, each starting from the cell of the pixel before it
+    const int numBands = (width + GENERATOR_BAND_ROWS - 1) / GENERATOR_BAND_ROWS;
+    std::vector<GeneratedBand> bands(numBands);
+    {
+        optimized::ScanThreadPool& pool = optimized::getScanThreadPool();
+        std::unique_lock<std::mutex> poolLock = pool.acquire();
+        auto generateTask = [&](int task, int) {
+            const int firstRow = task * GENERATOR_BAND_ROWS;
+            generateBand(firstRow, std::min(firstRow + GENERATOR_BAND_ROWS, width), width, period,
+                         lastFoveaIndex, bands[task]);
+        };
+        pool.parallelFor(numBands, generateTask);
+    }
+
+    size_t total = 1;  // The sentinel
+    for (const GeneratedBand& band : bands) {
+        total += band.pixelIndex.size();
+    }
+    outerPixelIndex.resize(total);
+    outerPixelCellIdx.resize(total);
+    size_t next = 0;
+    for (const GeneratedBand& band : bands) {
+        std::copy(band.pixelIndex.begin(), band.pixelIndex.end(), outerPixelIndex.ownedData() + next);
+        std::copy(band.cellIndex.begin(), band.cellIndex.end(), outerPixelCellIdx.ownedData() + next);
+        next += band.pixelIndex.size();
+    }
+    outerPixelIndex.ownedData()[next] = MAP_END_SENTINEL;
+    outerPixelCellIdx.ownedData()[next] = -1;
+    length = static_cast<int>(total);
+    lastCellIndex = outerPixelCellIdx[next - 1];  // The cell at the last pixel of the map
+
+    // Fovea cells are sampled at the pixel under their centers
+    const double pitchAng = 0.99999999 * 2.0 * M_PI / period;
+    const double growth = M_PI * std::sqrt(3.0) / period + 1;
+    const int half = width / 2;
+    innerLength = lastFoveaIndex + 1;
+    innerCells.resize(innerLength);
+    PositionPair* cells = innerCells.ownedData();
+    for (int i = 0; i < innerLength; i++) {
+        const double ang = (i + 0.5) * pitchAng;
+        const double radius = 0.455 * std::pow(growth, ang / (2.0 * M_PI));
+        cells[i].x = half + static_cast<int>(std::floor(radius * std::cos(ang)));
+        cells[i].y = half + static_cast<int>(std::floor(radius * std::sin(ang)));
+    }
+    initialized = true;
+
+    if (!cachePath.empty()) {
+        // Aliasing pointer that does not own the tables, for writeTableFile
+        std::shared_ptr<LPXTables> self(std::shared_ptr<LPXTables>(), this);
+        if (!writeTableFile(self, cachePath)) {
+            LOG_WARNING("Cannot cache generated scan tables in " + cachePath);
+        }
+    }
+    return true;
+}
+
+} // namespace lpx
@@ -269,6 +269,11 @@ void LPXVision::fillVisionCells(LPXVision* lpR, LPXImage* lpImage) {
     // Access private members via friend class - match JavaScript variable names and calculations exactly
     int spPer = static_cast<int>(std::floor(lpImage->spiralPer));
     std::vector<uint32_t>& cellArray = lpImage->cellArray;
+    // Opponent-colour planes filled by the scan, when it was asked for them
+    const lpx::LPXOpponentCells* opponent = nullptr;
+    if (lpImage->opponentOutput && lpImage->opponentCells.luminance.size() == cellArray.size()) {
+        opponent = &lpImage->opponentCells;
+    }
     int foveaPeriods = static_cast<int>(std::floor(spPer * 0.1));  // Match JavaScript: Math.floor(spPer * 0.1)
     int foveaOfs = spPer * foveaPeriods;
     int viewlength = lpR->viewlength;
@@ -293,12 +298,13 @@ void LPXVision::fillVisionCells(LPXVision* lpR, LPXImage* lpImage) {
     
     // Initialize arrays - match JavaScript array sizes exactly
     std::vector<double> mwh(comparelen + mwhOfs);
-    std::vector<double> mgr(comparelen + viewOfs);
-    std::vector<double> myb(comparelen + viewOfs);
+    // Loop 2 writes mgr, myb and hue at mwhOfs-based indexes
+    std::vector<double> mgr(comparelen + mwhOfs);
+    std::vector<double> myb(comparelen + mwhOfs);
     std::vector<double> mwh_x(comparelen + mwhOfs);
     std::vector<double> mwh_y(comparelen + mwhOfs);
     std::vector<double> mwh_z(comparelen + mwhOfs);
-    std::vector<double> hue(comparelen + viewOfs);
+    std::vector<double> hue(comparelen + mwhOfs);
     
     int i, j, k, n;
     double diff, wht;
@@ -310,7 +316,7 @@ void LPXVision::fillVisionCells(LPXVision* lpR, LPXImage* lpImage) {
     for (i = 0; i < mwhOfs; i++) {
         int cellIdx = i + foveaOfs - mwhOfs;
         if (cellIdx >= 0 && cellIdx < static_cast<int>(cellArray.size())) {
-            mwh[i] = lpImage->extractCellLuminance(cellArray[cellIdx]);
+            mwh[i] = opponent ? opponent->luminance[cellIdx] : lpImage->extractCellLuminance(cellArray[cellIdx]);
             // Debug output removed
         } else {
             mwh[i] = 0;
@@ -347,7 +353,7 @@ void LPXVision::fillVisionCells(LPXVision* lpR, LPXImage* lpImage) {
         }
         
         // The monochrome identifier in the range 0 to 1023
-        mwh[j] = lpImage->extractCellLuminance(cellArray[k]);
+        mwh[j] = opponent ? opponent->luminance[k] : lpImage->extractCellLuminance(cellArray[k]);
         
         // Range check removed
         
@@ -368,8 +374,13 @@ void LPXVision::fillVisionCells(LPXVision* lpR, LPXImage* lpImage) {
         
         setCellBits(n, lpR->retinaCells, i, NUM_IDENTIFIER_BITS);
         
-        mgr[j] = lpImage->extractCellGreenRed(cellArray[k]); // green-red identifier in the range -1024 to 1023
-        myb[j] = lpImage->extractCellYellowBlue(cellArray[k]); // yellow-blue identifier in the range -1024 to 1023
+        if (opponent) {
+            mgr[j] = opponent->greenRed[k];
+            myb[j] = opponent->yellowBlue[k];
+        } else {
+            mgr[j] = lpImage->extractCellGreenRed(cellArray[k]); // green-red identifier in the range -1024 to 1023
+            myb[j] = lpImage->extractCellYellowBlue(cellArray[k]); // yellow-blue identifier in the range -1024 to 1023
+        }
         
         hue[j] = getColorAngle(myb[j], mgr[j], ANG0); // Generate color1 angle in range 0 to 2PI
         
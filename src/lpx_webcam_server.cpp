@@ -161,6 +161,7 @@ WebcamLPXServer::WebcamLPXServer(const std::string& scanTableFile, int port)
         throw std::runtime_error("Failed to initialize scan tables from: " + scanTableFile);
     }
 
+    scanEngine = std::make_shared<LPXScanEngine>(scanTables);
     g_scanTables = scanTables;
 }
 
@@ -388,7 +389,7 @@ void WebcamLPXServer::processingThread() {
         float centerY = frameToProcess.rows / 2.0f + centerYOffset;
         
         // Use the existing multithreaded scanning function
-        auto lpxImage = multithreadedScanImage(frameToProcess, centerX, centerY);
+        auto lpxImage = scanEngine->scanImage(frameToProcess, centerX, centerY);
         
         if (lpxImage) {
             // Add to broadcast queue
@@ -0,0 +1,922 @@
+// main_scan_benchmark.cpp
+#include "../include/lpx_image.h"
+#include "../include/lpx_mt.h"
+#include "../include/lpx_optimized.h"
+#include "../include/lpx_engine.h"
+#include "../include/lpx_scan_session.h"
+#include "../include/lpx_delta_scan.h"
+#include "../include/lpx_common.h"
+#include <iostream>
+#include <iomanip>
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <new>
+#include <string>
+#include <thread>
+#include <cstdlib>
+#include <vector>
+
+using namespace lpx;
+
+// Heap allocations made through operator new (by any thread), counted for the
+// "alloc" benchmark
+static std::atomic<long long> g_allocations(0);
+
+void* operator new(std::size_t size) {
+    g_allocations++;
+    if (void* p = std::malloc(size ? size : 1)) return p;
+    throw std::bad_alloc();
+}
+void operator delete(void* p) noexcept { std::free(p); }
+void operator delete(void* p, std::size_t) noexcept { std::free(p); }
+
+// Deterministic test frame: gradients with some noise so cells differ
+static cv::Mat makeTestFrame(int width, int height) {
+    cv::Mat frame(height, width, CV_8UC3);
+    unsigned int seed = 12345;
+    for (int y = 0; y < height; y++) {
+        uchar* row = frame.ptr<uchar>(y);
+        for (int x = 0; x < width; x++) {
+            seed = seed * 1103515245u + 12345u;
+            const int noise = (seed >> 16) & 15;
+            row[3 * x + 0] = static_cast<uchar>((x * 255 / width + noise) & 0xFF);
+            row[3 * x + 1] = static_cast<uchar>((y * 255 / height + noise) & 0xFF);
+            row[3 * x + 2] = static_cast<uchar>(((x + y) & 0xFF) ^ noise);
+        }
+    }
+    return frame;
+}
+
+// Average milliseconds per scan of frame at its center
+static double timeScan(const cv::Mat& frame, int iterations) {
+    const float centerX = frame.cols / 2.0f;
+    const float centerY = frame.rows / 2.0f;
+
+    // Warm-up scan (builds lookup structures)
+    multithreadedScanImage(frame, centerX, centerY);
+
+    auto start = std::chrono::high_resolution_clock::now();
+    for (int i = 0; i < iterations; i++) {
+        multithreadedScanImage(frame, centerX, centerY);
+    }
+    auto end = std::chrono::high_resolution_clock::now();
+
+    return std::chrono::duration<double, std::milli>(end - start).count() / iterations;
+}
+
+// Scan time and speed-up for 1..N scan threads
+static void benchmarkThreads(const cv::Mat& frame, int iterations) {
+    const unsigned int maxThreads = std::max(1u, std::thread::hardware_concurrency());
+
+    std::cout << "Thread scaling (" << frame.cols << "x" << frame.rows << ", "
+              << iterations << " iterations, " << maxThreads << " hardware threads)" << std::endl;
+    std::cout << std::setw(8) << "threads" << std::setw(12) << "ms/frame"
+              << std::setw(10) << "fps" << std::setw(10) << "speedup" << std::endl;
+
+    double baseline = 0.0;
+    for (unsigned int t = 1; t <= maxThreads; t++) {
+        optimized::setScanThreadCount(t);
+        const double ms = timeScan(frame, iterations);
+        if (t == 1) baseline = ms;
+
+        std::cout << std::setw(8) << t
+                  << std::setw(12) << std::fixed << std::setprecision(3) << ms
+                  << std::setw(10) << std::setprecision(1) << (1000.0 / ms)
+                  << std::setw(10) << std::setprecision(2) << (baseline / ms) << std::endl;
+    }
+    optimized::setScanThreadCount(0);
+}
+
+// Per-frame scan cost for each span kernel supported by this CPU
+static void benchmarkKernels(const cv::Mat& frame, int iterations) {
+    const optimized::ScanKernel kernels[] = {
+        optimized::SCAN_KERNEL_SCALAR, optimized::SCAN_KERNEL_SSE41,
+        optimized::SCAN_KERNEL_AVX2, optimized::SCAN_KERNEL_NEON
+    };
+    const optimized::ScanKernel selected = optimized::getScanKernel();
+
+    std::cout << "Span kernels (" << frame.cols << "x" << frame.rows << ", "
+              << iterations << " iterations, " << optimized::getScanThreadCount() << " threads)" << std::endl;
+    std::cout << std::setw(8) << "kernel" << std::setw(12) << "ms/frame"
+              << std::setw(10) << "fps" << std::setw(10) << "speedup" << std::endl;
+
+    double baseline = 0.0;
+    for (optimized::ScanKernel kernel : kernels) {
+        if (!optimized::setScanKernel(kernel)) continue;
+        const double ms = timeScan(frame, iterations);
+        if (kernel == optimized::SCAN_KERNEL_SCALAR) baseline = ms;
+
+        std::cout << std::setw(8) << optimized::getScanKernelName(kernel)
+                  << std::setw(12) << std::fixed << std::setprecision(3) << ms
+                  << std::setw(10) << std::setprecision(1) << (1000.0 / ms)
+                  << std::setw(10) << std::setprecision(2) << (baseline / ms) << std::endl;
+    }
+    optimized::setScanKernel(selected);
+}
+
+// Steady-state scans with a cached plan versus rebuilding the plan every frame
+static void benchmarkPlans(const cv::Mat& frame, int iterations) {
+    optimized::ScanPlanCache& cache = optimized::getScanPlanCache();
+    const size_t capacity = cache.capacity();
+
+    std::cout << "Scan plans (" << frame.cols << "x" << frame.rows << ", "
+              << iterations << " iterations)" << std::endl;
+    std::cout << std::setw(8) << "plan" << std::setw(12) << "ms/frame"
+              << std::setw(10) << "fps" << std::setw(10) << "speedup" << std::endl;
+
+    double baseline = 0.0;
+    for (int cached = 0; cached <= 1; cached++) {
+        cache.clear();
+        cache.setCapacity(cached ? std::max<size_t>(capacity, 1) : 0);
+        const double ms = timeScan(frame, iterations);
+        if (!cached) baseline = ms;
+
+        std::cout << std::setw(8) << (cached ? "cached" : "rebuilt")
+                  << std::setw(12) << std::fixed << std::setprecision(3) << ms
+                  << std::setw(10) << std::setprecision(1) << (1000.0 / ms)
+                  << std::setw(10) << std::setprecision(2) << (baseline / ms) << std::endl;
+    }
+    cache.setCapacity(capacity);
+}
+
+// Resizing to 1920x1080 before scanning versus folding the resize into the scan
+static void benchmarkResize(const cv::Mat& frame, int iterations) {
+    const cv::Size outputSize(1920, 1080);
+    const float centerX = outputSize.width / 2.0f;
+    const float centerY = outputSize.height / 2.0f;
+
+    std::cout << "Resize to " << outputSize.width << "x" << outputSize.height << " (source "
+              << frame.cols << "x" << frame.rows << ", " << iterations << " iterations)" << std::endl;
+    std::cout << std::setw(8) << "mode" << std::setw(12) << "ms/frame"
+              << std::setw(10) << "fps" << std::setw(10) << "speedup" << std::endl;
+
+    double baseline = 0.0;
+    for (int fused = 0; fused <= 1; fused++) {
+        auto scanOnce = [&]() {
+            if (fused) {
+                multithreadedScanResizedImage(frame, outputSize, centerX, centerY);
+            } else {
+                cv::Mat resized;
+                cv::resize(frame, resized, outputSize, 0, 0, cv::INTER_AREA);
+                multithreadedScanImage(resized, centerX, centerY);
+            }
+        };
+
+        scanOnce();  // Warm-up (builds the scan plan)
+        auto start = std::chrono::high_resolution_clock::now();
+        for (int i = 0; i < iterations; i++) {
+            scanOnce();
+        }
+        auto end = std::chrono::high_resolution_clock::now();
+        const double ms = std::chrono::duration<double, std::milli>(end - start).count() / iterations;
+        if (!fused) baseline = ms;
+
+        std::cout << std::setw(8) << (fused ? "fused" : "resize")
+                  << std::setw(12) << std::fixed << std::setprecision(3) << ms
+                  << std::setw(10) << std::setprecision(1) << (1000.0 / ms)
+                  << std::setw(10) << std::setprecision(2) << (baseline / ms) << std::endl;
+    }
+}
+
+// Candidate fixations scanned one at a time versus in a single multi-fixation pass
+static void benchmarkMulti(const cv::Mat& frame, int iterations) {
+    const int counts[] = { 1, 2, 5, 10, 20 };
+    optimized::ScanPlanCache& cache = optimized::getScanPlanCache();
+    const size_t capacity = cache.capacity();
+    cache.setCapacity(std::max<size_t>(capacity, 20));  // Keep every candidate's plan
+
+    // Candidates spread over the middle half of the frame, like a saccade search
+    std::vector<cv::Point2f> candidates;
+    for (int i = 0; i < 20; i++) {
+        candidates.emplace_back(frame.cols * (0.25f + 0.5f * ((i * 7) % 20) / 19.0f),
+                                frame.rows * (0.25f + 0.5f * ((i * 13) % 20) / 19.0f));
+    }
+
+    std::cout << "Multi-fixation scan (" << frame.cols << "x" << frame.rows << ", "
+              << iterations << " iterations)" << std::endl;
+    std::cout << std::setw(8) << "centers" << std::setw(12) << "separate" << std::setw(12) << "single"
+              << std::setw(10) << "speedup" << std::setw(12) << "ms/center" << std::endl;
+
+    for (int n : counts) {
+        const std::vector<cv::Point2f> centers(candidates.begin(), candidates.begin() + n);
+        double ms[2];
+        for (int multi = 0; multi <= 1; multi++) {
+            auto scanOnce = [&]() {
+                if (multi) {
+                    scanMultiple(frame, centers);
+                } else {
+                    for (const cv::Point2f& center : centers) {
+                        multithreadedScanImage(frame, center.x, center.y);
+                    }
+                }
+            };
+
+            scanOnce();  // Warm-up (builds the scan plans)
+            auto start = std::chrono::high_resolution_clock::now();
+            for (int i = 0; i < iterations; i++) {
+                scanOnce();
+            }
+            auto end = std::chrono::high_resolution_clock::now();
+            ms[multi] = std::chrono::duration<double, std::milli>(end - start).count() / iterations;
+        }
+
+        std::cout << std::setw(8) << n
+                  << std::setw(12) << std::fixed << std::setprecision(3) << ms[0]
+                  << std::setw(12) << ms[1]
+                  << std::setw(10) << std::setprecision(2) << (ms[0] / ms[1])
+                  << std::setw(12) << std::setprecision(3) << (ms[1] / n) << std::endl;
+    }
+    cache.setCapacity(capacity);
+}
+
+// Pixels the scan sums for a plan (fovea pixels plus every span of every level)
+static long long countPlanPixels(const optimized::ScanPlan& plan) {
+    long long pixels = static_cast<long long>(plan.fovea.size());
+    for (const optimized::PlanSpan& span : plan.spans) pixels += span.count;
+    for (const optimized::ScanPlanLevel& level : plan.coarseLevels) {
+        for (const optimized::PlanSpan& span : level.spans) pixels += span.count;
+    }
+    return pixels;
+}
+
+// Pyramid scans with 1..4 levels against the exact scan: time (with the
+// pyramid built per frame, and for an already built pyramid), pixels summed
+// and the error of the cell colours
+static void benchmarkPyramid(const cv::Mat& frame, int iterations) {
+    const float centerX = frame.cols / 2.0f;
+    const float centerY = frame.rows / 2.0f;
+
+    std::shared_ptr<LPXImage> exact = multithreadedScanImage(frame, centerX, centerY);
+    optimized::FrameLayout layout;
+    optimized::describeFrame(frame, PIXEL_FORMAT_AUTO, layout);
+
+    std::cout << "Pyramid scan (" << frame.cols << "x" << frame.rows << ", "
+              << iterations << " iterations)" << std::endl;
+    std::cout << std::setw(8) << "levels" << std::setw(12) << "ms/frame" << std::setw(10) << "speedup"
+              << std::setw(12) << "prebuilt" << std::setw(12) << "pixels" << std::setw(10) << "mean err" << std::setw(10) << "max err" << std::endl;
+
+    double baseline = 0.0;
+    for (int levels = 0; levels <= 4; levels++) {
+        auto scanOnce = [&]() {
+            return levels ? multithreadedScanImagePyramid(frame, centerX, centerY, levels)
+                          : multithreadedScanImage(frame, centerX, centerY);
+        };
+
+        std::shared_ptr<LPXImage> result = scanOnce();  // Warm-up (builds the scan plan)
+        auto start = std::chrono::high_resolution_clock::now();
+        for (int i = 0; i < iterations; i++) {
+            scanOnce();
+        }
+        auto end = std::chrono::high_resolution_clock::now();
+        const double ms = std::chrono::duration<double, std::milli>(end - start).count() / iterations;
+        if (levels == 0) baseline = ms;
+
+        // Scan alone, on a pyramid built once
+        std::vector<cv::Mat> pyramid;
+        optimized::buildScanPyramid(frame, levels, pyramid);
+        start = std::chrono::high_resolution_clock::now();
+        for (int i = 0; i < iterations; i++) {
+            optimized::optimizedPyramidScan(result.get(), pyramid, centerX, centerY);
+        }
+        end = std::chrono::high_resolution_clock::now();
+        const double prebuiltMs = std::chrono::duration<double, std::milli>(end - start).count() / iterations;
+
+        // Per-channel difference from the exact scan over all cells
+        double totalError = 0.0;
+        int maxError = 0;
+        for (int i = 0; i < exact->getLength(); i++) {
+            const uint32_t a = exact->getCellValue(i);
+            const uint32_t b = result->getCellValue(i);
+            for (int shift = 0; shift < 24; shift += 8) {
+                const int diff = std::abs(static_cast<int>((a >> shift) & 0xFF) - static_cast<int>((b >> shift) & 0xFF));
+                totalError += diff;
+                maxError = std::max(maxError, diff);
+            }
+        }
+
+        auto plan = optimized::getScanPlan(*result, layout, centerX, centerY, levels);
+        std::cout << std::setw(8) << levels
+                  << std::setw(12) << std::fixed << std::setprecision(3) << ms
+                  << std::setw(10) << std::setprecision(2) << (baseline / ms)
+                  << std::setw(12) << std::setprecision(3) << prebuiltMs
+                  << std::setw(12) << countPlanPixels(*plan)
+                  << std::setw(10) << std::setprecision(3) << totalError / (3.0 * exact->getLength())
+                  << std::setw(10) << maxError << std::endl;
+    }
+}
+
+// Partial scans over growing cell ranges against the full scan: time and
+// pixels summed should follow the area the range covers
+static void benchmarkCells(const cv::Mat& frame, int iterations) {
+    const float centerX = frame.cols / 2.0f;
+    const float centerY = frame.rows / 2.0f;
+    const int nMaxCells = g_scanTables->lastCellIndex + 1;
+    const int foveaCells = g_scanTables->lastFoveaIndex + 1;
+    const int ringCells = static_cast<int>(g_scanTables->spiralPer + 0.5f);
+
+    optimized::FrameLayout layout;
+    optimized::describeFrame(frame, PIXEL_FORMAT_AUTO, layout);
+    const optimized::ScanContext& context = optimized::getDefaultScanContext(g_scanTables);
+
+    std::cout << "Cell range scan (" << frame.cols << "x" << frame.rows << ", "
+              << iterations << " iterations)" << std::endl;
+    std::cout << std::setw(10) << "first" << std::setw(10) << "last" << std::setw(12) << "ms/frame"
+              << std::setw(10) << "speedup" << std::setw(12) << "pixels" << std::endl;
+
+    const int ranges[][2] = {
+        {0, nMaxCells}, {0, foveaCells}, {0, foveaCells + 8 * ringCells},
+        {foveaCells + 8 * ringCells, foveaCells + 16 * ringCells}, {nMaxCells - 8 * ringCells, nMaxCells}
+    };
+    double baseline = 0.0;
+    for (const auto& range : ranges) {
+        multithreadedScanCellRange(frame, centerX, centerY, range[0], range[1]);  // Warm-up (builds the scan plan)
+        auto start = std::chrono::high_resolution_clock::now();
+        for (int i = 0; i < iterations; i++) {
+            multithreadedScanCellRange(frame, centerX, centerY, range[0], range[1]);
+        }
+        auto end = std::chrono::high_resolution_clock::now();
+        const double ms = std::chrono::duration<double, std::milli>(end - start).count() / iterations;
+        if (baseline == 0.0) baseline = ms;
+
+        auto plan = context.plans->get(*context.spans, nMaxCells, layout, centerX, centerY, 0, range[0], range[1]);
+        std::cout << std::setw(10) << range[0] << std::setw(10) << range[1]
+                  << std::setw(12) << std::fixed << std::setprecision(3) << ms
+                  << std::setw(10) << std::setprecision(2) << (baseline / ms)
+                  << std::setw(12) << countPlanPixels(*plan) << std::endl;
+    }
+}
+
+// Cells spread evenly over the retina, as a probe sampling the whole field would pick
+static std::vector<int> makeProbeCells(int count) {
+    const int nMaxCells = g_scanTables->lastCellIndex + 1;
+    std::vector<int> cells;
+    for (int i = 0; i < count && i < nMaxCells; i++) {
+        cells.push_back(static_cast<int>(static_cast<int64_t>(i) * nMaxCells / std::min(count, nMaxCells)));
+    }
+    return cells;
+}
+
+// Scans of a list of cells against the full scan: time should follow the
+// area of the listed cells
+static void benchmarkSparse(const cv::Mat& frame, int iterations) {
+    const float centerX = frame.cols / 2.0f;
+    const float centerY = frame.rows / 2.0f;
+    const int nMaxCells = g_scanTables->lastCellIndex + 1;
+    LPXImage lpxImage(g_scanTables, frame.cols, frame.rows);
+
+    std::cout << "Sparse cell scan (" << frame.cols << "x" << frame.rows << ", "
+              << iterations << " iterations)" << std::endl;
+    std::cout << std::setw(10) << "cells" << std::setw(12) << "ms/frame" << std::setw(10) << "speedup" << std::endl;
+
+    multithreadedScanImage(frame, centerX, centerY);  // Warm-up (builds the scan plan)
+    auto start = std::chrono::high_resolution_clock::now();
+    for (int i = 0; i < iterations; i++) {
+        multithreadedScanImage(frame, centerX, centerY);
+    }
+    auto end = std::chrono::high_resolution_clock::now();
+    const double baseline = std::chrono::duration<double, std::milli>(end - start).count() / iterations;
+    std::cout << std::setw(10) << "full" << std::setw(12) << std::fixed << std::setprecision(3) << baseline
+              << std::setw(10) << std::setprecision(2) << 1.0 << std::endl;
+
+    for (int count : {16, 64, 256, 1024, nMaxCells}) {
+        const std::vector<int> cells = makeProbeCells(count);
+        optimized::optimizedScanCells(&lpxImage, frame, centerX, centerY, cells.data(),
+                                      static_cast<int>(cells.size()));  // Warm-up (builds the index)
+        start = std::chrono::high_resolution_clock::now();
+        for (int i = 0; i < iterations; i++) {
+            optimized::optimizedScanCells(&lpxImage, frame, centerX, centerY, cells.data(),
+                                          static_cast<int>(cells.size()));
+        }
+        end = std::chrono::high_resolution_clock::now();
+        const double ms = std::chrono::duration<double, std::milli>(end - start).count() / iterations;
+        std::cout << std::setw(10) << cells.size() << std::setw(12) << std::setprecision(3) << ms
+                  << std::setw(10) << std::setprecision(2) << (baseline / ms) << std::endl;
+    }
+}
+
+// 16-bit and float frames scanned natively against converting them to 8-bit
+// first, with the 8-bit scan of the same content as the baseline
+static void benchmarkDepth(const cv::Mat& frame, int iterations) {
+    const float centerX = frame.cols / 2.0f;
+    const float centerY = frame.rows / 2.0f;
+
+    cv::Mat frame16, frame32;
+    frame.convertTo(frame16, CV_16U, 257.0);
+    frame.convertTo(frame32, CV_32F, 1.0 / 255.0);
+
+    std::cout << "Deep frame scan (" << frame.cols << "x" << frame.rows << ", "
+              << iterations << " iterations)" << std::endl;
+    std::cout << std::setw(16) << "input" << std::setw(12) << "ms/frame" << std::setw(12) << "precise" << std::endl;
+
+    LPXImage lpxImage(g_scanTables, frame.cols, frame.rows);
+    auto timeScans = [&](const std::function<void()>& scan) {
+        scan();  // Warm-up (builds the scan plan)
+        auto start = std::chrono::high_resolution_clock::now();
+        for (int i = 0; i < iterations; i++) {
+            scan();
+        }
+        auto end = std::chrono::high_resolution_clock::now();
+        return std::chrono::duration<double, std::milli>(end - start).count() / iterations;
+    };
+    auto report = [&](const char* name, const std::function<void()>& scan) {
+        lpxImage.setPreciseOutput(false);
+        const double ms = timeScans(scan);
+        lpxImage.setPreciseOutput(true);
+        const double preciseMs = timeScans(scan);
+        std::cout << std::setw(16) << name << std::setw(12) << std::fixed << std::setprecision(3) << ms
+                  << std::setw(12) << preciseMs << std::endl;
+    };
+
+    report("8-bit", [&]() { scanInto(lpxImage, frame, centerX, centerY); });
+    report("16-bit", [&]() { scanInto(lpxImage, frame16, centerX, centerY); });
+    report("16-bit convert", [&]() {
+        cv::Mat converted;
+        frame16.convertTo(converted, CV_8U, 1.0 / 257.0);
+        scanInto(lpxImage, converted, centerX, centerY);
+    });
+    report("float", [&]() { scanInto(lpxImage, frame32, centerX, centerY); });
+    report("float convert", [&]() {
+        cv::Mat converted;
+        frame32.convertTo(converted, CV_8U, 255.0);
+        scanInto(lpxImage, converted, centerX, centerY);
+    });
+}
+
+// Cost of gathering per-cell variance, minimum and maximum in the scan,
+// against a plain scan followed by a second pass over the pixels of each cell
+static void benchmarkStatistics(const cv::Mat& frame, int iterations) {
+    const float centerX = frame.cols / 2.0f;
+    const float centerY = frame.rows / 2.0f;
+
+    cv::Mat frame16;
+    frame.convertTo(frame16, CV_16U, 257.0);
+
+    std::cout << "Cell statistics (" << frame.cols << "x" << frame.rows << ", "
+              << iterations << " iterations)" << std::endl;
+    std::cout << std::setw(10) << "input" << std::setw(12) << "plain" << std::setw(12) << "stats"
+              << std::setw(12) << "two-pass" << std::endl;
+
+    LPXImage lpxImage(g_scanTables, frame.cols, frame.rows);
+    LPXCellStatistics secondPass;
+    auto timeScans = [&](const std::function<void()>& scan) {
+        scan();  // Warm-up (builds the scan plan)
+        auto start = std::chrono::high_resolution_clock::now();
+        for (int i = 0; i < iterations; i++) {
+            scan();
+        }
+        auto end = std::chrono::high_resolution_clock::now();
+        return std::chrono::duration<double, std::milli>(end - start).count() / iterations;
+    };
+    // The separate pass downstream code did before: walk every span again
+    auto walkCells = [&](const cv::Mat& image) {
+        optimized::FrameLayout layout;
+        optimized::describeFrame(image, PIXEL_FORMAT_AUTO, layout);
+        auto plan = optimized::getScanPlan(lpxImage, layout, centerX, centerY);
+        const int nMaxCells = lpxImage.getMaxCells();
+        optimized::StatsAccumulatorBuffer stats;
+        stats.resize(nMaxCells);
+        secondPass.variance.resize(3 * nMaxCells);
+        secondPass.minimum.resize(3 * nMaxCells);
+        secondPass.maximum.resize(3 * nMaxCells);
+        if (layout.depth == CV_8U) {
+            optimized::AccumulatorBuffer sums;
+            sums.resize(nMaxCells);
+            sums.clear();
+            optimized::optimizedProcessImageRegion(layout, plan->yMin, plan->yMax, *plan, sums, stats);
+            optimized::mergeCellStatistics(&sums, &stats, 1, 0, nMaxCells, g_scanTables->lastFoveaIndex, secondPass);
+        } else {
+            optimized::WideAccumulatorBuffer sums;
+            sums.resize(nMaxCells);
+            sums.clear();
+            optimized::optimizedProcessImageRegion(layout, plan->yMin, plan->yMax, *plan, sums, stats);
+            optimized::mergeCellStatistics(&sums, &stats, 1, 0, nMaxCells, g_scanTables->lastFoveaIndex, secondPass);
+        }
+    };
+    auto report = [&](const char* name, const cv::Mat& image) {
+        lpxImage.setCellStatistics(false);
+        const double plainMs = timeScans([&]() { scanInto(lpxImage, image, centerX, centerY); });
+        const double twoPassMs = timeScans([&]() {
+            scanInto(lpxImage, image, centerX, centerY);
+            walkCells(image);
+        });
+        lpxImage.setCellStatistics(true);
+        const double statsMs = timeScans([&]() { scanInto(lpxImage, image, centerX, centerY); });
+        std::cout << std::setw(10) << name << std::setw(12) << std::fixed << std::setprecision(3) << plainMs
+                  << std::setw(12) << statsMs << std::setw(12) << twoPassMs << std::endl;
+    };
+
+    report("8-bit", frame);
+    report("16-bit", frame16);
+}
+
+// Streaming scans fed 16-row bands against scanning the finished frame, and
+// how much of the frame has to arrive before the streamed result is ready
+static void benchmarkStream(const cv::Mat& frame, int iterations) {
+    const int bandRows = 16;
+    const int foveaCells = g_scanTables->lastFoveaIndex + 1;
+    const int ringCells = static_cast<int>(g_scanTables->spiralPer + 0.5f);
+
+    std::cout << "Streaming scan (" << frame.cols << "x" << frame.rows << ", " << bandRows << "-row bands, "
+              << iterations << " iterations)" << std::endl;
+    std::cout << std::setw(10) << "center y" << std::setw(10) << "last" << std::setw(12) << "frame ms"
+              << std::setw(12) << "stream ms" << std::setw(12) << "ready at" << std::endl;
+
+    LPXImage lpxImage(g_scanTables, frame.cols, frame.rows);
+    LPXScanSession session(g_scanTables);
+    const float centerX = frame.cols / 2.0f;
+    const float centersY[] = { frame.rows / 8.0f, frame.rows / 2.0f };
+    const int lastCells[] = { INT_MAX, foveaCells + 8 * ringCells };
+    for (float centerY : centersY) {
+        for (int lastCell : lastCells) {
+            auto timeScans = [&](const std::function<void()>& scan) {
+                scan();  // Warm-up (builds the scan plan)
+                auto start = std::chrono::high_resolution_clock::now();
+                for (int i = 0; i < iterations; i++) {
+                    scan();
+                }
+                auto end = std::chrono::high_resolution_clock::now();
+                return std::chrono::duration<double, std::milli>(end - start).count() / iterations;
+            };
+            const double frameMs = timeScans([&]() {
+                optimized::optimizedMultithreadedScan(&lpxImage, frame, centerX, centerY,
+                                                      PIXEL_FORMAT_AUTO, cv::Size(), 0, lastCell);
+            });
+            int readyRow = 0;
+            const double streamMs = timeScans([&]() {
+                session.begin(&lpxImage, frame.cols, frame.rows, frame.type(), centerX, centerY,
+                              PIXEL_FORMAT_AUTO, 0, lastCell);
+                for (int row = 0; row < frame.rows && !session.isComplete(); row += bandRows) {
+                    const int n = std::min(bandRows, frame.rows - row);
+                    session.pushRows(frame.ptr(row), row, n, frame.step);
+                    readyRow = row + n;
+                }
+            });
+            std::cout << std::setw(10) << std::fixed << std::setprecision(0) << centerY
+                      << std::setw(10) << (lastCell == INT_MAX ? std::string("all") : std::to_string(lastCell))
+                      << std::setw(12) << std::setprecision(3) << frameMs << std::setw(12) << streamMs
+                      << std::setw(11) << std::setprecision(0) << (100.0 * readyRow / frame.rows) << "%" << std::endl;
+        }
+    }
+}
+
+// Delta scans of a static frame with a moving square of growing size, against
+// full scans of the same frames. The square moves by its own width each frame,
+// so every frame changes twice its area.
+static void benchmarkDelta(const cv::Mat& frame, int iterations) {
+    std::cout << "Delta scan (" << frame.cols << "x" << frame.rows << ", "
+              << LPXDeltaScanner::DEFAULT_TILE_SIZE << "-pixel tiles, " << iterations << " iterations)" << std::endl;
+    std::cout << std::setw(10) << "square" << std::setw(10) << "changed" << std::setw(12) << "full ms"
+              << std::setw(12) << "delta ms" << std::setw(10) << "speedup" << std::setw(8) << "same" << std::endl;
+
+    const float centerX = frame.cols / 2.0f;
+    const float centerY = frame.rows / 2.0f;
+    LPXImage full(g_scanTables, frame.cols, frame.rows);
+    LPXImage delta(g_scanTables, frame.cols, frame.rows);
+    const int squares[] = { 0, 16, 64, 256 };
+    for (int square : squares) {
+        // Frames cycling through the square's positions along the middle row
+        const int positions = std::max(1, square > 0 ? frame.cols / square : 1);
+        std::vector<cv::Mat> frames;
+        unsigned int seed = 7;
+        for (int i = 0; i < std::min(positions, 8); i++) {
+            cv::Mat f = frame.clone();
+            for (int y = (frame.rows - square) / 2; y < (frame.rows + square) / 2 && square > 0; y++) {
+                uchar* row = f.ptr<uchar>(y);
+                for (int x = 3 * i * square; x < 3 * (i + 1) * square; x++) {
+                    seed = seed * 1103515245u + 12345u;
+                    row[x] = static_cast<uchar>(seed >> 16);
+                }
+            }
+            frames.push_back(f);
+        }
+
+        LPXDeltaScanner scanner(g_scanTables);
+        scanner.scan(&delta, frames[0], centerX, centerY);  // Warm-up (full scan)
+        optimized::optimizedMultithreadedScan(&full, frames[0], centerX, centerY);
+
+        bool same = true;
+        int64_t changedTiles = 0;
+        double fullMs = 0.0, deltaMs = 0.0;
+        for (int i = 0; i < iterations; i++) {
+            const cv::Mat& f = frames[(i + 1) % frames.size()];
+            auto start = std::chrono::high_resolution_clock::now();
+            optimized::optimizedMultithreadedScan(&full, f, centerX, centerY);
+            auto mid = std::chrono::high_resolution_clock::now();
+            scanner.scan(&delta, f, centerX, centerY);
+            auto end = std::chrono::high_resolution_clock::now();
+            fullMs += std::chrono::duration<double, std::milli>(mid - start).count();
+            deltaMs += std::chrono::duration<double, std::milli>(end - mid).count();
+            changedTiles += scanner.getChangedTileCount();
+            same = same && full.accessCellArray() == delta.accessCellArray();
+        }
+
+        std::cout << std::setw(10) << square
+                  << std::setw(9) << std::fixed << std::setprecision(1)
+                  << (100.0 * changedTiles / (static_cast<double>(iterations) * scanner.getTileCount())) << "%"
+                  << std::setw(12) << std::setprecision(3) << fullMs / iterations
+                  << std::setw(12) << deltaMs / iterations
+                  << std::setw(10) << std::setprecision(2) << fullMs / deltaMs
+                  << std::setw(8) << (same ? "yes" : "NO") << std::endl;
+    }
+}
+
+// Throughput of frame-at-a-time scans (each split across the threads) versus
+// scanBatch (one whole frame per thread) for 1..N scan threads
+static void benchmarkBatch(const cv::Mat& frame, int iterations) {
+    const unsigned int maxThreads = std::max(1u, std::thread::hardware_concurrency());
+    const std::vector<cv::Mat> frames(std::max(iterations, 1), frame);
+    const std::vector<cv::Point2f> centers(1, cv::Point2f(frame.cols / 2.0f, frame.rows / 2.0f));
+
+    std::cout << "Batch scan (" << frame.cols << "x" << frame.rows << ", " << frames.size()
+              << " frames, " << maxThreads << " hardware threads)" << std::endl;
+    std::cout << std::setw(8) << "threads" << std::setw(12) << "frame fps" << std::setw(12) << "batch fps"
+              << std::setw(10) << "speedup" << std::setw(10) << "scaling" << std::endl;
+
+    double batchBaseline = 0.0;
+    for (unsigned int t = 1; t <= maxThreads; t++) {
+        optimized::setScanThreadCount(t);
+        scanBatch(frames, centers);  // Warm-up (builds the scan plan)
+
+        auto start = std::chrono::high_resolution_clock::now();
+        for (const cv::Mat& f : frames) {
+            multithreadedScanImage(f, centers[0].x, centers[0].y);
+        }
+        auto mid = std::chrono::high_resolution_clock::now();
+        scanBatch(frames, centers);
+        auto end = std::chrono::high_resolution_clock::now();
+
+        const double frameFps = frames.size() / std::chrono::duration<double>(mid - start).count();
+        const double batchFps = frames.size() / std::chrono::duration<double>(end - mid).count();
+        if (t == 1) batchBaseline = batchFps;
+
+        std::cout << std::setw(8) << t
+                  << std::setw(12) << std::fixed << std::setprecision(1) << frameFps
+                  << std::setw(12) << batchFps
+                  << std::setw(10) << std::setprecision(2) << (batchFps / frameFps)
+                  << std::setw(10) << (batchFps / batchBaseline) << std::endl;
+    }
+    optimized::setScanThreadCount(0);
+}
+
+// Heap allocations per frame of steady-state streaming scans, after one
+// warm-up frame has built the plan and filled the pools. Returns false if a
+// pooled or scan-into path still allocates.
+static bool benchmarkAllocations(const cv::Mat& frame, int iterations) {
+    const float centerX = frame.cols / 2.0f;
+    const float centerY = frame.rows / 2.0f;
+    auto engine = std::make_shared<LPXScanEngine>(g_scanTables);
+    LPXImage reused(g_scanTables, frame.cols, frame.rows);
+    LPXScanSession session(g_scanTables);
+    LPXDeltaScanner deltaScanner(g_scanTables);
+    const std::vector<int> probeCells = makeProbeCells(256);
+
+    struct Mode {
+        const char* name;
+        bool mustNotAllocate;
+        std::function<void()> scan;
+    };
+    const Mode modes[] = {
+        { "fresh", false, [&]() {
+            auto lpxImage = std::make_shared<LPXImage>(g_scanTables, frame.cols, frame.rows);
+            multithreadedScanFromImage(lpxImage.get(), frame, centerX, centerY);
+        } },
+        { "into", true, [&]() { scanInto(reused, frame, centerX, centerY); } },
+        { "pooled", true, [&]() { multithreadedScanImage(frame, centerX, centerY); } },
+        { "engine", true, [&]() { engine->scanImage(frame, centerX, centerY); } },
+        { "e-into", true, [&]() { engine->scanInto(reused, frame, centerX, centerY); } },
+        { "pyramid", true, [&]() { multithreadedScanImagePyramid(frame, centerX, centerY, 2); } },
+        { "delta", true, [&]() { deltaScanner.scan(&reused, frame, centerX, centerY); } },
+        { "cells", true, [&]() {
+            optimized::optimizedScanCells(&reused, frame, centerX, centerY, probeCells.data(),
+                                          static_cast<int>(probeCells.size()));
+        } },
+        { "stream", true, [&]() {
+            session.begin(&reused, frame.cols, frame.rows, frame.type(), centerX, centerY);
+            for (int row = 0; row < frame.rows; row += 16) {
+                session.pushRows(frame.ptr(row), row, std::min(16, frame.rows - row), frame.step);
+            }
+        } },
+    };
+
+    std::cout << "Allocations (" << frame.cols << "x" << frame.rows << ", "
+              << iterations << " iterations)" << std::endl;
+    std::cout << std::setw(8) << "mode" << std::setw(12) << "ms/frame" << std::setw(12) << "allocs" << std::endl;
+
+    bool allocationFree = true;
+    for (const Mode& mode : modes) {
+        mode.scan();  // Warm-up (builds the scan plan, fills the pools)
+        const long long before = g_allocations;
+        auto start = std::chrono::high_resolution_clock::now();
+        for (int i = 0; i < iterations; i++) {
+            mode.scan();
+        }
+        auto end = std::chrono::high_resolution_clock::now();
+        const double allocs = static_cast<double>(g_allocations - before) / iterations;
+        if (mode.mustNotAllocate && allocs > 0) allocationFree = false;
+
+        std::cout << std::setw(8) << mode.name
+                  << std::setw(12) << std::fixed << std::setprecision(3)
+                  << std::chrono::duration<double, std::milli>(end - start).count() / iterations
+                  << std::setw(12) << std::setprecision(2) << allocs << std::endl;
+    }
+
+    if (!allocationFree) {
+        std::cerr << "Steady-state scans allocated" << std::endl;
+    }
+    return allocationFree;
+}
+
+// Cells of the points of a map mapWidth pixels square, one row at a time
+// through getXCellIndices and one point at a time through getXCellIndex.
+// Returns the number that differ.
+static long long countBatchMismatches(int mapWidth, float spiralPer) {
+    const int half = mapWidth / 2;
+    std::vector<float> xs(mapWidth), ys(mapWidth);
+    std::vector<int> cells(mapWidth);
+    for (int col = 0; col < mapWidth; col++) {
+        xs[col] = static_cast<float>(col - half);
+    }
+    long long mismatches = 0;
+    for (int row = 0; row < mapWidth; row++) {
+        std::fill(ys.begin(), ys.end(), static_cast<float>(row - half));
+        getXCellIndices(xs.data(), ys.data(), mapWidth, spiralPer, cells.data());
+        for (int col = 0; col < mapWidth; col++) {
+            if (cells[col] != getXCellIndex(xs[col], ys[col], spiralPer)) mismatches++;
+        }
+    }
+    return mismatches;
+}
+
+// Cell lookups per second of getXCellIndex over the pixels of a frame: with
+// the spiral period passed at run time, fixed at compile time, and a row at a
+// time through getXCellIndices with the scalar and the selected kernel.
+// Returns false if a fixed-period or batched lookup differs from getXCellIndex.
+static bool benchmarkCellIndex(int width, int height, int iterations) {
+    const float spiralPer = g_scanTables->spiralPer;
+    const float halfWidth = width / 2.0f;
+    const float halfHeight = height / 2.0f;
+    const optimized::ScanKernel selected = optimized::getScanKernel();
+
+    // Every fixed period and the batched lookups give the same cells as getXCellIndex
+    bool identical = true;
+    for (int period : { 15, 31, 63, 127 }) {
+        const XCellIndexFunction fixed = getFixedXCellIndex(period + 0.5f);
+        std::vector<float> xs(width), ys(width);
+        std::vector<int> cells(width);
+        long long fixedMismatches = 0;
+        long long batchMismatches = 0;
+        for (int y = 0; y < height; y++) {
+            for (int x = 0; x < width; x++) {
+                // Quarter-pixel offsets reach points between the pixel centers
+                xs[x] = x - halfWidth + 0.25f * (y & 3);
+                ys[x] = y - halfHeight + 0.25f * (x & 3);
+            }
+            getXCellIndices(xs.data(), ys.data(), width, period + 0.5f, cells.data());
+            for (int x = 0; x < width; x++) {
+                const int expected = getXCellIndex(xs[x], ys[x], period + 0.5f);
+                if (!fixed || fixed(xs[x], ys[x]) != expected) fixedMismatches++;
+                if (cells[x] != expected) batchMismatches++;
+            }
+        }
+        if (fixedMismatches > 0 || batchMismatches > 0) {
+            std::cerr << "Spiral period " << period << ": " << fixedMismatches << " fixed-period and "
+                      << batchMismatches << " batched cells differ from getXCellIndex" << std::endl;
+            identical = false;
+        }
+    }
+
+    // Every point of the tables' map, as the scan tables cover it
+    const long long mapMismatches = countBatchMismatches(g_scanTables->mapWidth, spiralPer);
+    if (mapMismatches > 0) {
+        std::cerr << mapMismatches << " batched cells of the " << g_scanTables->mapWidth
+                  << "-pixel map differ from getXCellIndex" << std::endl;
+        identical = false;
+    }
+
+    // Each mode looks up the cells of one row
+    struct Mode {
+        const char* name;
+        std::function<void(const float* xs, const float* ys, int n, int* cells)> lookup;
+    };
+    const XCellIndexFunction dispatched = getFixedXCellIndex(spiralPer);
+    const Mode modes[] = {
+        { "runtime", [&](const float* xs, const float* ys, int n, int* cells) {
+            for (int i = 0; i < n; i++) cells[i] = getXCellIndex(xs[i], ys[i], spiralPer);
+        } },
+        { "fixed", [&](const float* xs, const float* ys, int n, int* cells) {
+            for (int i = 0; i < n; i++) {
+                cells[i] = dispatched ? dispatched(xs[i], ys[i]) : getXCellIndex(xs[i], ys[i], spiralPer);
+            }
+        } },
+        { "b-scalar", [&](const float* xs, const float* ys, int n, int* cells) {
+            optimized::setScanKernel(optimized::SCAN_KERNEL_SCALAR);
+            getXCellIndices(xs, ys, n, spiralPer, cells);
+            optimized::setScanKernel(selected);
+        } },
+        { "batch", [&](const float* xs, const float* ys, int n, int* cells) {
+            getXCellIndices(xs, ys, n, spiralPer, cells);
+        } },
+    };
+
+    std::cout << "Cell index lookups (" << width << "x" << height << ", spiral period " << spiralPer << ", "
+              << iterations << " iterations, " << optimized::getScanKernelName(selected) << " kernel)" << std::endl;
+    std::cout << std::setw(8) << "mode" << std::setw(14) << "Mcalls/s" << std::setw(10) << "speedup" << std::endl;
+
+    std::vector<float> xs(width), ys(width);
+    std::vector<int> cells(width);
+    for (int x = 0; x < width; x++) {
+        xs[x] = x - halfWidth;
+    }
+    double baseline = 0.0;
+    for (const Mode& mode : modes) {
+        long long checksum = 0;  // Keeps the lookups from being optimized away
+        auto start = std::chrono::high_resolution_clock::now();
+        for (int i = 0; i < iterations; i++) {
+            for (int y = 0; y < height; y++) {
+                std::fill(ys.begin(), ys.end(), y - halfHeight);
+                mode.lookup(xs.data(), ys.data(), width, cells.data());
+                checksum += cells[y % width];
+            }
+        }
+        auto end = std::chrono::high_resolution_clock::now();
+        const double callsPerSecond =
+            static_cast<double>(width) * height * iterations / std::chrono::duration<double>(end - start).count();
+        if (baseline == 0.0) baseline = callsPerSecond;
+
+        std::cout << std::setw(8) << mode.name
+                  << std::setw(14) << std::fixed << std::setprecision(1) << callsPerSecond / 1e6
+                  << std::setw(10) << std::setprecision(2) << callsPerSecond / baseline
+                  << "  (checksum " << checksum << ")" << std::endl;
+    }
+    if (!dispatched) {
+        std::cout << "No fixed-period lookup for spiral period " << spiralPer << std::endl;
+    }
+    return identical;
+}
+
+int main(int argc, char* argv[]) {
+    if (argc < 2) {
+        std::cerr << "Usage: " << argv[0] << " <scan_table_file> [benchmark] [width] [height] [iterations]" << std::endl;
+        std::cerr << "Benchmarks: threads, kernels, plans, resize, multi, pyramid, alloc, batch, cells, sparse, depth, stats, stream, delta, index" << std::endl;
+        std::cerr << "Example: " << argv[0] << " ScanTables63 threads 1920 1080 50" << std::endl;
+        return -1;
+    }
+
+    std::string scanTableFile = argv[1];
+    std::string benchmark = (argc > 2) ? argv[2] : "threads";
+    int width = (argc > 3) ? std::atoi(argv[3]) : 1920;
+    int height = (argc > 4) ? std::atoi(argv[4]) : 1080;
+    int iterations = (argc > 5) ? std::atoi(argv[5]) : 50;
+
+    if (!initLPX(scanTableFile, width, height)) {
+        std::cerr << "Failed to load scan tables: " << scanTableFile << std::endl;
+        return -1;
+    }
+
+    cv::Mat frame = makeTestFrame(width, height);
+
+    if (benchmark == "threads") {
+        benchmarkThreads(frame, iterations);
+    } else if (benchmark == "kernels") {
+        benchmarkKernels(frame, iterations);
+    } else if (benchmark == "plans") {
+        benchmarkPlans(frame, iterations);
+    } else if (benchmark == "resize") {
+        benchmarkResize(frame, iterations);
+    } else if (benchmark == "multi") {
+        benchmarkMulti(frame, iterations);
+    } else if (benchmark == "pyramid") {
+        benchmarkPyramid(frame, iterations);
+    } else if (benchmark == "batch") {
+        benchmarkBatch(frame, iterations);
+    } else if (benchmark == "cells") {
+        benchmarkCells(frame, iterations);
+    } else if (benchmark == "sparse") {
+        benchmarkSparse(frame, iterations);
+    } else if (benchmark == "depth") {
+        benchmarkDepth(frame, iterations);
+    } else if (benchmark == "stats") {
+        benchmarkStatistics(frame, iterations);
+    } else if (benchmark == "stream") {
+        benchmarkStream(frame, iterations);
+    } else if (benchmark == "delta") {
+        benchmarkDelta(frame, iterations);
+    } else if (benchmark == "index") {
+        if (!benchmarkCellIndex(width, height, iterations)) {
+            shutdownLPX();
+            return 1;
+        }
+    } else if (benchmark == "alloc") {
+        if (!benchmarkAllocations(frame, iterations)) {
+            shutdownLPX();
+            return 1;
+        }
+    } else {
+        std::cerr << "Unknown benchmark: " << benchmark << std::endl;
+        return -1;
+    }
+
+    shutdownLPX();
+    return 0;
+}
@@ -0,0 +1,88 @@
+// main_table_file.cpp
+// Convert scan tables to a memory-mapped table file and check the result,
+// or generate scan tables for a spiral period
+#include "lpx_image.h"
+#include "lpx_table_file.h"
+#include <chrono>
+#include <cstring>
+#include <iostream>
+#include <memory>
+#include <string>
+
+using namespace lpx;
+
+template <typename T>
+static bool sameArray(const TableArray<T>& a, const TableArray<T>& b) {
+    return a.size() == b.size() && (a.empty() || std::memcmp(a.data(), b.data(), a.size() * sizeof(T)) == 0);
+}
+
+static double loadMs(const std::string& filename, std::shared_ptr<LPXTables>& tables) {
+    auto start = std::chrono::high_resolution_clock::now();
+    tables = std::make_shared<LPXTables>(filename);
+    auto end = std::chrono::high_resolution_clock::now();
+    return std::chrono::duration<double, std::milli>(end - start).count();
+}
+
+static int generate(const std::string& period, const std::string& width, const std::string& target) {
+    LPXTables tables("");
+    auto start = std::chrono::high_resolution_clock::now();
+    const bool generated = tables.generate(std::stof(period), std::stoi(width));
+    auto end = std::chrono::high_resolution_clock::now();
+    if (!generated || !tables.save(target)) {
+        std::cerr << "Failed to generate " << target << std::endl;
+        return 1;
+    }
+    std::cout << "Generated " << target << " (" << tables.length << " runs, " << tables.innerLength
+              << " fovea cells, last cell " << tables.lastCellIndex << ") in "
+              << std::chrono::duration<double, std::milli>(end - start).count() << " ms" << std::endl;
+    return 0;
+}
+
+int main(int argc, char* argv[]) {
+    if (argc == 5 && std::string(argv[1]) == "generate") {
+        return generate(argv[2], argv[3], argv[4]);
+    }
+    if (argc < 3) {
+        std::cerr << "Usage: " << argv[0] << " <scan_table_file> <table_file>" << std::endl;
+        std::cerr << "       " << argv[0] << " generate <spiral_period> <map_width> <scan_table_file>" << std::endl;
+        std::cerr << "Example: " << argv[0] << " ScanTables63 ScanTables63.lpxt" << std::endl;
+        std::cerr << "Example: " << argv[0] << " generate 63 6000 ScanTables63" << std::endl;
+        return -1;
+    }
+    const std::string source = argv[1];
+    const std::string target = argv[2];
+
+    std::shared_ptr<LPXTables> tables;
+    const double readMs = loadMs(source, tables);
+    if (!tables->isInitialized()) {
+        std::cerr << "Failed to load scan tables from " << source << std::endl;
+        return 1;
+    }
+    if (!writeTableFile(tables, target)) {
+        std::cerr << "Failed to write " << target << std::endl;
+        return 1;
+    }
+
+    std::shared_ptr<LPXTables> mapped;
+    const double mapMs = loadMs(target, mapped);
+    auto file = LPXTableFile::open(target, false, true);
+    if (!mapped->isInitialized() || !file) {
+        std::cerr << "Failed to map " << target << std::endl;
+        return 1;
+    }
+    const bool same = mapped->mapWidth == tables->mapWidth && mapped->spiralPer == tables->spiralPer &&
+                      mapped->lastFoveaIndex == tables->lastFoveaIndex &&
+                      mapped->lastCellIndex == tables->lastCellIndex &&
+                      sameArray(mapped->outerPixelIndex, tables->outerPixelIndex) &&
+                      sameArray(mapped->outerPixelCellIdx, tables->outerPixelCellIdx) &&
+                      sameArray(mapped->innerCells, tables->innerCells);
+    if (!same) {
+        std::cerr << target << " does not hold the tables of " << source << std::endl;
+        return 1;
+    }
+
+    std::cout << "Wrote " << target << " (" << file->header().fileSize << " bytes, version "
+              << file->header().version << ")" << std::endl;
+    std::cout << "Load: " << readMs << " ms read, " << mapMs << " ms mapped" << std::endl;
+    return 0;
+}
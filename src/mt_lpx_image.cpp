@@ -7,6 +7,7 @@
 #include "../include/lpx_mt.h"
 #include "../include/lpx_common.h"
 #include "../include/lpx_optimized.h"
+#include "../include/lpx_table_file.h"
 #include <fstream>
 #include <iostream>
 #include <cstring>
@@ -16,6 +17,7 @@
 #include <mutex>
 #include <algorithm>
 #include <chrono>
+#include <cstdlib>  // For getenv
 #include <iomanip>
 
 #include <pthread.h>
@@ -59,6 +61,22 @@ static cv::Vec3b getPixelColor(const cv::Mat& image, int y, int x) {
 
 // LPXTables load function implementation
 bool LPXTables::load(const std::string& filename) {
+    const char* env_var = std::getenv("LPX_SHARED_TABLES");
+    if (env_var && (std::string(env_var) == "1" || std::string(env_var) == "true")) {
+        if (loadShared(filename)) {
+            return true;
+        }
+        LOG_WARNING("Shared scan tables unavailable; loading a private copy of " + filename);
+    }
+    return loadPrivate(filename);
+}
+
+bool LPXTables::loadPrivate(const std::string& filename) {
+    tableFile.reset();
+    if (isTableFile(filename)) {
+        return loadTableFile(filename);
+    }
+
     std::ifstream file(filename, std::ios::binary);
     if (!file.is_open()) {
         return false;
@@ -93,14 +111,32 @@ bool LPXTables::load(const std::string& filename) {
     outerPixelCellIdx.resize(length);
     innerCells.resize(innerLength);
 
-    file.read(reinterpret_cast<char*>(outerPixelIndex.data()), length * sizeof(int));
-    file.read(reinterpret_cast<char*>(outerPixelCellIdx.data()), length * sizeof(int));
-    file.read(reinterpret_cast<char*>(innerCells.data()), innerLength * sizeof(PositionPair));
+    file.read(reinterpret_cast<char*>(outerPixelIndex.ownedData()), length * sizeof(int));
+    file.read(reinterpret_cast<char*>(outerPixelCellIdx.ownedData()), length * sizeof(int));
+    file.read(reinterpret_cast<char*>(innerCells.ownedData()), innerLength * sizeof(PositionPair));
 
     initialized = true;
     return true;
 }
 
+bool LPXTables::save(const std::string& filename) const {
+    std::ofstream file(filename, std::ios::binary);
+    if (!file.is_open() || !initialized) {
+        return false;
+    }
+
+    // Header values, the total length counting every int of the file
+    const int header[7] = {
+        7 + 2 * length + 2 * innerLength, mapWidth, static_cast<int>(spiralPer),
+        length, innerLength, lastFoveaIndex, lastCellIndex
+    };
+    file.write(reinterpret_cast<const char*>(header), sizeof(header));
+    file.write(reinterpret_cast<const char*>(outerPixelIndex.data()), length * sizeof(int));
+    file.write(reinterpret_cast<const char*>(outerPixelCellIdx.data()), length * sizeof(int));
+    file.write(reinterpret_cast<const char*>(innerCells.data()), innerLength * sizeof(PositionPair));
+    return static_cast<bool>(file);
+}
+
 // LPXTables constructor and destructor
 LPXTables::LPXTables(const std::string& filename) : initialized(false), spiralPer(63.5f) {
     if (!filename.empty()) {
@@ -128,10 +164,6 @@ LPXImage::LPXImage(std::shared_ptr<LPXTables> tables, int imageWidth, int imageH
         
         // Initialize arrays
         cellArray.resize(nMaxCells, 0);
-        accR.resize(nMaxCells, 0);
-        accG.resize(nMaxCells, 0);
-        accB.resize(nMaxCells, 0);
-        count.resize(nMaxCells, 0);
     }
 }
 
@@ -348,12 +380,9 @@ bool LPXImage::loadFromFile(const std::string& filename) {
     // Resize and read cell array
     cellArray.resize(length);
     file.read(reinterpret_cast<char*>(cellArray.data()), length * sizeof(uint32_t));
-    
-    // Resize accumulators
-    accR.resize(nMaxCells, 0);
-    accG.resize(nMaxCells, 0);
-    accB.resize(nMaxCells, 0);
-    count.resize(nMaxCells, 0);
+    if (opponentOutput) {
+        updateOpponentCells();
+    }
     
     return true;
 }
@@ -367,13 +396,181 @@ size_t LPXImage::getRawDataSize() const {
     return cellArray.size() * sizeof(uint32_t);
 }
 
-// This method is no longer used - all scanning now goes through the optimized implementation
+// Scan directly into this image; all scanning goes through the optimized implementation
+bool LPXImage::scanFromImage(const cv::Mat& image, float x_center, float y_center, PixelFormat format) {
+    return lpx::optimized::optimizedMultithreadedScan(this, image, x_center, y_center, format);
+}
 
 // Multithreaded implementation of scanFromImage - OPTIMIZED VERSION
-bool multithreadedScanFromImage(LPXImage* lpxImage, const cv::Mat& image, float x_center, float y_center) {
+bool multithreadedScanFromImage(LPXImage* lpxImage, const cv::Mat& image, float x_center, float y_center,
+                                PixelFormat format) {
     // Use the optimized implementation for 10x performance improvement
     // Delegating to optimized scan implementation
-    return lpx::optimized::optimizedMultithreadedScan(lpxImage, image, x_center, y_center);
+    return lpx::optimized::optimizedMultithreadedScan(lpxImage, image, x_center, y_center, format);
+}
+
+// Free list of an LPXImagePool. The shared_ptrs handed out keep it alive, so
+// an image can be released after its pool is gone.
+struct LPXImagePoolState {
+    std::mutex mutex;
+    bool closed = false;  // Pool destroyed; released images are deleted
+    size_t kept = 0;      // Images owned by the pool, free or handed out
+    std::vector<std::unique_ptr<LPXImage>> freeImages;
+    // Control blocks of released shared_ptrs, all of one size, reused by
+    // later acquires so that recycling an image does not allocate
+    size_t blockSize = 0;
+    std::vector<void*> freeBlocks;
+
+    ~LPXImagePoolState() {
+        for (void* block : freeBlocks) {
+            ::operator delete(block);
+        }
+    }
+};
+
+namespace {
+
+// Puts a pooled image back on the free list when its last shared_ptr goes
+struct ReturnToPool {
+    std::shared_ptr<LPXImagePoolState> state;
+    bool pooled;
+
+    void operator()(LPXImage* image) const {
+        if (pooled) {
+            std::lock_guard<std::mutex> lock(state->mutex);
+            if (!state->closed) {
+                state->freeImages.emplace_back(image);
+                return;
+            }
+        }
+        delete image;
+    }
+};
+
+// Allocates the shared_ptr control blocks of pooled images from the free list
+template<typename T>
+struct PoolBlockAllocator {
+    typedef T value_type;
+
+    explicit PoolBlockAllocator(std::shared_ptr<LPXImagePoolState> state) : state(std::move(state)) {}
+    template<typename U>
+    PoolBlockAllocator(const PoolBlockAllocator<U>& other) : state(other.state) {}
+
+    T* allocate(size_t n) {
+        const size_t bytes = n * sizeof(T);
+        {
+            std::lock_guard<std::mutex> lock(state->mutex);
+            if (bytes == state->blockSize && !state->freeBlocks.empty()) {
+                void* block = state->freeBlocks.back();
+                state->freeBlocks.pop_back();
+                return static_cast<T*>(block);
+            }
+        }
+        return static_cast<T*>(::operator new(bytes));
+    }
+
+    void deallocate(T* block, size_t n) {
+        const size_t bytes = n * sizeof(T);
+        {
+            std::lock_guard<std::mutex> lock(state->mutex);
+            if (!state->closed && (state->blockSize == 0 || state->blockSize == bytes) &&
+                state->freeBlocks.size() < state->freeBlocks.capacity()) {
+                state->blockSize = bytes;
+                state->freeBlocks.push_back(block);
+                return;
+            }
+        }
+        ::operator delete(block);
+    }
+
+    std::shared_ptr<LPXImagePoolState> state;
+};
+
+template<typename T, typename U>
+bool operator==(const PoolBlockAllocator<T>& a, const PoolBlockAllocator<U>& b) { return a.state == b.state; }
+template<typename T, typename U>
+bool operator!=(const PoolBlockAllocator<T>& a, const PoolBlockAllocator<U>& b) { return a.state != b.state; }
+
+} // namespace
+
+LPXImagePool::LPXImagePool(std::shared_ptr<LPXTables> tables, size_t capacity)
+    : tables(tables), maxImages(capacity), state(std::make_shared<LPXImagePoolState>()) {
+    state->freeImages.reserve(maxImages);
+    state->freeBlocks.reserve(maxImages);
+}
+
+LPXImagePool::~LPXImagePool() {
+    std::vector<std::unique_ptr<LPXImage>> released;
+    std::vector<void*> blocks;
+    {
+        std::lock_guard<std::mutex> lock(state->mutex);
+        state->closed = true;
+        released.swap(state->freeImages);
+        blocks.swap(state->freeBlocks);
+    }
+    for (void* block : blocks) {
+        ::operator delete(block);
+    }
+}
+
+std::shared_ptr<LPXImage> LPXImagePool::acquire(int imageWidth, int imageHeight) {
+    std::unique_ptr<LPXImage> image;
+    bool pooled = false;
+    {
+        std::lock_guard<std::mutex> lock(state->mutex);
+        if (!state->freeImages.empty()) {
+            image = std::move(state->freeImages.back());
+            state->freeImages.pop_back();
+            pooled = true;
+        } else if (state->kept < maxImages) {
+            state->kept++;
+            pooled = true;
+        }
+    }
+    if (!image) {
+        image.reset(new LPXImage(tables, imageWidth, imageHeight));
+    }
+
+    image->setSize(imageWidth, imageHeight);
+    image->setPreciseOutput(false);
+    image->setCellStatistics(false);
+    image->setOpponentOutput(false);
+    return std::shared_ptr<LPXImage>(image.release(), ReturnToPool{state, pooled},
+                                     PoolBlockAllocator<LPXImage>(state));
+}
+
+size_t LPXImagePool::size() const {
+    std::lock_guard<std::mutex> lock(state->mutex);
+    return state->kept;
+}
+
+size_t LPXImagePool::available() const {
+    std::lock_guard<std::mutex> lock(state->mutex);
+    return state->freeImages.size();
+}
+
+// Pool behind the global scan functions, replaced when initLPX loads new tables
+static std::mutex g_imagePoolMutex;
+static std::unique_ptr<LPXImagePool> g_imagePool;
+
+static std::shared_ptr<LPXImage> acquireGlobalImage(int imageWidth, int imageHeight) {
+    std::lock_guard<std::mutex> lock(g_imagePoolMutex);
+    if (!g_imagePool || g_imagePool->getScanTables() != g_scanTables) {
+        const char* env_var = std::getenv("LPX_IMAGE_POOL");
+        const size_t capacity = (env_var != nullptr) ? static_cast<size_t>(std::max(0, std::atoi(env_var))) : size_t(8);
+        g_imagePool.reset(new LPXImagePool(g_scanTables, capacity));
+    }
+    return g_imagePool->acquire(imageWidth, imageHeight);
+}
+
+bool scanInto(LPXImage& lpxImage, const cv::Mat& image, float x_center, float y_center, PixelFormat format) {
+    const cv::Size frameSize = getFrameSize(image, format);
+    if (frameSize.width <= 0) {
+        LOG_ERROR(std::string("Image does not match pixel format ") + getPixelFormatName(format));
+        return false;
+    }
+    lpxImage.setSize(frameSize.width, frameSize.height);
+    return lpx::optimized::optimizedMultithreadedScan(&lpxImage, image, x_center, y_center, format);
 }
 
 // Global functions in the lpx namespace
@@ -384,15 +581,20 @@ bool initLPX(const std::string& scanTableFile, int imageWidth, int imageHeight)
 
 void shutdownLPX() {
     g_scanTables.reset();
+    
+    std::lock_guard<std::mutex> lock(g_imagePoolMutex);
+    g_imagePool.reset();
 }
 
-std::shared_ptr<LPXImage> scanImage(const cv::Mat& image, float x_center, float y_center) {
+std::shared_ptr<LPXImage> scanImage(const cv::Mat& image, float x_center, float y_center,
+                                    PixelFormat format) {
     if (!g_scanTables || !g_scanTables->isInitialized()) {
         return nullptr;
     }
     
-    auto lpxImage = std::make_shared<LPXImage>(g_scanTables, image.cols, image.rows);
-    if (multithreadedScanFromImage(lpxImage.get(), image, x_center, y_center)) {
+    const cv::Size frameSize = getFrameSize(image, format);
+    auto lpxImage = acquireGlobalImage(frameSize.width, frameSize.height);
+    if (multithreadedScanFromImage(lpxImage.get(), image, x_center, y_center, format)) {
         return lpxImage;
     }
     
@@ -451,33 +653,22 @@ void LPXImage::unpackColor(uint32_t packed, int& r, int& g, int& b) const {
     r = (packed >> 16) & 0xFF;
 }
 
-// Color extraction methods for LPXVision
-int LPXImage::extractCellLuminance(uint32_t cellValue) const {
-    // Extract RGB components
-    int r, g, b;
-    unpackColor(cellValue, r, g, b);
-    
+// Opponent-colour values of an unpacked cell, shared by the extract methods
+// and the planes scans fill so both give the same numbers
+static inline int cellLuminance(int r, int g, int b) {
     // Calculate luminance using standard formula: Y = 0.299*R + 0.587*G + 0.114*B
     // Scale to range 0-1023 (as expected by JavaScript LPXVision)
     double luminance = 0.299 * r + 0.587 * g + 0.114 * b;
     return static_cast<int>(luminance * 1023.0 / 255.0);
 }
 
-int LPXImage::extractCellGreenRed(uint32_t cellValue) const {
-    // Extract RGB components
-    int r, g, b;
-    unpackColor(cellValue, r, g, b);
-    
+static inline int cellGreenRed(int r, int g) {
     // Calculate green-red difference in range -1023 to +1023
     int greenRed = g - r;
     return greenRed * 1023 / 255;  // Scale to expected range
 }
 
-int LPXImage::extractCellYellowBlue(uint32_t cellValue) const {
-    // Extract RGB components
-    int r, g, b;
-    unpackColor(cellValue, r, g, b);
-    
+static inline int cellYellowBlue(int r, int g, int b) {
     // Calculate yellow-blue difference in range -1023 to +1023
     // Yellow = (R + G) / 2, so Yellow - Blue = (R + G) / 2 - B
     int yellow = (r + g) / 2;
@@ -485,6 +676,46 @@ int LPXImage::extractCellYellowBlue(uint32_t cellValue) const {
     return yellowBlue * 1023 / 255;  // Scale to expected range
 }
 
+// Color extraction methods for LPXVision
+int LPXImage::extractCellLuminance(uint32_t cellValue) const {
+    int r, g, b;
+    unpackColor(cellValue, r, g, b);
+    return cellLuminance(r, g, b);
+}
+
+int LPXImage::extractCellGreenRed(uint32_t cellValue) const {
+    int r, g, b;
+    unpackColor(cellValue, r, g, b);
+    return cellGreenRed(r, g);
+}
+
+int LPXImage::extractCellYellowBlue(uint32_t cellValue) const {
+    int r, g, b;
+    unpackColor(cellValue, r, g, b);
+    return cellYellowBlue(r, g, b);
+}
+
+void LPXImage::updateOpponentCells() {
+    const size_t n = cellArray.size();
+    opponentCells.luminance.resize(n);
+    opponentCells.greenRed.resize(n);
+    opponentCells.yellowBlue.resize(n);
+    int16_t* luminance = opponentCells.luminance.data();
+    int16_t* greenRed = opponentCells.greenRed.data();
+    int16_t* yellowBlue = opponentCells.yellowBlue.data();
+    
+    // One pass over the packed cells, three planes out
+    for (size_t i = 0; i < n; i++) {
+        const uint32_t cell = cellArray[i];
+        const int b = cell & 0xFF;
+        const int g = (cell >> 8) & 0xFF;
+        const int r = (cell >> 16) & 0xFF;
+        luminance[i] = static_cast<int16_t>(cellLuminance(r, g, b));
+        greenRed[i] = static_cast<int16_t>(cellGreenRed(r, g));
+        yellowBlue[i] = static_cast<int16_t>(cellYellowBlue(r, g, b));
+    }
+}
+
 // Add saveToFile method for LPXImage
 bool LPXImage::saveToFile(const std::string& filename) const {
     std::ofstream file(filename, std::ios::binary);
@@ -524,17 +755,19 @@ bool LPXImage::saveToFile(const std::string& filename) const {
 }
 
 // Helper function that creates a new LPXImage and scans it using multithreading
-std::shared_ptr<LPXImage> multithreadedScanImage(const cv::Mat& image, float x_center, float y_center) {
+std::shared_ptr<LPXImage> multithreadedScanImage(const cv::Mat& image, float x_center, float y_center,
+                                                 PixelFormat format) {
     // Check if scan tables are initialized
     if (!g_scanTables || !g_scanTables->isInitialized()) {
         return nullptr;
     }
     
-    // Create a new LPXImage with the scan tables
-    auto lpxImage = std::make_shared<LPXImage>(g_scanTables, image.cols, image.rows);
+    // Create a new LPXImage with the scan tables, sized to the frame (not the Mat)
+    const cv::Size frameSize = getFrameSize(image, format);
+    auto lpxImage = acquireGlobalImage(frameSize.width, frameSize.height);
     
     // Use multithreaded scanning directly - this now works directly with the lpxImage's internal buffers
-    if (multithreadedScanFromImage(lpxImage.get(), image, x_center, y_center)) {
+    if (multithreadedScanFromImage(lpxImage.get(), image, x_center, y_center, format)) {
         return lpxImage;
     }
     
@@ -542,4 +775,130 @@ std::shared_ptr<LPXImage> multithreadedScanImage(const cv::Mat& image, float x_c
     return nullptr;
 }
 
+// Helper function that scans a frame at its native resolution as if resized to scanSize
+std::shared_ptr<LPXImage> multithreadedScanResizedImage(const cv::Mat& image, cv::Size scanSize,
+                                                        float x_center, float y_center,
+                                                        PixelFormat format) {
+    if (!g_scanTables || !g_scanTables->isInitialized() || scanSize.width <= 0 || scanSize.height <= 0) {
+        return nullptr;
+    }
+    
+    // The LPXImage describes the resized frame
+    auto lpxImage = acquireGlobalImage(scanSize.width, scanSize.height);
+    if (lpx::optimized::optimizedMultithreadedScan(lpxImage.get(), image, x_center, y_center, format, scanSize)) {
+        return lpxImage;
+    }
+    
+    return nullptr;
+}
+
+// Helper function that scans a range of cells only
+std::shared_ptr<LPXImage> multithreadedScanCellRange(const cv::Mat& image, float x_center, float y_center,
+                                                     int firstCell, int lastCell,
+                                                     PixelFormat format, cv::Size scanSize) {
+    if (!g_scanTables || !g_scanTables->isInitialized()) {
+        return nullptr;
+    }
+    
+    const bool resized = scanSize.width > 0 && scanSize.height > 0;
+    const cv::Size frameSize = resized ? scanSize : getFrameSize(image, format);
+    auto lpxImage = acquireGlobalImage(frameSize.width, frameSize.height);
+    if (lpx::optimized::optimizedMultithreadedScan(lpxImage.get(), image, x_center, y_center, format,
+                                                   scanSize, firstCell, lastCell)) {
+        return lpxImage;
+    }
+    
+    return nullptr;
+}
+
+// Helper function that scans a list of cells only
+std::shared_ptr<LPXImage> scanCells(const cv::Mat& image, float x_center, float y_center,
+                                    const std::vector<int>& cells, PixelFormat format) {
+    if (!g_scanTables || !g_scanTables->isInitialized()) {
+        return nullptr;
+    }
+    
+    const cv::Size frameSize = getFrameSize(image, format);
+    auto lpxImage = acquireGlobalImage(frameSize.width, frameSize.height);
+    if (lpx::optimized::optimizedScanCells(lpxImage.get(), image, x_center, y_center,
+                                           cells.data(), static_cast<int>(cells.size()), format)) {
+        return lpxImage;
+    }
+    
+    return nullptr;
+}
+
+// Helper function that scans the outer rings from a downsampled pyramid
+std::shared_ptr<LPXImage> multithreadedScanImagePyramid(const cv::Mat& image, float x_center, float y_center,
+                                                        int pyramidLevels, PixelFormat format) {
+    if (!g_scanTables || !g_scanTables->isInitialized()) {
+        return nullptr;
+    }
+    
+    // Level buffers are kept per thread and reused while the frame size is unchanged
+    static thread_local std::vector<cv::Mat> pyramid;
+    if (!lpx::optimized::buildScanPyramid(image, pyramidLevels, pyramid, format)) {
+        return nullptr;
+    }
+    
+    auto lpxImage = acquireGlobalImage(image.cols, image.rows);
+    const bool scanned = lpx::optimized::optimizedPyramidScan(lpxImage.get(), pyramid, x_center, y_center, format);
+    pyramid[0] = cv::Mat();  // Do not keep the caller's frame alive
+    return scanned ? lpxImage : nullptr;
+}
+
+// Helper function that scans one frame at several fixations in a single pass
+std::vector<std::shared_ptr<LPXImage>> scanMultiple(const cv::Mat& image, const std::vector<cv::Point2f>& centers,
+                                                    PixelFormat format) {
+    if (!g_scanTables || !g_scanTables->isInitialized()) {
+        return {};
+    }
+    
+    const cv::Size frameSize = getFrameSize(image, format);
+    std::vector<std::shared_ptr<LPXImage>> results;
+    std::vector<LPXImage*> lpxImages;
+    results.reserve(centers.size());
+    lpxImages.reserve(centers.size());
+    for (size_t i = 0; i < centers.size(); i++) {
+        results.push_back(acquireGlobalImage(frameSize.width, frameSize.height));
+        lpxImages.push_back(results.back().get());
+    }
+    
+    if (!lpx::optimized::optimizedMultithreadedScanMultiple(lpxImages, image, centers, format)) {
+        return {};
+    }
+    return results;
+}
+
+// Helper function that scans a batch of frames, one frame per scan thread
+std::vector<std::shared_ptr<LPXImage>> scanBatch(const std::vector<cv::Mat>& images,
+                                                 const std::vector<cv::Point2f>& centers,
+                                                 PixelFormat format) {
+    if (!g_scanTables || !g_scanTables->isInitialized() || centers.empty() ||
+        (centers.size() != 1 && centers.size() != images.size())) {
+        return {};
+    }
+    
+    std::vector<std::shared_ptr<LPXImage>> results;
+    std::vector<LPXImage*> lpxImages;
+    results.reserve(images.size());
+    lpxImages.reserve(images.size());
+    for (const cv::Mat& image : images) {
+        const cv::Size frameSize = getFrameSize(image, format);
+        results.push_back(acquireGlobalImage(frameSize.width, frameSize.height));
+        lpxImages.push_back(results.back().get());
+    }
+    
+    std::vector<char> scanned;
+    if (!lpx::optimized::optimizedScanBatch(lpxImages, images, centers, format, &scanned)) {
+        if (scanned.size() != results.size()) {
+            return {};
+        }
+        for (size_t i = 0; i < results.size(); i++) {
+            if (!scanned[i]) results[i].reset();
+        }
+    }
+    return results;
+}
+
 } // namespace lpx
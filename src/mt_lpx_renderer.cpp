@@ -40,9 +40,25 @@ extern bool set_high_priority();
     // Set this thread to high priority
     // Set this thread to high priority
     set_high_priority();
+
+    // Cells of one row, looked up together; the columns' offsets are the same for every row.
+    // The buffers are kept per thread, like the scan's scratch buffers, and only grow when a
+    // region is wider than the thread's last one.
+    const int rowLength = std::max(0, colMax - colMin);
+    static thread_local std::vector<float> rowX, rowY;
+    static thread_local std::vector<int> rowCells;
+    rowX.resize(rowLength);
+    rowY.resize(rowLength);
+    rowCells.resize(rowLength);
+    for (int x = colMin; x < colMax; x++) {
+        rowX[x - colMin] = x - outputCenterX;
+    }
      
      // Process each row in the assigned region
      for (int y = rowStart; y < rowEnd; y++) {
+         std::fill(rowY.begin(), rowY.end(), static_cast<float>(y - outputCenterY));
+         getXCellIndices(rowX.data(), rowY.data(), rowLength, spiralPer, rowCells.data());
+
          // Process each column in the row
          for (int x = colMin; x < colMax; x++) {
              // Calculate coordinates relative to the output image center
@@ -58,7 +74,7 @@ extern bool set_high_priority();
              float distFromCenter = std::sqrt(scaledX * scaledX + scaledY * scaledY);
              
             // Direct method: Calculate cell index from relative coordinates
-            int cellIndex = getXCellIndex(scaledX, scaledY, spiralPer);
+            int cellIndex = rowCells[x - colMin];
             
             // Add initial bounds check for cellIndex
             if (cellIndex < 0 || cellIndex >= maxLen) {
@@ -76,11 +92,8 @@ extern bool set_high_priority();
                 // In the fovea region, calculate cell index directly from relative position
                 // This exactly matches how the JavaScript implementation works
                 // The key difference: we convert from screen coords back to LOG-POLAR COORDINATES
-                float relXtoCenter = x - outputCenterX;
-                float relYtoCenter = y - outputCenterY;
-                
-                // Use direct calculation for the fovea region
-                int iC = getXCellIndex(relXtoCenter, relYtoCenter, spiralPer);
+                // (the same relative coordinates the row's cells were looked up from)
+                int iC = rowCells[x - colMin];
                 
                 // Make sure the calculated index is within valid range
                 iC = std::max(0, std::min(iC, maxLen - 1));
@@ -7,62 +7,267 @@
 
 #include "../include/lpx_mt.h"
 #include "../include/lpx_common.h"
+#include "../include/lpx_optimized.h"
+#include "../include/lpx_table_file.h"
 #include <chrono>
 #include <iostream>
 #include <iomanip>
 #include <algorithm>
 #include <thread>
-#include <future>
 #include <atomic>
 #include <cstdlib>  // For getenv
 #include <cmath>    // For sin, cos
+#include <cstring>  // For memset
 
 namespace lpx {
 namespace optimized {
 
-// Cache-friendly lookup table for binary search results
-struct ScanCache {
-    std::vector<int> pixelToCellLUT;  // Direct lookup table: pixel index -> cell index
-    int mapSize;
-    bool initialized = false;
+// Build the per-row run index used by the span scan
+void ScanSpanTable::initialize(const std::shared_ptr<LPXTables>& tables) {
+    if (initialized) return;
     
-    void initialize(const std::shared_ptr<LPXTables>& sct) {
-        if (initialized) return;
-        
-        mapSize = sct->mapWidth * sct->mapWidth;
-        pixelToCellLUT.resize(mapSize, -1);
-        
-        // Pre-compute all pixel-to-cell mappings
-        for (int i = 0; i < sct->length; i++) {
-            int pixelIdx = sct->outerPixelIndex[i];
-            int cellIdx = sct->outerPixelCellIdx[i];
+    sct = tables;
+    mapWidth = tables->mapWidth;
+    
+    // Prebuilt in a mapped table file
+    const std::shared_ptr<const LPXTableFile>& file = tables->getTableFile();
+    if (file) {
+        rowFirstRun.view(file->section<int>(TABLE_SECTION_ROW_FIRST_RUN),
+                         file->sectionCount(TABLE_SECTION_ROW_FIRST_RUN), file);
+        cellArea.view(file->section<int64_t>(TABLE_SECTION_CELL_AREA),
+                      file->sectionCount(TABLE_SECTION_CELL_AREA), file);
+        cellReach.view(file->section<int>(TABLE_SECTION_CELL_REACH),
+                       file->sectionCount(TABLE_SECTION_CELL_REACH), file);
+        initialized = true;
+        return;
+    }
+    rowFirstRun.resize(mapWidth + 1);
+    int* firstRun = rowFirstRun.ownedData();
+    
+    // For each row, find the last run starting at or before the row's first pixel
+    const int* runStart = tables->outerPixelIndex.data();
+    const int* runEnd = runStart + tables->length;
+    for (int row = 0; row <= mapWidth; row++) {
+        const int rowBase = row * mapWidth;
+        const int idx = static_cast<int>(std::upper_bound(runStart, runEnd, rowBase) - runStart) - 1;
+        firstRun[row] = std::max(idx, 0);
+    }
+    
+    // Map pixels per cell, from the run lengths
+    int maxCell = 0;
+    for (int i = 0; i < tables->length; i++) {
+        maxCell = std::max(maxCell, tables->outerPixelCellIdx[i]);
+    }
+    cellArea.assign(maxCell + 1, 0);
+    cellReach.assign(maxCell + 1, 0);
+    int64_t* areas = cellArea.ownedData();
+    int* reaches = cellReach.ownedData();
+    const int center = mapWidth / 2;
+    for (int i = 0; i + 1 < tables->length; i++) {
+        const int cell = tables->outerPixelCellIdx[i];
+        if (cell >= 0) {
+            areas[cell] += runStart[i + 1] - runStart[i];
             
-            if (pixelIdx >= 0 && pixelIdx < mapSize) {
-                pixelToCellLUT[pixelIdx] = cellIdx;
-            }
-        }
-        
-        // Fill gaps with nearest valid cell index
-        int lastValidCell = sct->lastFoveaIndex;
-        for (int i = 0; i < mapSize; i++) {
-            if (pixelToCellLUT[i] == -1) {
-                pixelToCellLUT[i] = lastValidCell;
+            // A run wrapping onto the next row may cover any column
+            const int first = runStart[i];
+            const int last = runStart[i + 1] - 1;
+            int reach = std::max(std::abs(first / mapWidth - center), std::abs(last / mapWidth - center));
+            if (first / mapWidth == last / mapWidth) {
+                reach = std::max(reach, std::max(std::abs(first % mapWidth - center), std::abs(last % mapWidth - center)));
             } else {
-                lastValidCell = pixelToCellLUT[i];
+                reach = std::max(reach, center);
             }
+            reaches[cell] = std::max(reaches[cell], reach);
         }
-        
+    }
+    for (size_t c = 1; c < cellReach.size(); c++) {
+        reaches[c] = std::max(reaches[c], reaches[c - 1]);
+    }
+    
+    initialized = true;
+}
+
+std::shared_ptr<const ScanSpanTable> getSharedScanSpanTable(const std::shared_ptr<LPXTables>& tables) {
+    static std::mutex mutex;
+    static std::list<std::shared_ptr<const ScanSpanTable>> spanTables;  // Most recently used first
+    const size_t maxSpanTables = 4;
+    
+    std::lock_guard<std::mutex> lock(mutex);
+    for (auto it = spanTables.begin(); it != spanTables.end(); ++it) {
+        if ((*it)->sct == tables) {
+            spanTables.splice(spanTables.begin(), spanTables, it);
+            return spanTables.front();
+        }
+    }
+    
+    std::shared_ptr<ScanSpanTable> spans = std::make_shared<ScanSpanTable>();
+    spans->initialize(tables);
+    spanTables.push_front(spans);
+    if (spanTables.size() > maxSpanTables) {
+        spanTables.pop_back();
+    }
+    return spans;
+}
+
+void CellSpanIndex::initialize(const std::shared_ptr<LPXTables>& tables) {
+    if (initialized) return;
+    
+    sct = tables;
+    const std::shared_ptr<const LPXTableFile>& file = tables->getTableFile();
+    if (file) {
+        cellSpanStart.view(file->section<int>(TABLE_SECTION_CELL_SPAN_START),
+                           file->sectionCount(TABLE_SECTION_CELL_SPAN_START), file);
+        cellSpans.view(file->section<MapSpan>(TABLE_SECTION_CELL_SPANS),
+                       file->sectionCount(TABLE_SECTION_CELL_SPANS), file);
+        cellInnerStart.view(file->section<int>(TABLE_SECTION_CELL_INNER_START),
+                            file->sectionCount(TABLE_SECTION_CELL_INNER_START), file);
+        cellInner.view(file->section<int>(TABLE_SECTION_CELL_INNER),
+                       file->sectionCount(TABLE_SECTION_CELL_INNER), file);
+        spiralCells = file->header().spiralCells;
+        spiralRadius = file->header().spiralRadius;
         initialized = true;
-        // Initialization complete
+        return;
     }
     
-    inline int getCellIndex(int pixelIdx) const {
-        return (pixelIdx >= 0 && pixelIdx < mapSize) ? pixelToCellLUT[pixelIdx] : 0;
+    const int mapWidth = tables->mapWidth;
+    const int length = tables->length;
+    const int* runStart = tables->outerPixelIndex.data();
+    const int* runCell = tables->outerPixelCellIdx.data();
+    const int64_t mapEnd = static_cast<int64_t>(mapWidth) * mapWidth;
+    
+    int maxCell = std::max(tables->lastFoveaIndex, 0);
+    for (int i = 0; i < length; i++) {
+        maxCell = std::max(maxCell, runCell[i]);
     }
-};
+    
+    // Count the row pieces of every run, then place them by cell; runs are
+    // visited in map order, so each cell's spans stay in map order
+    cellSpanStart.assign(maxCell + 2, 0);
+    int* spanStart = cellSpanStart.ownedData();
+    for (int i = 0; i < length; i++) {
+        if (runCell[i] < 0) continue;
+        const int64_t end = (i + 1 < length) ? runStart[i + 1] : mapEnd;
+        if (end <= runStart[i]) continue;
+        spanStart[runCell[i] + 1] += static_cast<int>((end - 1) / mapWidth - runStart[i] / mapWidth + 1);
+    }
+    for (size_t c = 1; c < cellSpanStart.size(); c++) {
+        spanStart[c] += spanStart[c - 1];
+    }
+    cellSpans.resize(cellSpanStart.back());
+    MapSpan* spans = cellSpans.ownedData();
+    std::vector<int> next(cellSpanStart.begin(), cellSpanStart.end() - 1);
+    for (int i = 0; i < length; i++) {
+        if (runCell[i] < 0) continue;
+        const int64_t end = (i + 1 < length) ? runStart[i + 1] : mapEnd;
+        for (int64_t pixel = runStart[i]; pixel < end; ) {
+            const int row = static_cast<int>(pixel / mapWidth);
+            const int64_t rowEnd = std::min(end, static_cast<int64_t>(row + 1) * mapWidth);
+            spans[next[runCell[i]]++] = MapSpan{row, static_cast<int>(pixel - static_cast<int64_t>(row) * mapWidth),
+                                                    static_cast<int>(rowEnd - pixel)};
+            pixel = rowEnd;
+        }
+    }
+    
+    // Inner entries writing each fovea cell, the entry a scan keeps first
+    const int lastFoveaIndex = tables->lastFoveaIndex;
+    const int innerLength = std::min(tables->innerLength, static_cast<int>(tables->innerCells.size()));
+    cellInnerStart.assign(lastFoveaIndex + 2, 0);
+    int* innerStart = cellInnerStart.ownedData();
+    auto innerCell = [&](int i) {
+        return (i <= lastFoveaIndex) ? i : (i < length ? runCell[i] : -1);
+    };
+    for (int i = 0; i < innerLength; i++) {
+        const int cell = innerCell(i);
+        if (cell >= 0 && cell <= lastFoveaIndex) innerStart[cell + 1]++;
+    }
+    for (size_t c = 1; c < cellInnerStart.size(); c++) {
+        innerStart[c] += innerStart[c - 1];
+    }
+    cellInner.resize(cellInnerStart.back());
+    int* inner = cellInner.ownedData();
+    next.assign(cellInnerStart.begin(), cellInnerStart.end() - 1);
+    for (int i = innerLength - 1; i >= 0; i--) {
+        const int cell = innerCell(i);
+        if (cell >= 0 && cell <= lastFoveaIndex) inner[next[cell]++] = i;
+    }
+    
+    // Kept so a scan need not work out the peripheral rows again
+    spiralCells = tables->lastCellIndex + 1;
+    spiralRadius = static_cast<int>(getSpiralRadius(spiralCells, tables->spiralPer) + 0.5f);
+    
+    initialized = true;
+}
+
+std::shared_ptr<const CellSpanIndex> getSharedCellSpanIndex(const std::shared_ptr<LPXTables>& tables) {
+    static std::mutex mutex;
+    static std::list<std::shared_ptr<const CellSpanIndex>> indexes;  // Most recently used first
+    const size_t maxIndexes = 4;
+    
+    std::lock_guard<std::mutex> lock(mutex);
+    for (auto it = indexes.begin(); it != indexes.end(); ++it) {
+        if ((*it)->sct == tables) {
+            indexes.splice(indexes.begin(), indexes, it);
+            return indexes.front();
+        }
+    }
+    
+    std::shared_ptr<CellSpanIndex> index = std::make_shared<CellSpanIndex>();
+    index->initialize(tables);
+    indexes.push_front(index);
+    if (indexes.size() > maxIndexes) {
+        indexes.pop_back();
+    }
+    return index;
+}
+
+ScanContext getDefaultScanContext(const std::shared_ptr<LPXTables>& tables) {
+    ScanContext context;
+    context.spans = getSharedScanSpanTable(tables);
+    context.plans = &getScanPlanCache();
+    context.pool = &getScanThreadPool();
+    return context;
+}
+
+// Context and image must agree on the tables the scan reads
+static bool usesContextTables(const ScanContext& context, const LPXImage* lpxImage) {
+    if (!context.spans || lpxImage->getScanTables() != context.spans->sct) {
+        LOG_ERROR("LPXImage was not created with the scan tables of this scan context");
+        return false;
+    }
+    return true;
+}
+
+template <typename Cell>
+void CellAccumulatorBuffer<Cell>::resize(int cellCount) {
+    // Round up to whole cache lines so the tail is never shared with another buffer
+    const int paddedCells = (cellCount + CELLS_PER_LINE - 1) / CELLS_PER_LINE * CELLS_PER_LINE;
+    if (storage.size() != static_cast<size_t>(paddedCells + CELLS_PER_LINE)) {
+        storage.assign(paddedCells + CELLS_PER_LINE, Cell());
+    }
+    
+    const uintptr_t addr = reinterpret_cast<uintptr_t>(storage.data());
+    const uintptr_t aligned = (addr + CACHE_LINE_SIZE - 1) & ~static_cast<uintptr_t>(CACHE_LINE_SIZE - 1);
+    cells = reinterpret_cast<Cell*>(aligned);
+    nCells = cellCount;
+}
+
+template <typename Cell>
+void CellAccumulatorBuffer<Cell>::clear() {
+    clear(0, nCells);
+}
+
+template <typename Cell>
+void CellAccumulatorBuffer<Cell>::clear(int cellStart, int cellEnd) {
+    cellStart = std::max(0, cellStart);
+    cellEnd = std::min(nCells, cellEnd);
+    if (cellEnd > cellStart) {
+        std::memset(cells + cellStart, 0, (cellEnd - cellStart) * sizeof(Cell));
+    }
+}
 
-// Global cache instance (initialized once per scan tables)
-static ScanCache g_scanCache;
+template class CellAccumulatorBuffer<CellAccumulator>;
+template class CellAccumulatorBuffer<WideCellAccumulator>;
+template class CellAccumulatorBuffer<CellStatsAccumulator>;
 
 // Generate rainbow colors based on log-polar coordinates for smooth visual transitions
 uint32_t generateRainbowColor(int cellIndex, float spiralPer) {
@@ -124,231 +329,1462 @@ bool isRainbowModeEnabled() {
     return (env_var != nullptr && (std::string(env_var) == "1" || std::string(env_var) == "true"));
 }
 
-// Optimized region processing with minimal overhead
-void optimizedProcessImageRegion(const cv::Mat& image, int yStart, int yEnd,
-                               float centerX, float centerY,
-                               const ScanCache& cache,
-                               int scanMapCenterX, int scanMapCenterY,
-                               int w_m, int lastFoveaIndex,
-                               std::vector<std::atomic<int>>& atomicAccR,
-                               std::vector<std::atomic<int>>& atomicAccG,
-                               std::vector<std::atomic<int>>& atomicAccB,
-                               std::vector<std::atomic<int>>& atomicCount) {
-    
-    // Pre-calculate offsets to avoid repeated computation
-    const int j_ofs = static_cast<int>(centerX);
-    const int k_ofs = static_cast<int>(centerY);
-    const int ws_wm_jofs = scanMapCenterX - j_ofs;
-    const int hs_hm_kofs = scanMapCenterY - k_ofs;
-    
-    // Process in chunks to improve cache locality
-    const int cols = image.cols;
-    const bool is3Channel = (image.channels() == 3);
+// Scale taking a 16-bit or float channel to 8 bits, as convertTo(CV_8U) is usually called
+static inline double getDeepToByteScale(int depth) {
+    return depth == CV_16U ? 1.0 / 257.0 : 255.0;
+}
+
+static inline uint32_t deepToByte(double value, double toByte) {
+    return static_cast<uint32_t>(std::min(255.0, std::max(0.0, std::round(value * toByte))));
+}
+
+static inline uint32_t packDeepBGR(double b, double g, double r, double toByte) {
+    return deepToByte(b, toByte) | (deepToByte(g, toByte) << 8) | (deepToByte(r, toByte) << 16);
+}
+
+static inline void storePrecise(float* out, double b, double g, double r) {
+    out[0] = static_cast<float>(b);
+    out[1] = static_cast<float>(g);
+    out[2] = static_cast<float>(r);
+}
+
+// Precise values of an 8-bit cell are its packed bytes
+static inline void storePrecise(float* out, uint32_t packed) {
+    out[0] = static_cast<float>(packed & 0xFF);
+    out[1] = static_cast<float>((packed >> 8) & 0xFF);
+    out[2] = static_cast<float>((packed >> 16) & 0xFF);
+}
+
+// Channel of a CN-channel pixel holding blue, green or red (0, 1, 2)
+template <int CN, bool SWAP_RB>
+struct ChannelIndex {
+    static const int B = CN == 1 ? 0 : (SWAP_RB ? 2 : 0);
+    static const int G = CN == 1 ? 0 : 1;
+    static const int R = CN == 1 ? 0 : (SWAP_RB ? 0 : 2);
+};
+
+// Fovea gather for 16-bit and float frames
+template <typename T, int CN, bool SWAP_RB>
+static void gatherDeepFoveaPixels(const FrameLayout& frame, const PlanFoveaPixel* pixels, int n,
+                                  uint32_t* cells, float* precise) {
+    typedef ChannelIndex<CN, SWAP_RB> Ch;
+    const double toByte = getDeepToByteScale(frame.depth);
+    
+    for (int i = 0; i < n; i++) {
+        const T* p = reinterpret_cast<const T*>(frame.pixels + pixels[i].offset);
+        const double b = p[Ch::B], g = p[Ch::G], r = p[Ch::R];
+        cells[pixels[i].cell] = packDeepBGR(b, g, r, toByte);
+        if (precise) {
+            storePrecise(precise + 3 * pixels[i].cell, b, g, r);
+        }
+    }
+}
+
+template <typename T>
+static void gatherDeepFoveaPixels(const FrameLayout& frame, const PlanFoveaPixel* pixels, int n,
+                                  uint32_t* cells, float* precise) {
+    switch (frame.format) {
+        case PIXEL_FORMAT_BGR: gatherDeepFoveaPixels<T, 3, false>(frame, pixels, n, cells, precise); break;
+        case PIXEL_FORMAT_RGB: gatherDeepFoveaPixels<T, 3, true>(frame, pixels, n, cells, precise); break;
+        case PIXEL_FORMAT_BGRA: gatherDeepFoveaPixels<T, 4, false>(frame, pixels, n, cells, precise); break;
+        default: gatherDeepFoveaPixels<T, 1, false>(frame, pixels, n, cells, precise); break;
+    }
+}
+
+// Branch-free gather of the fovea pixels; off-image pixels were dropped when
+// the plan was built and the pixel format is resolved outside the loop
+void gatherFoveaPixels(const FrameLayout& frame, const ScanPlan& plan, std::vector<uint32_t>& cellArray,
+                       float* precise) {
+    // Fovea cells with no pixel in the image stay empty, whatever the image held before
+    if (!plan.foveaCovered) {
+        std::fill(cellArray.begin() + plan.cellStart, cellArray.begin() + plan.foveaCells, 0u);
+        if (precise) {
+            std::fill(precise + 3 * plan.cellStart, precise + 3 * plan.foveaCells, 0.0f);
+        }
+    }
+    gatherFoveaPixels(frame, plan.fovea.data(), static_cast<int>(plan.fovea.size()), cellArray, precise);
+}
+
+void gatherFoveaPixels(const FrameLayout& frame, const PlanFoveaPixel* pixels, int n,
+                       std::vector<uint32_t>& cellArray, float* precise) {
+    const uchar* data = frame.pixels;
+    uint32_t* cells = cellArray.data();
+    
+    if (frame.depth == CV_16U) {
+        gatherDeepFoveaPixels<uint16_t>(frame, pixels, n, cells, precise);
+        return;
+    }
+    if (frame.depth == CV_32F) {
+        gatherDeepFoveaPixels<float>(frame, pixels, n, cells, precise);
+        return;
+    }
+    
+    switch (frame.format) {
+        case PIXEL_FORMAT_BGR:
+        case PIXEL_FORMAT_BGRA:
+            for (int i = 0; i < n; i++) {
+                const uchar* p = data + pixels[i].offset;
+                // Pack color in BGR format (OpenCV's native format)
+                cells[pixels[i].cell] = p[0] | (p[1] << 8) | (p[2] << 16);
+            }
+            break;
+        case PIXEL_FORMAT_RGB:
+            for (int i = 0; i < n; i++) {
+                const uchar* p = data + pixels[i].offset;
+                cells[pixels[i].cell] = p[2] | (p[1] << 8) | (p[0] << 16);
+            }
+            break;
+        case PIXEL_FORMAT_NV12:
+            for (int i = 0; i < n; i++) {
+                const uchar* uv = frame.chromaU + pixels[i].chromaOffset;
+                cells[pixels[i].cell] = packYUVAsBGR(data[pixels[i].offset], uv[0], uv[1]);
+            }
+            break;
+        case PIXEL_FORMAT_I420:
+            for (int i = 0; i < n; i++) {
+                cells[pixels[i].cell] = packYUVAsBGR(data[pixels[i].offset],
+                                                     frame.chromaU[pixels[i].chromaOffset],
+                                                     frame.chromaV[pixels[i].chromaOffset]);
+            }
+            break;
+        case PIXEL_FORMAT_YUYV:
+            for (int i = 0; i < n; i++) {
+                const uchar* uv = data + pixels[i].chromaOffset;
+                cells[pixels[i].cell] = packYUVAsBGR(data[pixels[i].offset], uv[0], uv[2]);
+            }
+            break;
+        default:
+            for (int i = 0; i < n; i++) {
+                const uint32_t intensity = data[pixels[i].offset];
+                cells[pixels[i].cell] = intensity * 0x010101u;
+            }
+            break;
+    }
+    
+    if (precise) {
+        for (int i = 0; i < n; i++) {
+            storePrecise(precise + 3 * pixels[i].cell, cells[pixels[i].cell]);
+        }
+    }
+}
+
+// Sum the 2x horizontally subsampled chroma under luma pixels [col, col + n).
+// Inner samples cover two pixels; the first and last may only cover one.
+static inline int sumSubsampledChroma(const uchar* plane, int col, int n, SumSpanGrayFn sumGray) {
+    const int k0 = col >> 1;
+    const int k1 = (col + n - 1) >> 1;
+    int sum = 2 * sumGray(plane + k0, k1 - k0 + 1);
+    if (col & 1) sum -= plane[k0];
+    if (!((col + n - 1) & 1)) sum -= plane[k1];
+    return sum;
+}
+
+// Same for NV12's interleaved UV samples
+static inline void sumSubsampledUV(const uchar* uv, int col, int n, int& sumU, int& sumV) {
+    const int k0 = col >> 1;
+    const int k1 = (col + n - 1) >> 1;
+    int u = 0, v = 0;
+    for (int k = k0; k <= k1; k++) {
+        u += uv[2 * k];
+        v += uv[2 * k + 1];
+    }
+    u *= 2;
+    v *= 2;
+    if (col & 1) {
+        u -= uv[2 * k0];
+        v -= uv[2 * k0 + 1];
+    }
+    if (!((col + n - 1) & 1)) {
+        u -= uv[2 * k1];
+        v -= uv[2 * k1 + 1];
+    }
+    sumU = u;
+    sumV = v;
+}
+
+// YUYV pixel pairs share one U and one V byte
+static inline void sumSpanYUYV(const uchar* row, int col, int n, int& sumY, int& sumU, int& sumV) {
+    int y = 0, u = 0, v = 0;
+    for (int x = col; x < col + n; x++) {
+        const uchar* pair = row + 4 * (x >> 1);
+        y += row[2 * x];
+        u += pair[1];
+        v += pair[3];
+    }
+    sumY = y;
+    sumU = u;
+    sumV = v;
+}
+
+// Accumulate the spans of rows [yStart, yEnd) of a FORMAT frame; rowSpanStart[0]
+// belongs to row yMin. The format switch below folds away in each instantiation.
+template <PixelFormat FORMAT>
+static void processSpanRowsAs(const FrameLayout& frame, int yStart, int yEnd,
+                              int yMin, const int* rowSpanStart, const PlanSpan* spans,
+                              AccumulatorBuffer& acc) {
+    
+    CellAccumulator* cells = acc.data();
+    
+    // Kernel chosen once per region rather than per pixel
+    const ScanKernelFunctions& kernel = getScanKernelFunctions();
+    const SumSpanBGRFn sumBGR = kernel.sumBGR;
+    const SumSpanBGRFn sumBGRA = kernel.sumBGRA;
+    const SumSpanGrayFn sumGray = kernel.sumGray;
     
     for (int k_s = yStart; k_s < yEnd; k_s++) {
-        const int i_m_base = ws_wm_jofs + w_m * (hs_hm_kofs + k_s);
-        
-        // Get pointer to current row for faster access
-        const cv::Vec3b* imageRow = nullptr;
-        const uchar* grayRow = nullptr;
+        const uchar* row = frame.pixels + k_s * frame.step;
+        const uchar* rowU = frame.chromaU + (k_s / 2) * frame.chromaStep;
+        const uchar* rowV = frame.chromaV + (k_s / 2) * frame.chromaStep;
+        const int firstSpan = rowSpanStart[k_s - yMin];
+        const int lastSpan = rowSpanStart[k_s - yMin + 1];
         
-        if (is3Channel) {
-            imageRow = image.ptr<cv::Vec3b>(k_s);
-        } else {
-            grayRow = image.ptr<uchar>(k_s);
+        // Each span is a run of in-image pixels belonging to one peripheral cell
+        for (int s = firstSpan; s < lastSpan; s++) {
+            const PlanSpan& span = spans[s];
+            
+            // Colour formats sum B, G, R; YUV formats sum Y, U, V in the same slots
+            int sumR, sumG, sumB;
+            switch (FORMAT) {
+                case PIXEL_FORMAT_BGR:
+                    sumBGR(row + 3 * span.col, span.count, sumB, sumG, sumR);  // BGR order (OpenCV's native format)
+                    break;
+                case PIXEL_FORMAT_RGB:
+                    sumBGR(row + 3 * span.col, span.count, sumR, sumG, sumB);
+                    break;
+                case PIXEL_FORMAT_BGRA:
+                    sumBGRA(row + 4 * span.col, span.count, sumB, sumG, sumR);
+                    break;
+                case PIXEL_FORMAT_NV12:
+                    sumB = sumGray(row + span.col, span.count);
+                    sumSubsampledUV(rowU, span.col, span.count, sumG, sumR);
+                    break;
+                case PIXEL_FORMAT_I420:
+                    sumB = sumGray(row + span.col, span.count);
+                    sumG = sumSubsampledChroma(rowU, span.col, span.count, sumGray);
+                    sumR = sumSubsampledChroma(rowV, span.col, span.count, sumGray);
+                    break;
+                case PIXEL_FORMAT_YUYV:
+                    sumSpanYUYV(row, span.col, span.count, sumB, sumG, sumR);
+                    break;
+                default:
+                    sumB = sumGray(row + span.col, span.count);
+                    sumG = sumB;
+                    sumR = sumB;
+                    break;
+            }
+            
+            // Private buffer - no synchronization needed
+            CellAccumulator& cell = cells[span.cell];
+            cell.r += sumR;
+            cell.g += sumG;
+            cell.b += sumB;
+            cell.count += span.count;
         }
+    }
+}
+
+// Format resolved once per region rather than per span
+static void processSpanRows(const FrameLayout& frame, int yStart, int yEnd,
+                            int yMin, const int* rowSpanStart, const PlanSpan* spans,
+                            AccumulatorBuffer& acc) {
+    switch (frame.format) {
+        case PIXEL_FORMAT_BGR:
+            processSpanRowsAs<PIXEL_FORMAT_BGR>(frame, yStart, yEnd, yMin, rowSpanStart, spans, acc);
+            break;
+        case PIXEL_FORMAT_RGB:
+            processSpanRowsAs<PIXEL_FORMAT_RGB>(frame, yStart, yEnd, yMin, rowSpanStart, spans, acc);
+            break;
+        case PIXEL_FORMAT_BGRA:
+            processSpanRowsAs<PIXEL_FORMAT_BGRA>(frame, yStart, yEnd, yMin, rowSpanStart, spans, acc);
+            break;
+        case PIXEL_FORMAT_NV12:
+            processSpanRowsAs<PIXEL_FORMAT_NV12>(frame, yStart, yEnd, yMin, rowSpanStart, spans, acc);
+            break;
+        case PIXEL_FORMAT_I420:
+            processSpanRowsAs<PIXEL_FORMAT_I420>(frame, yStart, yEnd, yMin, rowSpanStart, spans, acc);
+            break;
+        case PIXEL_FORMAT_YUYV:
+            processSpanRowsAs<PIXEL_FORMAT_YUYV>(frame, yStart, yEnd, yMin, rowSpanStart, spans, acc);
+            break;
+        default:
+            processSpanRowsAs<PIXEL_FORMAT_GRAY>(frame, yStart, yEnd, yMin, rowSpanStart, spans, acc);
+            break;
+    }
+}
+
+// Span sums of 16-bit pixels are kept exactly in 64 bits, float pixels in double
+template <typename T> struct SpanSum;
+template <> struct SpanSum<uchar> { typedef int Type; };
+template <> struct SpanSum<uint16_t> { typedef uint64_t Type; };
+template <> struct SpanSum<float> { typedef double Type; };
+
+// Squares of one 8-bit span fit 32 bits (spans are rows of one image);
+// 16-bit squares need 64 bits
+template <typename T> struct SpanSquareSum;
+template <> struct SpanSquareSum<uchar> { typedef uint32_t Type; };
+template <> struct SpanSquareSum<uint16_t> { typedef uint64_t Type; };
+template <> struct SpanSquareSum<float> { typedef double Type; };
+
+// 16-bit and float counterpart of processSpanRowsAs, specialised for the pixel
+// type and channel count so the inner loop is a plain strided sum
+template <typename T, int CN, bool SWAP_RB>
+static void processDeepSpanRows(const FrameLayout& frame, int yStart, int yEnd,
+                                int yMin, const int* rowSpanStart, const PlanSpan* spans,
+                                WideAccumulatorBuffer& acc) {
+    typedef typename SpanSum<T>::Type Sum;
+    typedef ChannelIndex<CN, SWAP_RB> Ch;
+    WideCellAccumulator* cells = acc.data();
+    
+    for (int k_s = yStart; k_s < yEnd; k_s++) {
+        const T* row = reinterpret_cast<const T*>(frame.pixels + k_s * frame.step);
+        const int firstSpan = rowSpanStart[k_s - yMin];
+        const int lastSpan = rowSpanStart[k_s - yMin + 1];
         
-        // Process pixels in chunks for better cache performance
-        for (int j_s = 0; j_s < cols; j_s++) {
-            const int i_m = i_m_base + j_s;
-            
-            // Bounds check with early exit
-            if (i_m < 0 || i_m >= cache.mapSize) continue;
+        for (int s = firstSpan; s < lastSpan; s++) {
+            const PlanSpan& span = spans[s];
+            const T* p = row + CN * span.col;
             
-            // Fast lookup instead of binary search
-            const int iCell = cache.getCellIndex(i_m);
+            Sum sums[3] = { 0, 0, 0 };
+            for (int i = 0; i < span.count; i++, p += CN) {
+                sums[0] += p[Ch::B];
+                if (CN > 1) {
+                    sums[1] += p[Ch::G];
+                    sums[2] += p[Ch::R];
+                }
+            }
+            if (CN == 1) {
+                sums[1] = sums[0];
+                sums[2] = sums[0];
+            }
             
-            // Skip fovea cells (already processed)
-            if (iCell <= lastFoveaIndex) continue;
+            WideCellAccumulator& cell = cells[span.cell];
+            cell.b += static_cast<double>(sums[0]);
+            cell.g += static_cast<double>(sums[1]);
+            cell.r += static_cast<double>(sums[2]);
+            cell.count += span.count;
+        }
+    }
+}
+
+typedef void (*DeepSpanRowsFn)(const FrameLayout&, int, int, int, const int*, const PlanSpan*, WideAccumulatorBuffer&);
+
+template <typename T>
+static DeepSpanRowsFn selectDeepSpanRows(PixelFormat format) {
+    switch (format) {
+        case PIXEL_FORMAT_BGR: return processDeepSpanRows<T, 3, false>;
+        case PIXEL_FORMAT_RGB: return processDeepSpanRows<T, 3, true>;
+        case PIXEL_FORMAT_BGRA: return processDeepSpanRows<T, 4, false>;
+        default: return processDeepSpanRows<T, 1, false>;
+    }
+}
+
+// Running statistics of one channel over a span
+template <typename T>
+struct ChannelSpanStats {
+    typename SpanSum<T>::Type sum;
+    typename SpanSquareSum<T>::Type squares;
+    T lo;
+    T hi;
+    
+    explicit ChannelSpanStats(T first) : sum(0), squares(0), lo(first), hi(first) {}
+    
+    void add(T v) {
+        sum += v;
+        squares += static_cast<typename SpanSquareSum<T>::Type>(v) * v;
+        lo = std::min(lo, v);
+        hi = std::max(hi, v);
+    }
+};
+
+// Fold a span's channel statistics into its cell's; the cell's first span
+// in this buffer (count still 0) sets them
+template <typename T>
+static inline void addChannelStats(const ChannelSpanStats<T>& span, bool first, int c,
+                                   CellStatsAccumulator& cellStat) {
+    const double square = static_cast<double>(span.squares);
+    const float minimum = static_cast<float>(span.lo);
+    const float maximum = static_cast<float>(span.hi);
+    if (first) {
+        cellStat.squares[c] = square;
+        cellStat.minimum[c] = minimum;
+        cellStat.maximum[c] = maximum;
+    } else {
+        cellStat.squares[c] += square;
+        cellStat.minimum[c] = std::min(cellStat.minimum[c], minimum);
+        cellStat.maximum[c] = std::max(cellStat.maximum[c], maximum);
+    }
+}
+
+// Statistics counterpart of the span kernels for packed frames of any depth:
+// one pass over each span gathers its sums, sums of squares, minimum and maximum
+template <typename T, int CN, bool SWAP_RB, typename Cell>
+static void processStatsSpanRows(const FrameLayout& frame, int yStart, int yEnd,
+                                 int yMin, const int* rowSpanStart, const PlanSpan* spans,
+                                 CellAccumulatorBuffer<Cell>& acc, StatsAccumulatorBuffer& stats) {
+    typedef ChannelIndex<CN, SWAP_RB> Ch;
+    Cell* cells = acc.data();
+    CellStatsAccumulator* cellStats = stats.data();
+    
+    for (int k_s = yStart; k_s < yEnd; k_s++) {
+        const T* row = reinterpret_cast<const T*>(frame.pixels + k_s * frame.step);
+        const int firstSpan = rowSpanStart[k_s - yMin];
+        const int lastSpan = rowSpanStart[k_s - yMin + 1];
+        
+        for (int s = firstSpan; s < lastSpan; s++) {
+            const PlanSpan& span = spans[s];
+            const T* p = row + CN * span.col;
             
-            // Fast pixel access
-            cv::Vec3b color;
-            if (is3Channel) {
-                color = imageRow[j_s];
-            } else {
-                const uchar intensity = grayRow[j_s];
-                color = cv::Vec3b(intensity, intensity, intensity);
+            ChannelSpanStats<T> b(p[Ch::B]), g(p[Ch::G]), r(p[Ch::R]);
+            for (int i = 0; i < span.count; i++, p += CN) {
+                b.add(p[Ch::B]);
+                if (CN > 1) {
+                    g.add(p[Ch::G]);
+                    r.add(p[Ch::R]);
+                }
+            }
+            if (CN == 1) {
+                g = b;
+                r = b;
             }
             
-            // Atomic accumulation in BGR order (OpenCV's native format)
-            atomicAccR[iCell].fetch_add(color[2], std::memory_order_relaxed);  // R channel
-            atomicAccG[iCell].fetch_add(color[1], std::memory_order_relaxed);  // G channel
-            atomicAccB[iCell].fetch_add(color[0], std::memory_order_relaxed);  // B channel
-            atomicCount[iCell].fetch_add(1, std::memory_order_relaxed);
+            Cell& cell = cells[span.cell];
+            CellStatsAccumulator& cellStat = cellStats[span.cell];
+            const bool first = cell.count == 0;
+            addChannelStats(b, first, 0, cellStat);
+            addChannelStats(g, first, 1, cellStat);
+            addChannelStats(r, first, 2, cellStat);
+            cell.b += b.sum;
+            cell.g += g.sum;
+            cell.r += r.sum;
+            cell.count += span.count;
+        }
+    }
+}
+
+template <typename T, typename Cell>
+static void processStatsRegion(const FrameLayout& frame, int yStart, int yEnd, const ScanPlan& plan,
+                               CellAccumulatorBuffer<Cell>& acc, StatsAccumulatorBuffer& stats) {
+    const int* rowSpanStart = plan.rowSpanStart.data();
+    const PlanSpan* spans = plan.spans.data();
+    switch (frame.format) {
+        case PIXEL_FORMAT_BGR:
+            processStatsSpanRows<T, 3, false>(frame, yStart, yEnd, plan.yMin, rowSpanStart, spans, acc, stats);
+            break;
+        case PIXEL_FORMAT_RGB:
+            processStatsSpanRows<T, 3, true>(frame, yStart, yEnd, plan.yMin, rowSpanStart, spans, acc, stats);
+            break;
+        case PIXEL_FORMAT_BGRA:
+            processStatsSpanRows<T, 4, false>(frame, yStart, yEnd, plan.yMin, rowSpanStart, spans, acc, stats);
+            break;
+        default:
+            processStatsSpanRows<T, 1, false>(frame, yStart, yEnd, plan.yMin, rowSpanStart, spans, acc, stats);
+            break;
+    }
+}
+
+void optimizedProcessImageRegion(const FrameLayout& frame, int yStart, int yEnd,
+                               const ScanPlan& plan,
+                               AccumulatorBuffer& acc, StatsAccumulatorBuffer& stats) {
+    processStatsRegion<uchar>(frame, yStart, yEnd, plan, acc, stats);
+}
+
+void optimizedProcessImageRegion(const FrameLayout& frame, int yStart, int yEnd,
+                               const ScanPlan& plan,
+                               WideAccumulatorBuffer& acc, StatsAccumulatorBuffer& stats) {
+    if (frame.depth == CV_16U) {
+        processStatsRegion<uint16_t>(frame, yStart, yEnd, plan, acc, stats);
+    } else {
+        processStatsRegion<float>(frame, yStart, yEnd, plan, acc, stats);
+    }
+}
+
+static void resizeCellStatistics(LPXCellStatistics& statistics, int nMaxCells) {
+    const size_t size = 3 * static_cast<size_t>(nMaxCells);
+    statistics.variance.resize(size);
+    statistics.minimum.resize(size);
+    statistics.maximum.resize(size);
+}
+
+static void clearCellStatistics(LPXCellStatistics& statistics, int cellStart, int cellEnd) {
+    if (cellEnd <= cellStart) {
+        return;
+    }
+    std::fill(statistics.variance.begin() + 3 * cellStart, statistics.variance.begin() + 3 * cellEnd, 0.0f);
+    std::fill(statistics.minimum.begin() + 3 * cellStart, statistics.minimum.begin() + 3 * cellEnd, 0.0f);
+    std::fill(statistics.maximum.begin() + 3 * cellStart, statistics.maximum.begin() + 3 * cellEnd, 0.0f);
+}
+
+template <typename T, int CN, bool SWAP_RB>
+static void gatherFoveaStatisticsAs(const FrameLayout& frame, const ScanPlan& plan, LPXCellStatistics& statistics) {
+    typedef ChannelIndex<CN, SWAP_RB> Ch;
+    const PlanFoveaPixel* pixels = plan.fovea.data();
+    const int n = static_cast<int>(plan.fovea.size());
+    
+    for (int i = 0; i < n; i++) {
+        const T* p = reinterpret_cast<const T*>(frame.pixels + pixels[i].offset);
+        const float value[3] = { static_cast<float>(p[Ch::B]), static_cast<float>(p[Ch::G]),
+                                 static_cast<float>(p[Ch::R]) };
+        const size_t base = 3 * static_cast<size_t>(pixels[i].cell);
+        for (int c = 0; c < 3; c++) {
+            statistics.variance[base + c] = 0.0f;
+            statistics.minimum[base + c] = value[c];
+            statistics.maximum[base + c] = value[c];
+        }
+    }
+}
+
+template <typename T>
+static void gatherFoveaStatisticsAs(const FrameLayout& frame, const ScanPlan& plan, LPXCellStatistics& statistics) {
+    switch (frame.format) {
+        case PIXEL_FORMAT_BGR: gatherFoveaStatisticsAs<T, 3, false>(frame, plan, statistics); break;
+        case PIXEL_FORMAT_RGB: gatherFoveaStatisticsAs<T, 3, true>(frame, plan, statistics); break;
+        case PIXEL_FORMAT_BGRA: gatherFoveaStatisticsAs<T, 4, false>(frame, plan, statistics); break;
+        default: gatherFoveaStatisticsAs<T, 1, false>(frame, plan, statistics); break;
+    }
+}
+
+void gatherFoveaStatistics(const FrameLayout& frame, const ScanPlan& plan, LPXCellStatistics& statistics) {
+    if (!plan.foveaCovered) {
+        clearCellStatistics(statistics, plan.cellStart, plan.foveaCells);
+    }
+    if (frame.depth == CV_16U) {
+        gatherFoveaStatisticsAs<uint16_t>(frame, plan, statistics);
+    } else if (frame.depth == CV_32F) {
+        gatherFoveaStatisticsAs<float>(frame, plan, statistics);
+    } else {
+        gatherFoveaStatisticsAs<uchar>(frame, plan, statistics);
+    }
+}
+
+template <typename Cell>
+static void mergeCellStatisticsAs(const CellAccumulatorBuffer<Cell>* buffers, const StatsAccumulatorBuffer* stats,
+                                  int numBuffers, int cellStart, int cellEnd, int lastFoveaIndex,
+                                  LPXCellStatistics& statistics) {
+    for (int i = cellStart; i < cellEnd; i++) {
+        double sums[3] = { 0.0, 0.0, 0.0 };
+        double squares[3] = { 0.0, 0.0, 0.0 };
+        float lo[3] = { 0.0f, 0.0f, 0.0f };
+        float hi[3] = { 0.0f, 0.0f, 0.0f };
+        int64_t pixelCount = 0;
+        for (int t = 0; t < numBuffers; t++) {
+            const Cell& cell = buffers[t].data()[i];
+            if (cell.count == 0) {
+                continue;  // Its statistics were never set
+            }
+            const CellStatsAccumulator& cellStat = stats[t].data()[i];
+            for (int c = 0; c < 3; c++) {
+                squares[c] += cellStat.squares[c];
+                lo[c] = (pixelCount == 0) ? cellStat.minimum[c] : std::min(lo[c], cellStat.minimum[c]);
+                hi[c] = (pixelCount == 0) ? cellStat.maximum[c] : std::max(hi[c], cellStat.maximum[c]);
+            }
+            sums[0] += cell.b;
+            sums[1] += cell.g;
+            sums[2] += cell.r;
+            pixelCount += cell.count;
+        }
+        
+        if (pixelCount == 0 && i <= lastFoveaIndex) {
+            continue;  // Fovea cells were filled by the gather
+        }
+        const size_t base = 3 * static_cast<size_t>(i);
+        for (int c = 0; c < 3; c++) {
+            double variance = 0.0;
+            if (pixelCount > 0) {
+                const double mean = sums[c] / pixelCount;
+                variance = std::max(0.0, squares[c] / pixelCount - mean * mean);
+            }
+            statistics.variance[base + c] = static_cast<float>(variance);
+            statistics.minimum[base + c] = lo[c];
+            statistics.maximum[base + c] = hi[c];
+        }
+    }
+}
+
+void mergeCellStatistics(const AccumulatorBuffer* buffers, const StatsAccumulatorBuffer* stats, int numBuffers,
+                         int cellStart, int cellEnd, int lastFoveaIndex, LPXCellStatistics& statistics) {
+    mergeCellStatisticsAs(buffers, stats, numBuffers, cellStart, cellEnd, lastFoveaIndex, statistics);
+}
+
+void mergeCellStatistics(const WideAccumulatorBuffer* buffers, const StatsAccumulatorBuffer* stats, int numBuffers,
+                         int cellStart, int cellEnd, int lastFoveaIndex, LPXCellStatistics& statistics) {
+    mergeCellStatisticsAs(buffers, stats, numBuffers, cellStart, cellEnd, lastFoveaIndex, statistics);
+}
+
+// Optimized region processing with minimal overhead
+void optimizedProcessImageRegion(const FrameLayout& frame, int yStart, int yEnd,
+                               const ScanPlan& plan,
+                               AccumulatorBuffer& acc) {
+    processSpanRows(frame, yStart, yEnd, plan.yMin, plan.rowSpanStart.data(), plan.spans.data(), acc);
+}
+
+void optimizedProcessImageRegion(const FrameLayout& frame, int yStart, int yEnd,
+                               const ScanPlan& plan,
+                               WideAccumulatorBuffer& acc) {
+    const DeepSpanRowsFn processRows = (frame.depth == CV_16U) ? selectDeepSpanRows<uint16_t>(frame.format)
+                                                               : selectDeepSpanRows<float>(frame.format);
+    processRows(frame, yStart, yEnd, plan.yMin, plan.rowSpanStart.data(), plan.spans.data(), acc);
+}
+
+void optimizedProcessImageRegion(const FrameLayout& frame, int yStart, int yEnd,
+                               const ScanPlanLevel& level,
+                               AccumulatorBuffer& acc) {
+    processSpanRows(frame, yStart, yEnd, level.yMin, level.rowSpanStart.data(), level.spans.data(), acc);
+}
+
+// The kernels index rows from band.pixels, so image rows are shifted to band rows
+void optimizedProcessImageBand(const FrameLayout& band, int bandFirstRow, int yStart, int yEnd,
+                               const ScanPlan& plan,
+                               AccumulatorBuffer& acc) {
+    processSpanRows(band, yStart - bandFirstRow, yEnd - bandFirstRow, plan.yMin - bandFirstRow,
+                    plan.rowSpanStart.data(), plan.spans.data(), acc);
+}
+
+void optimizedProcessImageBand(const FrameLayout& band, int bandFirstRow, int yStart, int yEnd,
+                               const ScanPlan& plan,
+                               WideAccumulatorBuffer& acc) {
+    const DeepSpanRowsFn processRows = (band.depth == CV_16U) ? selectDeepSpanRows<uint16_t>(band.format)
+                                                              : selectDeepSpanRows<float>(band.format);
+    processRows(band, yStart - bandFirstRow, yEnd - bandFirstRow, plan.yMin - bandFirstRow,
+                plan.rowSpanStart.data(), plan.spans.data(), acc);
+}
+
+// Reduce the worker buffers for a range of cells and compute the cell colors
+void mergeCellRange(const AccumulatorBuffer* buffers, int numBuffers,
+                    int cellStart, int cellEnd, int lastFoveaIndex, bool yuvSums, bool rainbowMode,
+                    std::vector<uint32_t>& cellArray, float* precise) {
+    for (int i = cellStart; i < cellEnd; i++) {
+        if (rainbowMode) {
+            // Generate rainbow pattern that repeats every viewlength
+            cellArray[i] = generateRainbowColor(i, 1323);
+            if (precise) storePrecise(precise + 3 * i, cellArray[i]);
+            continue;
+        }
+        
+        int r = 0, g = 0, b = 0, pixelCount = 0;
+        for (int t = 0; t < numBuffers; t++) {
+            const CellAccumulator& cell = buffers[t].data()[i];
+            r += cell.r;
+            g += cell.g;
+            b += cell.b;
+            pixelCount += cell.count;
+        }
+        
+        if (pixelCount > 0 && yuvSums) {
+            // Colour conversion once per cell on the averaged Y, U, V
+            const float scale = 1.0f / pixelCount;
+            cellArray[i] = packYUVAsBGR(b * scale, g * scale, r * scale);
+            if (precise) storePrecise(precise + 3 * i, cellArray[i]);
+        } else if (pixelCount > 0) {
+            // Pack in BGR format (OpenCV's native format)
+            cellArray[i] = (b / pixelCount) | ((g / pixelCount) << 8) | ((r / pixelCount) << 16);
+            if (precise) {
+                const double scale = 1.0 / pixelCount;
+                storePrecise(precise + 3 * i, b * scale, g * scale, r * scale);
+            }
+        } else if (i > lastFoveaIndex) {
+            cellArray[i] = 0;  // Black for empty peripheral cells
+            if (precise) storePrecise(precise + 3 * i, 0u);
+        }
+    }
+}
+
+void mergeCellRange(const WideAccumulatorBuffer* buffers, int numBuffers,
+                    int cellStart, int cellEnd, int lastFoveaIndex, int depth, bool rainbowMode,
+                    std::vector<uint32_t>& cellArray, float* precise) {
+    const double toByte = getDeepToByteScale(depth);
+    for (int i = cellStart; i < cellEnd; i++) {
+        if (rainbowMode) {
+            cellArray[i] = generateRainbowColor(i, 1323);
+            if (precise) storePrecise(precise + 3 * i, cellArray[i]);
+            continue;
+        }
+        
+        double r = 0.0, g = 0.0, b = 0.0;
+        int64_t pixelCount = 0;
+        for (int t = 0; t < numBuffers; t++) {
+            const WideCellAccumulator& cell = buffers[t].data()[i];
+            r += cell.r;
+            g += cell.g;
+            b += cell.b;
+            pixelCount += cell.count;
+        }
+        
+        if (pixelCount > 0) {
+            const double scale = 1.0 / pixelCount;
+            cellArray[i] = packDeepBGR(b * scale, g * scale, r * scale, toByte);
+            if (precise) storePrecise(precise + 3 * i, b * scale, g * scale, r * scale);
+        } else if (i > lastFoveaIndex) {
+            cellArray[i] = 0;
+            if (precise) storePrecise(precise + 3 * i, 0u);
         }
     }
 }
 
 // High-performance multithreaded scan with optimizations
-bool optimizedMultithreadedScan(LPXImage* lpxImage, const cv::Mat& image, float x_center, float y_center) {
+bool optimizedMultithreadedScan(LPXImage* lpxImage, const cv::Mat& image, float x_center, float y_center,
+                                PixelFormat format, cv::Size scanSize, int firstCell, int lastCell) {
+    auto sct = lpxImage->getScanTables();
+    if (!sct || !sct->isInitialized()) {
+        return false;
+    }
+    return optimizedMultithreadedScan(getDefaultScanContext(sct), lpxImage, image, x_center, y_center,
+                                      format, scanSize, firstCell, lastCell);
+}
+
+bool optimizedMultithreadedScan(const ScanContext& context, LPXImage* lpxImage, const cv::Mat& image,
+                                float x_center, float y_center,
+                                PixelFormat format, cv::Size scanSize, int firstCell, int lastCell) {
     // Starting optimized multithreaded scan
     auto totalStart = std::chrono::high_resolution_clock::now();
     
     auto sct = lpxImage->getScanTables();
-    if (!sct || !sct->isInitialized() || image.empty()) {
+    if (!sct || !sct->isInitialized() || image.empty() || !usesContextTables(context, lpxImage)) {
         return false;
     }
     
-    // Initialize cache if needed
-    g_scanCache.initialize(sct);
+    // Locate the planes of the frame; it is read in its native layout
+    FrameLayout frame;
+    if (!describeFrame(image, format, frame)) {
+        LOG_ERROR(std::string("Image does not match pixel format ") + getPixelFormatName(format));
+        return false;
+    }
     
-    // Get direct access to arrays
-    auto& cellArray = lpxImage->accessCellArray();
-    auto& accR = lpxImage->accessAccR();
-    auto& accG = lpxImage->accessAccG();
-    auto& accB = lpxImage->accessAccB();
-    auto& count = lpxImage->accessCount();
+    // Fused resize: the plan maps the resized grid back onto the source pixels
+    if (scanSize.width > 0 && scanSize.height > 0) {
+        frame.scanWidth = scanSize.width;
+        frame.scanHeight = scanSize.height;
+    }
     
+    // Get direct access to arrays; every cell is rewritten, so a reused image needs no reset
+    auto& cellArray = lpxImage->accessCellArray();
     const int nMaxCells = lpxImage->getMaxCells();
+    cellArray.resize(nMaxCells);  // Images loaded from file may hold fewer cells
+    
+    // Optional high-precision cell means, 3 per cell
+    float* precise = nullptr;
+    if (lpxImage->hasPreciseOutput()) {
+        std::vector<float>& preciseCells = lpxImage->accessPreciseCellArray();
+        preciseCells.resize(3 * static_cast<size_t>(nMaxCells));
+        precise = preciseCells.data();
+    }
+    
+    // Optional variance, minimum and maximum per cell, gathered in the same pass
+    LPXCellStatistics* statistics = nullptr;
+    if (lpxImage->hasCellStatistics()) {
+        if (frame.isYUV()) {
+            LOG_ERROR("Cell statistics need a packed pixel format");
+            return false;
+        }
+        statistics = &lpxImage->accessCellStatistics();
+        resizeCellStatistics(*statistics, nMaxCells);
+    }
     
     // Set position
     lpxImage->setPosition(x_center, y_center);
     
-    // Fast reset using memset
-    std::fill(accR.begin(), accR.end(), 0);
-    std::fill(accG.begin(), accG.end(), 0);
-    std::fill(accB.begin(), accB.end(), 0);
-    std::fill(count.begin(), count.end(), 0);
+    // Plan for this image size and fixation, reused while the center stays put
+    std::shared_ptr<const ScanPlan> plan = context.plans->get(*context.spans, nMaxCells, frame,
+                                                              x_center, y_center, 0, firstCell, lastCell);
+    const int cellStart = plan->cellStart;
+    const int cellEnd = plan->cellEnd;
+    
+    // 16-bit and float frames sum into wide accumulators
+    const bool deep = frame.depth != CV_8U;
+    
+    // STEP 1: Peripheral processing into private per-thread accumulators,
+    // with the fovea gathered alongside as one more task
+    auto peripheralStart = std::chrono::high_resolution_clock::now();
     
-    auto resetTime = std::chrono::high_resolution_clock::now();
+    const int yMin = plan->yMin;
+    const int yMax = plan->yMax;
     
-    // STEP 1: Fast fovea processing (minimal overhead)
-    const int w_m = sct->mapWidth;
-    const int scanMapCenterX = w_m / 2;
-    const int scanMapCenterY = w_m / 2;
+    // Only use multithreading for significant work (more than 10 rows per thread)
+    ScanThreadPool& pool = *context.pool;
+    auto poolLock = pool.acquire();
+    std::vector<AccumulatorBuffer>& buffers = pool.accumulators();
+    std::vector<WideAccumulatorBuffer>& wideBuffers = pool.wideAccumulators();
+    std::vector<StatsAccumulatorBuffer>& statsBuffers = pool.statsAccumulators();
+    const int numBands = std::max(1, std::min(static_cast<int>(pool.size()), (yMax - yMin) / 11));
+    const int rowsPerBand = (yMax - yMin) / numBands;
+    const int lastFoveaIndex = sct->lastFoveaIndex;
     
-    // Process fovea with minimal function call overhead
-    for (int i = 0; i < sct->innerLength; i++) {
-        const int x = static_cast<int>(x_center + sct->innerCells[i].x - scanMapCenterX);
-        const int y = static_cast<int>(y_center + sct->innerCells[i].y - scanMapCenterY);
+    // Each band sums into its own pre-allocated buffer and zeroes it on the
+    // thread that scans it, so its pages stay near that core
+    auto scanBand = [&](int band, int) {
+        if (band == numBands) {
+            // Fovea cells are disjoint from the peripheral buffers
+            gatherFoveaPixels(frame, *plan, cellArray, precise);
+            if (statistics) gatherFoveaStatistics(frame, *plan, *statistics);
+            return;
+        }
+        
+        const int startRow = yMin + band * rowsPerBand;
+        const int endRow = (band == numBands - 1) ? yMax : startRow + rowsPerBand;
         
-        if (x >= 0 && x < image.cols && y >= 0 && y < image.rows) {
-            cv::Vec3b color;
-            if (image.channels() == 3) {
-                color = image.at<cv::Vec3b>(y, x);
+        // Statistics buffers need no clearing; a cell's first span sets them
+        if (statistics) {
+            statsBuffers[band].resize(nMaxCells);
+        }
+        if (deep) {
+            wideBuffers[band].resize(nMaxCells);
+            wideBuffers[band].clear(cellStart, cellEnd);
+            if (statistics) {
+                optimizedProcessImageRegion(frame, startRow, endRow, *plan, wideBuffers[band], statsBuffers[band]);
             } else {
-                const uchar intensity = image.at<uchar>(y, x);
-                color = cv::Vec3b(intensity, intensity, intensity);
+                optimizedProcessImageRegion(frame, startRow, endRow, *plan, wideBuffers[band]);
             }
-            
-            const int cellIndex = (i <= sct->lastFoveaIndex && i < static_cast<int>(cellArray.size())) ? i : sct->outerPixelCellIdx[i];
-            if (cellIndex >= 0 && cellIndex < static_cast<int>(cellArray.size())) {
-                // Pack color in BGR format (OpenCV's native format)
-                cellArray[cellIndex] = (color[0]) | (color[1] << 8) | (color[2] << 16);
+            return;
+        }
+        buffers[band].resize(nMaxCells);
+        buffers[band].clear(cellStart, cellEnd);
+        if (statistics) {
+            optimizedProcessImageRegion(frame, startRow, endRow, *plan, buffers[band], statsBuffers[band]);
+        } else {
+            optimizedProcessImageRegion(frame, startRow, endRow, *plan, buffers[band]);
+        }
+    };
+    pool.parallelFor(numBands + 1, scanBand);
+    
+    auto peripheralEnd = std::chrono::high_resolution_clock::now();
+    
+    // STEP 2: Cell-partitioned merge and color computation
+    auto colorStart = std::chrono::high_resolution_clock::now();
+    
+    // Check if rainbow mode is enabled
+    const bool rainbowMode = isRainbowModeEnabled();
+    
+    // Split the scanned cells into cache-line aligned ranges, one per band
+    const int firstLine = cellStart / AccumulatorBuffer::CELLS_PER_LINE;
+    const int lastLine = (cellEnd + AccumulatorBuffer::CELLS_PER_LINE - 1) / AccumulatorBuffer::CELLS_PER_LINE;
+    const int linesPerRange = std::max(1, (lastLine - firstLine + numBands - 1) / numBands);
+    const int cellsPerRange = linesPerRange * AccumulatorBuffer::CELLS_PER_LINE;
+    
+    auto mergeRange = [&](int range, int) {
+        const int rangeStart = firstLine * AccumulatorBuffer::CELLS_PER_LINE + range * cellsPerRange;
+        const int rangeEnd = std::min(cellEnd, rangeStart + cellsPerRange);
+        const int mergeStart = std::max(cellStart, std::min(cellEnd, rangeStart));
+        if (deep) {
+            mergeCellRange(wideBuffers.data(), numBands, mergeStart, rangeEnd,
+                           lastFoveaIndex, frame.depth, rainbowMode, cellArray, precise);
+            if (statistics) {
+                mergeCellStatistics(wideBuffers.data(), statsBuffers.data(), numBands, mergeStart, rangeEnd,
+                                    lastFoveaIndex, *statistics);
+            }
+        } else {
+            mergeCellRange(buffers.data(), numBands, mergeStart, rangeEnd,
+                           lastFoveaIndex, frame.isYUV(), rainbowMode, cellArray, precise);
+            if (statistics) {
+                mergeCellStatistics(buffers.data(), statsBuffers.data(), numBands, mergeStart, rangeEnd,
+                                    lastFoveaIndex, *statistics);
             }
         }
+    };
+    pool.parallelFor(numBands, mergeRange);
+    
+    // Cells outside a partial scan's range are left empty
+    std::fill(cellArray.begin(), cellArray.begin() + cellStart, 0u);
+    std::fill(cellArray.begin() + cellEnd, cellArray.end(), 0u);
+    if (precise) {
+        std::fill(precise, precise + 3 * cellStart, 0.0f);
+        std::fill(precise + 3 * cellEnd, precise + 3 * nMaxCells, 0.0f);
+    }
+    if (statistics) {
+        clearCellStatistics(*statistics, 0, cellStart);
+        clearCellStatistics(*statistics, cellEnd, nMaxCells);
     }
+    lpxImage->setLength(nMaxCells);
     
-    auto foveaTime = std::chrono::high_resolution_clock::now();
+    // Opponent-colour planes from the finished cells
+    if (lpxImage->hasOpponentOutput()) {
+        lpxImage->updateOpponentCells();
+    }
     
-    // STEP 2: Optimized peripheral processing with lock-free atomics
-    auto peripheralStart = std::chrono::high_resolution_clock::now();
+    auto totalEnd = std::chrono::high_resolution_clock::now();
     
-    // Use atomic accumulators to eliminate mutex overhead
-    std::vector<std::atomic<int>> atomicAccR(nMaxCells);
-    std::vector<std::atomic<int>> atomicAccG(nMaxCells);
-    std::vector<std::atomic<int>> atomicAccB(nMaxCells);
-    std::vector<std::atomic<int>> atomicCount(nMaxCells);
+    // Timing calculations removed
     
-    // Initialize atomics
-    for (int i = 0; i < nMaxCells; i++) {
-        atomicAccR[i].store(0, std::memory_order_relaxed);
-        atomicAccG[i].store(0, std::memory_order_relaxed);
-        atomicAccB[i].store(0, std::memory_order_relaxed);
-        atomicCount[i].store(0, std::memory_order_relaxed);
+    return true;
+}
+
+bool optimizedScanBatch(const std::vector<LPXImage*>& lpxImages, const std::vector<cv::Mat>& images,
+                        const std::vector<cv::Point2f>& centers, PixelFormat format,
+                        std::vector<char>* frameScanned) {
+    if (lpxImages.empty()) {
+        if (frameScanned) frameScanned->clear();
+        return images.empty();
+    }
+    auto sct = lpxImages[0]->getScanTables();
+    if (!sct || !sct->isInitialized()) {
+        return false;
+    }
+    return optimizedScanBatch(getDefaultScanContext(sct), lpxImages, images, centers, format, frameScanned);
+}
+
+// Batch scan: frames are independent, so each worker scans whole frames on
+// its own and no band results need merging
+bool optimizedScanBatch(const ScanContext& context, const std::vector<LPXImage*>& lpxImages,
+                        const std::vector<cv::Mat>& images, const std::vector<cv::Point2f>& centers,
+                        PixelFormat format, std::vector<char>* frameScanned) {
+    const int numFrames = static_cast<int>(images.size());
+    if (lpxImages.size() != images.size() || centers.empty() ||
+        (centers.size() != 1 && centers.size() != images.size())) {
+        LOG_ERROR("Batch scan needs one LPXImage per frame and one center per frame (or a single center)");
+        return false;
+    }
+    for (LPXImage* lpxImage : lpxImages) {
+        if (!usesContextTables(context, lpxImage)) {
+            return false;
+        }
     }
     
-    // Calculate processing bounds
-    const float spiralRadius = getSpiralRadius(nMaxCells, sct->spiralPer);
-    const int spRad = static_cast<int>(spiralRadius + 0.5f);
+    std::vector<char> scannedStorage;
+    std::vector<char>& scanned = frameScanned ? *frameScanned : scannedStorage;
+    scanned.assign(numFrames, 0);
     
-    int yMin = std::max(0, static_cast<int>(y_center - spRad));
-    int yMax = std::min(image.rows, static_cast<int>(y_center + spRad));
+    const int lastFoveaIndex = context.spans->sct->lastFoveaIndex;
+    const bool rainbowMode = isRainbowModeEnabled();
     
-    // Use optimal number of threads (avoid oversubscription)
-    const unsigned int numThreads = std::min(4u, std::thread::hardware_concurrency());
-    const int rowsPerThread = (yMax - yMin) / numThreads;
+    ScanThreadPool& pool = *context.pool;
+    auto poolLock = pool.acquire();
+    std::vector<AccumulatorBuffer>& buffers = pool.accumulators();
+    std::vector<WideAccumulatorBuffer>& wideBuffers = pool.wideAccumulators();
+    std::vector<StatsAccumulatorBuffer>& statsBuffers = pool.statsAccumulators();
     
-    if (rowsPerThread > 10) {  // Only use multithreading for significant work
-        std::vector<std::future<void>> futures;
+    auto scanFrame = [&](int f, int worker) {
+        FrameLayout frame;
+        if (images[f].empty() || !describeFrame(images[f], format, frame)) {
+            return;
+        }
         
-        for (unsigned int t = 0; t < numThreads; t++) {
-            const int startRow = yMin + t * rowsPerThread;
-            const int endRow = (t == numThreads - 1) ? yMax : startRow + rowsPerThread;
-            
-            futures.push_back(std::async(std::launch::async,
-                optimizedProcessImageRegion,
-                std::ref(image), startRow, endRow,
-                x_center, y_center,
-                std::ref(g_scanCache),
-                scanMapCenterX, scanMapCenterY,
-                w_m, sct->lastFoveaIndex,
-                std::ref(atomicAccR), std::ref(atomicAccG),
-                std::ref(atomicAccB), std::ref(atomicCount)
-            ));
+        LPXImage* lpxImage = lpxImages[f];
+        if (lpxImage->hasCellStatistics() && frame.isYUV()) {
+            return;
         }
+        const cv::Point2f& center = centers[centers.size() == 1 ? 0 : f];
+        const int nMaxCells = lpxImage->getMaxCells();
+        auto& cellArray = lpxImage->accessCellArray();
+        cellArray.resize(nMaxCells);
+        lpxImage->setPosition(center.x, center.y);
         
-        // Wait for completion
-        for (auto& future : futures) {
-            future.wait();
+        float* precise = nullptr;
+        if (lpxImage->hasPreciseOutput()) {
+            lpxImage->accessPreciseCellArray().resize(3 * static_cast<size_t>(nMaxCells));
+            precise = lpxImage->accessPreciseCellArray().data();
         }
-    } else {
-        // Single-threaded for small workloads
-        std::mutex dummyMutex;  // Not used in optimized version
-        optimizedProcessImageRegion(image, yMin, yMax,
-                                  x_center, y_center,
-                                  g_scanCache,
-                                  scanMapCenterX, scanMapCenterY,
-                                  w_m, sct->lastFoveaIndex,
-                                  atomicAccR, atomicAccG,
-                                  atomicAccB, atomicCount);
+        
+        LPXCellStatistics* statistics = nullptr;
+        StatsAccumulatorBuffer& statsBuffer = statsBuffers[worker];
+        if (lpxImage->hasCellStatistics()) {
+            statistics = &lpxImage->accessCellStatistics();
+            resizeCellStatistics(*statistics, nMaxCells);
+            statsBuffer.resize(nMaxCells);
+        }
+        
+        std::shared_ptr<const ScanPlan> plan = context.plans->get(*context.spans, nMaxCells, frame,
+                                                                  center.x, center.y);
+        
+        gatherFoveaPixels(frame, *plan, cellArray, precise);
+        if (statistics) {
+            gatherFoveaStatistics(frame, *plan, *statistics);
+        }
+        if (frame.depth != CV_8U) {
+            WideAccumulatorBuffer& buffer = wideBuffers[worker];
+            buffer.resize(nMaxCells);
+            buffer.clear();
+            if (statistics) {
+                optimizedProcessImageRegion(frame, plan->yMin, plan->yMax, *plan, buffer, statsBuffer);
+                mergeCellStatistics(&buffer, &statsBuffer, 1, 0, nMaxCells, lastFoveaIndex, *statistics);
+            } else {
+                optimizedProcessImageRegion(frame, plan->yMin, plan->yMax, *plan, buffer);
+            }
+            mergeCellRange(&buffer, 1, 0, nMaxCells, lastFoveaIndex, frame.depth, rainbowMode, cellArray, precise);
+        } else {
+            AccumulatorBuffer& buffer = buffers[worker];
+            buffer.resize(nMaxCells);
+            buffer.clear();
+            if (statistics) {
+                optimizedProcessImageRegion(frame, plan->yMin, plan->yMax, *plan, buffer, statsBuffer);
+                mergeCellStatistics(&buffer, &statsBuffer, 1, 0, nMaxCells, lastFoveaIndex, *statistics);
+            } else {
+                optimizedProcessImageRegion(frame, plan->yMin, plan->yMax, *plan, buffer);
+            }
+            mergeCellRange(&buffer, 1, 0, nMaxCells, lastFoveaIndex, frame.isYUV(), rainbowMode, cellArray, precise);
+        }
+        
+        lpxImage->setLength(nMaxCells);
+        if (lpxImage->hasOpponentOutput()) {
+            lpxImage->updateOpponentCells();
+        }
+        scanned[f] = 1;
+    };
+    pool.parallelFor(numFrames, scanFrame);
+    
+    const int numScanned = static_cast<int>(std::count(scanned.begin(), scanned.end(), 1));
+    if (numScanned < numFrames) {
+        LOG_ERROR(std::to_string(numFrames - numScanned) + " batch frames do not match pixel format " +
+                  getPixelFormatName(format));
+        return false;
+    }
+    return true;
+}
+
+// Formats whose rows can be reduced to per-channel prefix sums
+static bool hasRowPrefixSums(PixelFormat format) {
+    return format == PIXEL_FORMAT_BGR || format == PIXEL_FORMAT_RGB ||
+           format == PIXEL_FORMAT_BGRA || format == PIXEL_FORMAT_GRAY;
+}
+
+// Running sums of one image row in file channel order, so the sum of any span
+// is the difference of two entries. Grayscale keeps one channel, colour three.
+static void computeRowPrefixSums(const FrameLayout& frame, const uchar* row, std::vector<int>& prefix) {
+    const int width = frame.width;
+    if (frame.format == PIXEL_FORMAT_GRAY) {
+        prefix.resize(width + 1);
+        int sum = 0;
+        prefix[0] = 0;
+        for (int x = 0; x < width; x++) {
+            sum += row[x];
+            prefix[x + 1] = sum;
+        }
+        return;
     }
     
-    auto peripheralEnd = std::chrono::high_resolution_clock::now();
+    const int pixelSize = frame.pixelSize;
+    prefix.resize(3 * (width + 1));
+    int* out = prefix.data();
+    int c0 = 0, c1 = 0, c2 = 0;
+    out[0] = out[1] = out[2] = 0;
+    for (int x = 0; x < width; x++) {
+        const uchar* p = row + x * pixelSize;
+        c0 += p[0];
+        c1 += p[1];
+        c2 += p[2];
+        out += 3;
+        out[0] = c0;
+        out[1] = c1;
+        out[2] = c2;
+    }
+}
+
+// Accumulate the spans of one plan row from the row's prefix sums
+static void accumulatePrefixSpans(const FrameLayout& frame, const int* prefix,
+                                  const PlanSpan* spans, int firstSpan, int lastSpan,
+                                  CellAccumulator* cells) {
+    if (frame.format == PIXEL_FORMAT_GRAY) {
+        for (int s = firstSpan; s < lastSpan; s++) {
+            const PlanSpan& span = spans[s];
+            const int sum = prefix[span.col + span.count] - prefix[span.col];
+            CellAccumulator& cell = cells[span.cell];
+            cell.r += sum;
+            cell.g += sum;
+            cell.b += sum;
+            cell.count += span.count;
+        }
+        return;
+    }
     
-    // STEP 3: Fast color computation
-    auto colorStart = std::chrono::high_resolution_clock::now();
+    // RGB rows hold red in the first channel
+    const bool rgb = (frame.format == PIXEL_FORMAT_RGB);
+    for (int s = firstSpan; s < lastSpan; s++) {
+        const PlanSpan& span = spans[s];
+        const int* lo = prefix + 3 * span.col;
+        const int* hi = prefix + 3 * (span.col + span.count);
+        const int c0 = hi[0] - lo[0];
+        const int c1 = hi[1] - lo[1];
+        const int c2 = hi[2] - lo[2];
+        CellAccumulator& cell = cells[span.cell];
+        cell.b += rgb ? c2 : c0;
+        cell.g += c1;
+        cell.r += rgb ? c0 : c2;
+        cell.count += span.count;
+    }
+}
+
+bool optimizedMultithreadedScanMultiple(const std::vector<LPXImage*>& lpxImages, const cv::Mat& image,
+                                        const std::vector<cv::Point2f>& centers,
+                                        PixelFormat format) {
+    if (lpxImages.empty()) {
+        return !image.empty() && centers.empty();
+    }
+    auto sct = lpxImages[0]->getScanTables();
+    if (!sct || !sct->isInitialized()) {
+        return false;
+    }
+    return optimizedMultithreadedScanMultiple(getDefaultScanContext(sct), lpxImages, image, centers, format);
+}
+
+// Multi-fixation scan: one pass over the image rows feeds every fixation
+bool optimizedMultithreadedScanMultiple(const ScanContext& context, const std::vector<LPXImage*>& lpxImages,
+                                        const cv::Mat& image, const std::vector<cv::Point2f>& centers,
+                                        PixelFormat format) {
+    const int numCenters = static_cast<int>(centers.size());
+    if (image.empty() || lpxImages.size() != centers.size()) {
+        return false;
+    }
+    if (numCenters == 0) {
+        return true;
+    }
     
-    // Check if rainbow mode is enabled
-    const bool rainbowMode = isRainbowModeEnabled();
-    // Rainbow mode check completed
+    auto sct = lpxImages[0]->getScanTables();
+    if (!sct || !sct->isInitialized()) {
+        return false;
+    }
+    const int nMaxCells = lpxImages[0]->getMaxCells();
+    for (LPXImage* lpxImage : lpxImages) {
+        if (!usesContextTables(context, lpxImage) || lpxImage->getMaxCells() != nMaxCells) {
+            return false;
+        }
+        if (lpxImage->hasCellStatistics()) {
+            LOG_ERROR("Multi-fixation scans do not gather cell statistics");
+            return false;
+        }
+    }
     
-    // Convert atomic results back to regular arrays and compute averages
-    for (int i = 0; i < nMaxCells; i++) {
-        if (rainbowMode) {
-            // Generate rainbow pattern that repeats every viewlength
-            cellArray[i] = generateRainbowColor(i, 1323);
-        } else {
-            // Normal color computation
-            const int pixelCount = atomicCount[i].load(std::memory_order_relaxed);
-            if (pixelCount > 0) {
-                const int r = atomicAccR[i].load(std::memory_order_relaxed) / pixelCount;
-                const int g = atomicAccG[i].load(std::memory_order_relaxed) / pixelCount;
-                const int b = atomicAccB[i].load(std::memory_order_relaxed) / pixelCount;
-                // Pack in BGR format (OpenCV's native format)
-                cellArray[i] = b | (g << 8) | (r << 16);  // BGR format
-            } else if (i > sct->lastFoveaIndex) {
-                cellArray[i] = 0;  // Black for empty peripheral cells
+    FrameLayout frame;
+    if (!describeFrame(image, format, frame)) {
+        LOG_ERROR(std::string("Image does not match pixel format ") + getPixelFormatName(format));
+        return false;
+    }
+    if (frame.depth != CV_8U) {
+        LOG_ERROR("Multi-fixation scans read 8-bit frames only");
+        return false;
+    }
+    
+    // Every cell of each image is rewritten, as in the single scan (the
+    // precise outputs are kept per calling thread so steady-state scans do not
+    // allocate; the workers read them through this reference)
+    static thread_local std::vector<float*> preciseArrays;
+    std::vector<float*>& preciseOutputs = preciseArrays;
+    preciseOutputs.assign(numCenters, nullptr);
+    for (int c = 0; c < numCenters; c++) {
+        lpxImages[c]->accessCellArray().resize(nMaxCells);  // Images loaded from file may hold fewer cells
+        if (lpxImages[c]->hasPreciseOutput()) {
+            std::vector<float>& preciseCells = lpxImages[c]->accessPreciseCellArray();
+            preciseCells.resize(3 * static_cast<size_t>(nMaxCells));
+            preciseOutputs[c] = preciseCells.data();
+        }
+    }
+    
+    ScanThreadPool& pool = *context.pool;
+    auto poolLock = pool.acquire();
+    
+    // Plans for every fixation, fetched (or built) in parallel
+    std::vector<std::shared_ptr<const ScanPlan>> plans(numCenters);
+    auto getPlan = [&](int c, int) {
+        plans[c] = context.plans->get(*context.spans, nMaxCells, frame, centers[c].x, centers[c].y);
+    };
+    pool.parallelFor(numCenters, getPlan);
+    
+    // Rows read by any fixation
+    int yMin = INT_MAX, yMax = INT_MIN;
+    for (const auto& plan : plans) {
+        if (plan->yMax > plan->yMin) {
+            yMin = std::min(yMin, plan->yMin);
+            yMax = std::max(yMax, plan->yMax);
+        }
+    }
+    if (yMax < yMin) {
+        yMin = yMax = 0;
+    }
+    
+    // Bands of rows as in the single scan, each with a buffer per fixation
+    const int numBands = std::max(1, std::min(static_cast<int>(pool.size()), (yMax - yMin) / 11));
+    const int rowsPerBand = (yMax - yMin) / numBands;
+    std::vector<AccumulatorBuffer>& buffers = pool.fixationAccumulators();
+    if (buffers.size() < static_cast<size_t>(numCenters * numBands)) {
+        buffers.resize(numCenters * numBands);
+    }
+    
+    const bool usePrefixSums = hasRowPrefixSums(frame.format);
+    
+    auto scanBand = [&](int band, int) {
+        if (band == numBands) {
+            for (int c = 0; c < numCenters; c++) {
+                gatherFoveaPixels(frame, *plans[c], lpxImages[c]->accessCellArray(), preciseOutputs[c]);
+            }
+            return;
+        }
+        
+        const int startRow = yMin + band * rowsPerBand;
+        const int endRow = (band == numBands - 1) ? yMax : startRow + rowsPerBand;
+        
+        for (int c = 0; c < numCenters; c++) {
+            AccumulatorBuffer& acc = buffers[c * numBands + band];
+            acc.resize(nMaxCells);
+            acc.clear();
+        }
+        
+        // Kept per thread so steady-state scans do not allocate
+        static thread_local std::vector<int> prefix;
+        
+        for (int k_s = startRow; k_s < endRow; k_s++) {
+            if (usePrefixSums) {
+                computeRowPrefixSums(frame, frame.pixels + k_s * frame.step, prefix);
+            }
+            
+            for (int c = 0; c < numCenters; c++) {
+                const ScanPlan& plan = *plans[c];
+                if (k_s < plan.yMin || k_s >= plan.yMax) continue;
+                AccumulatorBuffer& acc = buffers[c * numBands + band];
+                
+                if (usePrefixSums) {
+                    accumulatePrefixSpans(frame, prefix.data(), plan.spans.data(),
+                                          plan.rowSpanStart[k_s - plan.yMin],
+                                          plan.rowSpanStart[k_s - plan.yMin + 1], acc.data());
+                } else {
+                    optimizedProcessImageRegion(frame, k_s, k_s + 1, plan, acc);
+                }
             }
         }
+    };
+    pool.parallelFor(numBands + 1, scanBand);
+    
+    const bool rainbowMode = isRainbowModeEnabled();
+    const int lastFoveaIndex = sct->lastFoveaIndex;
+    const int linesPerRange = (nMaxCells / AccumulatorBuffer::CELLS_PER_LINE + numBands) / numBands;
+    const int cellsPerRange = linesPerRange * AccumulatorBuffer::CELLS_PER_LINE;
+    
+    auto mergeRange = [&](int range, int) {
+        const int cellStart = std::min(nMaxCells, range * cellsPerRange);
+        const int cellEnd = std::min(nMaxCells, cellStart + cellsPerRange);
+        for (int c = 0; c < numCenters; c++) {
+            mergeCellRange(&buffers[c * numBands], numBands, cellStart, cellEnd, lastFoveaIndex,
+                           frame.isYUV(), rainbowMode, lpxImages[c]->accessCellArray(), preciseOutputs[c]);
+        }
+    };
+    pool.parallelFor(numBands, mergeRange);
+    
+    for (int c = 0; c < numCenters; c++) {
+        lpxImages[c]->setPosition(centers[c].x, centers[c].y);
+        lpxImages[c]->setLength(nMaxCells);
+        if (lpxImages[c]->hasOpponentOutput()) {
+            lpxImages[c]->updateOpponentCells();
+        }
+    }
+    
+    return true;
+}
+
+std::shared_ptr<const ScanPlan> getScanPlan(const ScanContext& context, int nMaxCells, const FrameLayout& frame,
+                                            float x_center, float y_center, int pyramidLevels) {
+    return context.plans->get(*context.spans, nMaxCells, frame, x_center, y_center, pyramidLevels);
+}
+
+std::shared_ptr<const ScanPlan> getScanPlan(const LPXImage& lpxImage, const FrameLayout& frame,
+                                            float x_center, float y_center, int pyramidLevels) {
+    auto sct = lpxImage.getScanTables();
+    if (!sct || !sct->isInitialized()) {
+        return nullptr;
+    }
+    return getScanPlan(getDefaultScanContext(sct), lpxImage.getMaxCells(), frame, x_center, y_center, pyramidLevels);
+}
+
+bool optimizedPyramidScan(LPXImage* lpxImage, const std::vector<cv::Mat>& pyramid,
+                          float x_center, float y_center, PixelFormat format) {
+    auto sct = lpxImage->getScanTables();
+    if (!sct || !sct->isInitialized()) {
+        return false;
+    }
+    return optimizedPyramidScan(getDefaultScanContext(sct), lpxImage, pyramid, x_center, y_center, format);
+}
+
+// Pyramid scan: inner rings from the frame, outer rings from the coarse levels
+bool optimizedPyramidScan(const ScanContext& context, LPXImage* lpxImage, const std::vector<cv::Mat>& pyramid,
+                          float x_center, float y_center, PixelFormat format) {
+    auto sct = lpxImage->getScanTables();
+    if (!sct || !sct->isInitialized() || pyramid.empty() || pyramid[0].empty() ||
+        !usesContextTables(context, lpxImage)) {
+        return false;
+    }
+    if (lpxImage->hasCellStatistics()) {
+        LOG_ERROR("Pyramid scans do not gather cell statistics");
+        return false;
+    }
+    
+    // Every level must be a packed frame of the same format at half the previous size
+    // (layouts kept per calling thread so steady-state scans do not allocate;
+    // the workers read them through this reference)
+    static thread_local std::vector<FrameLayout> levelLayouts;
+    std::vector<FrameLayout>& levels = levelLayouts;
+    levels.resize(pyramid.size());
+    for (size_t l = 0; l < pyramid.size(); l++) {
+        if (!describeFrame(pyramid[l], l == 0 ? format : levels[0].format, levels[l]) || levels[l].isYUV() ||
+            levels[l].depth != CV_8U) {
+            LOG_ERROR(std::string("Pyramid level does not match pixel format ") + getPixelFormatName(format));
+            return false;
+        }
+        if (levels[l].width != (levels[0].width >> l) || levels[l].height != (levels[0].height >> l)) {
+            LOG_ERROR("Pyramid level " + std::to_string(l) + " is not half the size of the level above");
+            return false;
+        }
+    }
+    const FrameLayout& frame = levels[0];
+    const int numLevels = static_cast<int>(pyramid.size()) - 1;
+    
+    auto& cellArray = lpxImage->accessCellArray();
+    const int nMaxCells = lpxImage->getMaxCells();
+    cellArray.resize(nMaxCells);  // Images loaded from file may hold fewer cells
+    
+    // Optional high-precision cell means, 3 per cell
+    float* precise = nullptr;
+    if (lpxImage->hasPreciseOutput()) {
+        std::vector<float>& preciseCells = lpxImage->accessPreciseCellArray();
+        preciseCells.resize(3 * static_cast<size_t>(nMaxCells));
+        precise = preciseCells.data();
     }
+    lpxImage->setPosition(x_center, y_center);
+    
+    std::shared_ptr<const ScanPlan> plan = context.plans->get(*context.spans, nMaxCells, frame,
+                                                              x_center, y_center, numLevels);
+    
+    // Bands split the frame rows; each band also takes the level rows sampled
+    // from its frame rows, so every cell still sums into one buffer per band
+    const int yMin = plan->yMin;
+    const int yMax = plan->yMax;
+    
+    ScanThreadPool& pool = *context.pool;
+    auto poolLock = pool.acquire();
+    std::vector<AccumulatorBuffer>& buffers = pool.accumulators();
+    const int numBands = std::max(1, std::min(static_cast<int>(pool.size()), (yMax - yMin) / 11));
+    const int rowsPerBand = (yMax - yMin) / numBands;
+    
+    auto scanBand = [&](int band, int) {
+        if (band == numBands) {
+            gatherFoveaPixels(frame, *plan, cellArray, precise);
+            return;
+        }
+        
+        const int startRow = yMin + band * rowsPerBand;
+        const int endRow = (band == numBands - 1) ? yMax : startRow + rowsPerBand;
+        
+        buffers[band].resize(nMaxCells);
+        buffers[band].clear();
+        optimizedProcessImageRegion(frame, startRow, endRow, *plan, buffers[band]);
+        
+        for (int l = 1; l <= numLevels; l++) {
+            // Level row Y samples frame row Y * 2^l + 2^(l-1)
+            const ScanPlanLevel& level = plan->coarseLevels[l - 1];
+            const int s = 1 << l;
+            const int levelStart = (band == 0) ? level.yMin : std::max(level.yMin, (startRow + s / 2 - 1) / s);
+            const int levelEnd = (band == numBands - 1) ? level.yMax : std::min(level.yMax, (endRow + s / 2 - 1) / s);
+            if (levelEnd > levelStart) {
+                optimizedProcessImageRegion(levels[l], levelStart, levelEnd, level, buffers[band]);
+            }
+        }
+    };
+    pool.parallelFor(numBands + 1, scanBand);
+    
+    const bool rainbowMode = isRainbowModeEnabled();
+    const int linesPerRange = (nMaxCells / AccumulatorBuffer::CELLS_PER_LINE + numBands) / numBands;
+    const int cellsPerRange = linesPerRange * AccumulatorBuffer::CELLS_PER_LINE;
+    
+    auto mergeRange = [&](int range, int) {
+        const int cellStart = std::min(nMaxCells, range * cellsPerRange);
+        const int cellEnd = std::min(nMaxCells, cellStart + cellsPerRange);
+        mergeCellRange(buffers.data(), numBands, cellStart, cellEnd, sct->lastFoveaIndex, false, rainbowMode,
+                       cellArray, precise);
+    };
+    pool.parallelFor(numBands, mergeRange);
     
     lpxImage->setLength(nMaxCells);
+    if (lpxImage->hasOpponentOutput()) {
+        lpxImage->updateOpponentCells();
+    }
+    return true;
+}
+
+bool optimizedScanCells(LPXImage* lpxImage, const cv::Mat& image, float x_center, float y_center,
+                        const int* cells, int nCells, PixelFormat format) {
+    auto sct = lpxImage->getScanTables();
+    if (!sct || !sct->isInitialized()) {
+        return false;
+    }
+    return optimizedScanCells(getDefaultScanContext(sct), lpxImage, image, x_center, y_center,
+                              cells, nCells, format);
+}
+
+// Sparse scan: a plan holding only the listed cells' spans, summed on this thread
+bool optimizedScanCells(const ScanContext& context, LPXImage* lpxImage, const cv::Mat& image,
+                        float x_center, float y_center, const int* cells, int nCells,
+                        PixelFormat format) {
+    auto sct = lpxImage->getScanTables();
+    if (!sct || !sct->isInitialized() || image.empty() || !usesContextTables(context, lpxImage)) {
+        return false;
+    }
+    if (nCells < 0 || (nCells > 0 && !cells)) {
+        return false;
+    }
+    if (lpxImage->hasCellStatistics()) {
+        LOG_ERROR("Cell scans do not gather cell statistics");
+        return false;
+    }
     
-    auto totalEnd = std::chrono::high_resolution_clock::now();
+    FrameLayout frame;
+    if (!describeFrame(image, format, frame)) {
+        LOG_ERROR(std::string("Image does not match pixel format ") + getPixelFormatName(format));
+        return false;
+    }
     
-    // Timing calculations removed
+    const int nMaxCells = lpxImage->getMaxCells();
+    for (int n = 0; n < nCells; n++) {
+        if (cells[n] < 0 || cells[n] >= nMaxCells) {
+            LOG_ERROR("Cell " + std::to_string(cells[n]) + " is outside the " +
+                      std::to_string(nMaxCells) + " cells of the image");
+            return false;
+        }
+    }
+    
+    auto& cellArray = lpxImage->accessCellArray();
+    cellArray.assign(nMaxCells, 0u);  // Cells not listed are left empty
+    float* precise = nullptr;
+    if (lpxImage->hasPreciseOutput()) {
+        std::vector<float>& preciseCells = lpxImage->accessPreciseCellArray();
+        preciseCells.assign(3 * static_cast<size_t>(nMaxCells), 0.0f);
+        precise = preciseCells.data();
+    }
+    lpxImage->setPosition(x_center, y_center);
+    
+    std::shared_ptr<const CellSpanIndex> index = getSharedCellSpanIndex(sct);
+    ScanThreadPool& pool = *context.pool;
+    auto poolLock = pool.acquire();
+    
+    // Sorted and without repeats, so cells are visited once and in memory order
+    std::vector<int>& list = pool.cellList();
+    list.assign(cells, cells + nCells);
+    std::sort(list.begin(), list.end());
+    list.erase(std::unique(list.begin(), list.end()), list.end());
+    const int count = static_cast<int>(list.size());
+    
+    ScanPlan& plan = pool.cellPlan();
+    buildCellScanPlan(*context.spans, *index, nMaxCells, frame, x_center, y_center, list.data(), count, plan);
+    
+    const int lastFoveaIndex = sct->lastFoveaIndex;
+    const bool rainbowMode = isRainbowModeEnabled();
+    gatherFoveaPixels(frame, plan.fovea.data(), static_cast<int>(plan.fovea.size()), cellArray, precise);
     
+    // Only the listed cells' accumulators are cleared and merged
+    if (frame.depth != CV_8U) {
+        WideAccumulatorBuffer& buffer = pool.wideAccumulators()[0];
+        buffer.resize(nMaxCells);
+        for (int cell : list) buffer.clear(cell, cell + 1);
+        optimizedProcessImageRegion(frame, plan.yMin, plan.yMax, plan, buffer);
+        for (int cell : list) {
+            mergeCellRange(&buffer, 1, cell, cell + 1, lastFoveaIndex, frame.depth, rainbowMode, cellArray, precise);
+        }
+    } else {
+        AccumulatorBuffer& buffer = pool.accumulators()[0];
+        buffer.resize(nMaxCells);
+        for (int cell : list) buffer.clear(cell, cell + 1);
+        optimizedProcessImageRegion(frame, plan.yMin, plan.yMax, plan, buffer);
+        for (int cell : list) {
+            mergeCellRange(&buffer, 1, cell, cell + 1, lastFoveaIndex, frame.isYUV(), rainbowMode, cellArray, precise);
+        }
+    }
+    
+    lpxImage->setLength(nMaxCells);
+    if (lpxImage->hasOpponentOutput()) {
+        lpxImage->updateOpponentCells();
+    }
     return true;
 }
 
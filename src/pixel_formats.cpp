@@ -0,0 +1,186 @@
+/**
+ * pixel_formats.cpp
+ *
+ * Native input layouts for the log-polar scan
+ */
+
+#include "../include/lpx_image.h"
+#include "../include/lpx_optimized.h"
+#include <algorithm>
+#include <cmath>
+
+namespace lpx {
+
+const char* getPixelFormatName(PixelFormat format) {
+    switch (format) {
+        case PIXEL_FORMAT_AUTO: return "auto";
+        case PIXEL_FORMAT_BGR: return "bgr";
+        case PIXEL_FORMAT_RGB: return "rgb";
+        case PIXEL_FORMAT_BGRA: return "bgra";
+        case PIXEL_FORMAT_GRAY: return "gray";
+        case PIXEL_FORMAT_NV12: return "nv12";
+        case PIXEL_FORMAT_I420: return "i420";
+        case PIXEL_FORMAT_YUYV: return "yuyv";
+    }
+    return "unknown";
+}
+
+bool parsePixelFormat(const std::string& name, PixelFormat& format) {
+    const PixelFormat formats[] = { PIXEL_FORMAT_AUTO, PIXEL_FORMAT_BGR, PIXEL_FORMAT_RGB,
+                                    PIXEL_FORMAT_BGRA, PIXEL_FORMAT_GRAY, PIXEL_FORMAT_NV12,
+                                    PIXEL_FORMAT_I420, PIXEL_FORMAT_YUYV };
+    for (PixelFormat f : formats) {
+        if (name == getPixelFormatName(f)) {
+            format = f;
+            return true;
+        }
+    }
+    return false;
+}
+
+cv::Size getFrameSize(const cv::Mat& image, PixelFormat format) {
+    optimized::FrameLayout frame;
+    if (!optimized::describeFrame(image, format, frame)) {
+        return cv::Size(0, 0);
+    }
+    return cv::Size(frame.width, frame.height);
+}
+
+namespace optimized {
+
+// AUTO picks the packed format from the channel count
+static bool resolveAutoFormat(int channels, PixelFormat& format) {
+    if (format != PIXEL_FORMAT_AUTO) {
+        return true;
+    }
+    switch (channels) {
+        case 1: format = PIXEL_FORMAT_GRAY; return true;
+        case 3: format = PIXEL_FORMAT_BGR; return true;
+        case 4: format = PIXEL_FORMAT_BGRA; return true;
+        default: return false;
+    }
+}
+
+bool describeFrame(const cv::Mat& image, PixelFormat format, FrameLayout& frame) {
+    const int depth = image.depth();
+    if (image.empty() || (depth != CV_8U && depth != CV_16U && depth != CV_32F)) {
+        return false;
+    }
+
+    const int channels = image.channels();
+    if (!resolveAutoFormat(channels, format)) {
+        return false;
+    }
+
+    frame = FrameLayout();
+    frame.format = format;
+    frame.width = image.cols;
+    frame.height = image.rows;
+    frame.depth = depth;
+    frame.pixelSize = static_cast<int>(image.elemSize());
+    frame.step = image.step;
+    frame.pixels = image.data;
+
+    // Only packed formats are read at more than 8 bits
+    if (depth != CV_8U && frame.isYUV()) {
+        return false;
+    }
+
+    switch (format) {
+        case PIXEL_FORMAT_BGR:
+        case PIXEL_FORMAT_RGB:
+            if (channels != 3) return false;
+            break;
+        case PIXEL_FORMAT_BGRA:
+            if (channels != 4) return false;
+            break;
+        case PIXEL_FORMAT_GRAY:
+            if (channels != 1) return false;
+            break;
+        case PIXEL_FORMAT_YUYV:
+            // Chroma is shared by pixel pairs
+            if (channels != 2 || image.cols % 2 != 0) return false;
+            break;
+        case PIXEL_FORMAT_NV12:
+        case PIXEL_FORMAT_I420: {
+            // 4:2:0 frames need even dimensions; the chroma rows follow the Y plane
+            if (channels != 1 || image.rows % 3 != 0 || image.cols % 2 != 0) return false;
+            frame.height = image.rows / 3 * 2;
+            if (frame.height % 2 != 0) return false;
+
+            const uchar* chroma = image.data + frame.height * image.step;
+            if (format == PIXEL_FORMAT_NV12) {
+                frame.chromaU = chroma;
+                frame.chromaV = chroma + 1;
+                frame.chromaStep = image.step;
+            } else {
+                // Quarter-size U and V planes are packed back to back
+                if (!image.isContinuous()) return false;
+                frame.chromaStep = frame.width / 2;
+                frame.chromaU = chroma;
+                frame.chromaV = chroma + frame.chromaStep * (frame.height / 2);
+            }
+            break;
+        }
+        default:
+            return false;
+    }
+
+    frame.scanWidth = frame.width;
+    frame.scanHeight = frame.height;
+    return true;
+}
+
+bool describePackedFrame(int width, int height, int type, PixelFormat format, FrameLayout& frame) {
+    const int depth = CV_MAT_DEPTH(type);
+    const int channels = CV_MAT_CN(type);
+    if (width <= 0 || height <= 0 || (depth != CV_8U && depth != CV_16U && depth != CV_32F) ||
+        !resolveAutoFormat(channels, format)) {
+        return false;
+    }
+
+    switch (format) {
+        case PIXEL_FORMAT_BGR:
+        case PIXEL_FORMAT_RGB:
+            if (channels != 3) return false;
+            break;
+        case PIXEL_FORMAT_BGRA:
+            if (channels != 4) return false;
+            break;
+        case PIXEL_FORMAT_GRAY:
+            if (channels != 1) return false;
+            break;
+        default:
+            return false;
+    }
+
+    frame = FrameLayout();
+    frame.format = format;
+    frame.width = width;
+    frame.height = height;
+    frame.scanWidth = width;
+    frame.scanHeight = height;
+    frame.depth = depth;
+    frame.pixelSize = channels * (depth == CV_8U ? 1 : (depth == CV_16U ? 2 : 4));
+    frame.step = static_cast<size_t>(width) * frame.pixelSize;
+    return true;
+}
+
+uint32_t packYUVAsBGR(float y, float u, float v) {
+    // BT.601 video range, as used by OpenCV's YUV2BGR_NV12 family
+    const float c = 1.164f * (y - 16.0f);
+    const float d = u - 128.0f;
+    const float e = v - 128.0f;
+
+    auto toByte = [](float value) {
+        return static_cast<uint32_t>(std::min(255.0f, std::max(0.0f, std::round(value))));
+    };
+    const uint32_t r = toByte(c + 1.596f * e);
+    const uint32_t g = toByte(c - 0.391f * d - 0.813f * e);
+    const uint32_t b = toByte(c + 2.018f * d);
+
+    return b | (g << 8) | (r << 16);
+}
+
+} // namespace optimized
+} // namespace lpx
@@ -0,0 +1,560 @@
+/**
+ * scan_kernels.cpp
+ *
+ * Span summation kernels for the optimized log-polar scan.
+ * Every kernel returns exactly the same integer sums as the scalar one;
+ * the vector paths only change how the bytes of a span are added up.
+ */
+
+#include "../include/lpx_optimized.h"
+#include "../include/lpx_common.h"
+#include <cstdlib>  // For getenv
+#include <cstring>
+#include <string>
+
+#if defined(__x86_64__)
+#define LPX_SCAN_X86 1
+#include <immintrin.h>
+#endif
+
+#if defined(__aarch64__)
+#define LPX_SCAN_NEON 1
+#include <arm_neon.h>
+#endif
+
+namespace lpx {
+namespace optimized {
+
+// ---------------------------------------------------------------------------
+// Scalar kernels
+
+static void sumSpanBGRScalar(const uchar* pixels, int n, int& sumB, int& sumG, int& sumR) {
+    int b = 0, g = 0, r = 0;
+    for (int i = 0; i < n; i++, pixels += 3) {
+        b += pixels[0];
+        g += pixels[1];
+        r += pixels[2];
+    }
+    sumB = b;
+    sumG = g;
+    sumR = r;
+}
+
+static void sumSpanBGRAScalar(const uchar* pixels, int n, int& sumB, int& sumG, int& sumR) {
+    int b = 0, g = 0, r = 0;
+    for (int i = 0; i < n; i++, pixels += 4) {
+        b += pixels[0];
+        g += pixels[1];
+        r += pixels[2];
+    }
+    sumB = b;
+    sumG = g;
+    sumR = r;
+}
+
+static int sumSpanGrayScalar(const uchar* pixels, int n) {
+    int sum = 0;
+    for (int i = 0; i < n; i++) {
+        sum += pixels[i];
+    }
+    return sum;
+}
+
+// 2x2 box average of two rows into one row of `width` pixels, rounded
+template <int CN>
+static inline void downsampleRowScalar(const uchar* row0, const uchar* row1, uchar* out, int width) {
+    for (int x = 0; x < width; x++, row0 += 2 * CN, row1 += 2 * CN, out += CN) {
+        for (int k = 0; k < CN; k++) {
+            out[k] = static_cast<uchar>((row0[k] + row0[CN + k] + row1[k] + row1[CN + k] + 2) >> 2);
+        }
+    }
+}
+
+static void downsampleBGRScalar(const uchar* row0, const uchar* row1, uchar* out, int width) {
+    downsampleRowScalar<3>(row0, row1, out, width);
+}
+
+static void downsampleBGRAScalar(const uchar* row0, const uchar* row1, uchar* out, int width) {
+    downsampleRowScalar<4>(row0, row1, out, width);
+}
+
+static void downsampleGrayScalar(const uchar* row0, const uchar* row1, uchar* out, int width) {
+    downsampleRowScalar<1>(row0, row1, out, width);
+}
+
+#ifdef LPX_SCAN_X86
+
+// ---------------------------------------------------------------------------
+// SSE4.1 kernels: deinterleave 16 BGR pixels (three 16-byte loads) into
+// B, G and R vectors with byte shuffles, then add each with a SAD against zero.
+
+// Shuffle masks selecting one channel from each of the three loads; -1 zeroes the byte
+#define LPX_DEINTERLEAVE_MASKS                                                                   \
+    const __m128i mB0 = _mm_setr_epi8(0, 3, 6, 9, 12, 15, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1);  \
+    const __m128i mB1 = _mm_setr_epi8(-1, -1, -1, -1, -1, -1, 2, 5, 8, 11, 14, -1, -1, -1, -1, -1); \
+    const __m128i mB2 = _mm_setr_epi8(-1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, 1, 4, 7, 10, 13); \
+    const __m128i mG0 = _mm_setr_epi8(1, 4, 7, 10, 13, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1); \
+    const __m128i mG1 = _mm_setr_epi8(-1, -1, -1, -1, -1, 0, 3, 6, 9, 12, 15, -1, -1, -1, -1, -1);  \
+    const __m128i mG2 = _mm_setr_epi8(-1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, 2, 5, 8, 11, 14); \
+    const __m128i mR0 = _mm_setr_epi8(2, 5, 8, 11, 14, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1); \
+    const __m128i mR1 = _mm_setr_epi8(-1, -1, -1, -1, -1, 1, 4, 7, 10, 13, -1, -1, -1, -1, -1, -1); \
+    const __m128i mR2 = _mm_setr_epi8(-1, -1, -1, -1, -1, -1, -1, -1, -1, -1, 0, 3, 6, 9, 12, 15);
+
+__attribute__((target("sse4.1")))
+static inline int horizontalSum128(__m128i v) {
+    return static_cast<int>(_mm_cvtsi128_si64(v) + _mm_extract_epi64(v, 1));
+}
+
+__attribute__((target("sse4.1")))
+static void sumSpanBGRSse41(const uchar* pixels, int n, int& sumB, int& sumG, int& sumR) {
+    LPX_DEINTERLEAVE_MASKS
+    const __m128i zero = _mm_setzero_si128();
+    __m128i accB = zero, accG = zero, accR = zero;
+
+    int i = 0;
+    for (; i + 16 <= n; i += 16, pixels += 48) {
+        const __m128i v0 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(pixels));
+        const __m128i v1 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(pixels + 16));
+        const __m128i v2 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(pixels + 32));
+
+        const __m128i b = _mm_or_si128(_mm_or_si128(_mm_shuffle_epi8(v0, mB0), _mm_shuffle_epi8(v1, mB1)), _mm_shuffle_epi8(v2, mB2));
+        const __m128i g = _mm_or_si128(_mm_or_si128(_mm_shuffle_epi8(v0, mG0), _mm_shuffle_epi8(v1, mG1)), _mm_shuffle_epi8(v2, mG2));
+        const __m128i r = _mm_or_si128(_mm_or_si128(_mm_shuffle_epi8(v0, mR0), _mm_shuffle_epi8(v1, mR1)), _mm_shuffle_epi8(v2, mR2));
+
+        accB = _mm_add_epi64(accB, _mm_sad_epu8(b, zero));
+        accG = _mm_add_epi64(accG, _mm_sad_epu8(g, zero));
+        accR = _mm_add_epi64(accR, _mm_sad_epu8(r, zero));
+    }
+
+    int tailB, tailG, tailR;
+    sumSpanBGRScalar(pixels, n - i, tailB, tailG, tailR);
+    sumB = horizontalSum128(accB) + tailB;
+    sumG = horizontalSum128(accG) + tailG;
+    sumR = horizontalSum128(accR) + tailR;
+}
+
+__attribute__((target("sse4.1")))
+static int sumSpanGraySse41(const uchar* pixels, int n) {
+    const __m128i zero = _mm_setzero_si128();
+    __m128i acc = zero;
+
+    int i = 0;
+    for (; i + 16 <= n; i += 16) {
+        const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(pixels + i));
+        acc = _mm_add_epi64(acc, _mm_sad_epu8(v, zero));
+    }
+    return horizontalSum128(acc) + sumSpanGrayScalar(pixels + i, n - i);
+}
+
+// BGRA needs no shuffles: masking one byte of every 32-bit pixel and adding
+// with a SAD sums that channel over four pixels per load
+__attribute__((target("sse4.1")))
+static void sumSpanBGRASse41(const uchar* pixels, int n, int& sumB, int& sumG, int& sumR) {
+    const __m128i mask = _mm_set1_epi32(0xFF);
+    const __m128i zero = _mm_setzero_si128();
+    __m128i accB = zero, accG = zero, accR = zero;
+
+    int i = 0;
+    for (; i + 4 <= n; i += 4, pixels += 16) {
+        const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(pixels));
+        accB = _mm_add_epi64(accB, _mm_sad_epu8(_mm_and_si128(v, mask), zero));
+        accG = _mm_add_epi64(accG, _mm_sad_epu8(_mm_and_si128(_mm_srli_epi32(v, 8), mask), zero));
+        accR = _mm_add_epi64(accR, _mm_sad_epu8(_mm_and_si128(_mm_srli_epi32(v, 16), mask), zero));
+    }
+
+    int tailB, tailG, tailR;
+    sumSpanBGRAScalar(pixels, n - i, tailB, tailG, tailR);
+    sumB = horizontalSum128(accB) + tailB;
+    sumG = horizontalSum128(accG) + tailG;
+    sumR = horizontalSum128(accR) + tailR;
+}
+
+// Pyramid downsampling: the even and odd pixels of both rows are separated
+// with byte shuffles and added as 16-bit values, so the rounding is exactly
+// that of the scalar kernel. The AVX2 kernel set uses these as well.
+
+// Rounded average of e0 + o0 + e1 + o1 for 16 bytes
+__attribute__((target("sse4.1")))
+static inline __m128i averageQuads(__m128i e0, __m128i o0, __m128i e1, __m128i o1) {
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i two = _mm_set1_epi16(2);
+    __m128i lo = _mm_add_epi16(_mm_add_epi16(_mm_unpacklo_epi8(e0, zero), _mm_unpacklo_epi8(o0, zero)),
+                               _mm_add_epi16(_mm_unpacklo_epi8(e1, zero), _mm_unpacklo_epi8(o1, zero)));
+    __m128i hi = _mm_add_epi16(_mm_add_epi16(_mm_unpackhi_epi8(e0, zero), _mm_unpackhi_epi8(o0, zero)),
+                               _mm_add_epi16(_mm_unpackhi_epi8(e1, zero), _mm_unpackhi_epi8(o1, zero)));
+    lo = _mm_srli_epi16(_mm_add_epi16(lo, two), 2);
+    hi = _mm_srli_epi16(_mm_add_epi16(hi, two), 2);
+    return _mm_packus_epi16(lo, hi);
+}
+
+// Four BGR output pixels per step from loads at bytes 0 and 8 of the 24 input bytes
+__attribute__((target("sse4.1")))
+static void downsampleBGRSse41(const uchar* row0, const uchar* row1, uchar* out, int width) {
+    const __m128i mEvenA = _mm_setr_epi8(0, 1, 2, 6, 7, 8, 12, 13, 14, -1, -1, -1, -1, -1, -1, -1);
+    const __m128i mEvenB = _mm_setr_epi8(-1, -1, -1, -1, -1, -1, -1, -1, -1, 10, 11, 12, -1, -1, -1, -1);
+    const __m128i mOddA = _mm_setr_epi8(3, 4, 5, 9, 10, 11, 15, -1, -1, -1, -1, -1, -1, -1, -1, -1);
+    const __m128i mOddB = _mm_setr_epi8(-1, -1, -1, -1, -1, -1, -1, 8, 9, 13, 14, 15, -1, -1, -1, -1);
+
+    int x = 0;
+    // The 16-byte store spills into the next two pixels, which later steps rewrite
+    for (; x + 6 <= width; x += 4, row0 += 24, row1 += 24, out += 12) {
+        const __m128i a0 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(row0));
+        const __m128i b0 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(row0 + 8));
+        const __m128i a1 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(row1));
+        const __m128i b1 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(row1 + 8));
+        const __m128i e0 = _mm_or_si128(_mm_shuffle_epi8(a0, mEvenA), _mm_shuffle_epi8(b0, mEvenB));
+        const __m128i o0 = _mm_or_si128(_mm_shuffle_epi8(a0, mOddA), _mm_shuffle_epi8(b0, mOddB));
+        const __m128i e1 = _mm_or_si128(_mm_shuffle_epi8(a1, mEvenA), _mm_shuffle_epi8(b1, mEvenB));
+        const __m128i o1 = _mm_or_si128(_mm_shuffle_epi8(a1, mOddA), _mm_shuffle_epi8(b1, mOddB));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(out), averageQuads(e0, o0, e1, o1));
+    }
+    downsampleRowScalar<3>(row0, row1, out, width - x);
+}
+
+// Four BGRA output pixels per step: each load is split into even and odd pixels
+__attribute__((target("sse4.1")))
+static void downsampleBGRASse41(const uchar* row0, const uchar* row1, uchar* out, int width) {
+    const __m128i mSplit = _mm_setr_epi8(0, 1, 2, 3, 8, 9, 10, 11, 4, 5, 6, 7, 12, 13, 14, 15);
+
+    int x = 0;
+    for (; x + 4 <= width; x += 4, row0 += 32, row1 += 32, out += 16) {
+        const __m128i a0 = _mm_shuffle_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i*>(row0)), mSplit);
+        const __m128i b0 = _mm_shuffle_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i*>(row0 + 16)), mSplit);
+        const __m128i a1 = _mm_shuffle_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i*>(row1)), mSplit);
+        const __m128i b1 = _mm_shuffle_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i*>(row1 + 16)), mSplit);
+        const __m128i avg = averageQuads(_mm_unpacklo_epi64(a0, b0), _mm_unpackhi_epi64(a0, b0),
+                                         _mm_unpacklo_epi64(a1, b1), _mm_unpackhi_epi64(a1, b1));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(out), avg);
+    }
+    downsampleRowScalar<4>(row0, row1, out, width - x);
+}
+
+// Sixteen gray output pixels per step; maddubs adds neighbouring bytes
+__attribute__((target("sse4.1")))
+static void downsampleGraySse41(const uchar* row0, const uchar* row1, uchar* out, int width) {
+    const __m128i ones = _mm_set1_epi8(1);
+    const __m128i two = _mm_set1_epi16(2);
+
+    int x = 0;
+    for (; x + 16 <= width; x += 16, row0 += 32, row1 += 32, out += 16) {
+        __m128i lo = _mm_add_epi16(_mm_maddubs_epi16(_mm_loadu_si128(reinterpret_cast<const __m128i*>(row0)), ones),
+                                   _mm_maddubs_epi16(_mm_loadu_si128(reinterpret_cast<const __m128i*>(row1)), ones));
+        __m128i hi = _mm_add_epi16(_mm_maddubs_epi16(_mm_loadu_si128(reinterpret_cast<const __m128i*>(row0 + 16)), ones),
+                                   _mm_maddubs_epi16(_mm_loadu_si128(reinterpret_cast<const __m128i*>(row1 + 16)), ones));
+        lo = _mm_srli_epi16(_mm_add_epi16(lo, two), 2);
+        hi = _mm_srli_epi16(_mm_add_epi16(hi, two), 2);
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(out), _mm_packus_epi16(lo, hi));
+    }
+    downsampleRowScalar<1>(row0, row1, out, width - x);
+}
+
+// ---------------------------------------------------------------------------
+// AVX2 kernels: the same shuffles on 32 pixels at a time. Byte shuffles work
+// within 128-bit lanes, so the low lane holds pixels 0-15 and the high lane
+// pixels 16-31 of each block.
+
+__attribute__((target("avx2")))
+static inline __m256i loadLanes(const uchar* low, const uchar* high) {
+    return _mm256_inserti128_si256(
+        _mm256_castsi128_si256(_mm_loadu_si128(reinterpret_cast<const __m128i*>(low))),
+        _mm_loadu_si128(reinterpret_cast<const __m128i*>(high)), 1);
+}
+
+__attribute__((target("avx2")))
+static inline int horizontalSum256(__m256i v) {
+    const __m128i sum = _mm_add_epi64(_mm256_castsi256_si128(v), _mm256_extracti128_si256(v, 1));
+    return static_cast<int>(_mm_cvtsi128_si64(sum) + _mm_extract_epi64(sum, 1));
+}
+
+__attribute__((target("avx2")))
+static void sumSpanBGRAvx2(const uchar* pixels, int n, int& sumB, int& sumG, int& sumR) {
+    LPX_DEINTERLEAVE_MASKS
+    const __m256i wB0 = _mm256_broadcastsi128_si256(mB0), wB1 = _mm256_broadcastsi128_si256(mB1), wB2 = _mm256_broadcastsi128_si256(mB2);
+    const __m256i wG0 = _mm256_broadcastsi128_si256(mG0), wG1 = _mm256_broadcastsi128_si256(mG1), wG2 = _mm256_broadcastsi128_si256(mG2);
+    const __m256i wR0 = _mm256_broadcastsi128_si256(mR0), wR1 = _mm256_broadcastsi128_si256(mR1), wR2 = _mm256_broadcastsi128_si256(mR2);
+    const __m256i zero = _mm256_setzero_si256();
+    __m256i accB = zero, accG = zero, accR = zero;
+
+    int i = 0;
+    for (; i + 32 <= n; i += 32, pixels += 96) {
+        const __m256i v0 = loadLanes(pixels, pixels + 48);
+        const __m256i v1 = loadLanes(pixels + 16, pixels + 64);
+        const __m256i v2 = loadLanes(pixels + 32, pixels + 80);
+
+        const __m256i b = _mm256_or_si256(_mm256_or_si256(_mm256_shuffle_epi8(v0, wB0), _mm256_shuffle_epi8(v1, wB1)), _mm256_shuffle_epi8(v2, wB2));
+        const __m256i g = _mm256_or_si256(_mm256_or_si256(_mm256_shuffle_epi8(v0, wG0), _mm256_shuffle_epi8(v1, wG1)), _mm256_shuffle_epi8(v2, wG2));
+        const __m256i r = _mm256_or_si256(_mm256_or_si256(_mm256_shuffle_epi8(v0, wR0), _mm256_shuffle_epi8(v1, wR1)), _mm256_shuffle_epi8(v2, wR2));
+
+        accB = _mm256_add_epi64(accB, _mm256_sad_epu8(b, zero));
+        accG = _mm256_add_epi64(accG, _mm256_sad_epu8(g, zero));
+        accR = _mm256_add_epi64(accR, _mm256_sad_epu8(r, zero));
+    }
+
+    // Remaining pixels go through the 16-pixel kernel
+    int tailB, tailG, tailR;
+    sumSpanBGRSse41(pixels, n - i, tailB, tailG, tailR);
+    sumB = horizontalSum256(accB) + tailB;
+    sumG = horizontalSum256(accG) + tailG;
+    sumR = horizontalSum256(accR) + tailR;
+}
+
+__attribute__((target("avx2")))
+static void sumSpanBGRAAvx2(const uchar* pixels, int n, int& sumB, int& sumG, int& sumR) {
+    const __m256i mask = _mm256_set1_epi32(0xFF);
+    const __m256i zero = _mm256_setzero_si256();
+    __m256i accB = zero, accG = zero, accR = zero;
+
+    int i = 0;
+    for (; i + 8 <= n; i += 8, pixels += 32) {
+        const __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(pixels));
+        accB = _mm256_add_epi64(accB, _mm256_sad_epu8(_mm256_and_si256(v, mask), zero));
+        accG = _mm256_add_epi64(accG, _mm256_sad_epu8(_mm256_and_si256(_mm256_srli_epi32(v, 8), mask), zero));
+        accR = _mm256_add_epi64(accR, _mm256_sad_epu8(_mm256_and_si256(_mm256_srli_epi32(v, 16), mask), zero));
+    }
+
+    int tailB, tailG, tailR;
+    sumSpanBGRASse41(pixels, n - i, tailB, tailG, tailR);
+    sumB = horizontalSum256(accB) + tailB;
+    sumG = horizontalSum256(accG) + tailG;
+    sumR = horizontalSum256(accR) + tailR;
+}
+
+__attribute__((target("avx2")))
+static int sumSpanGrayAvx2(const uchar* pixels, int n) {
+    const __m256i zero = _mm256_setzero_si256();
+    __m256i acc = zero;
+
+    int i = 0;
+    for (; i + 32 <= n; i += 32) {
+        const __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(pixels + i));
+        acc = _mm256_add_epi64(acc, _mm256_sad_epu8(v, zero));
+    }
+    return horizontalSum256(acc) + sumSpanGraySse41(pixels + i, n - i);
+}
+
+#undef LPX_DEINTERLEAVE_MASKS
+
+#endif // LPX_SCAN_X86
+
+#ifdef LPX_SCAN_NEON
+
+// ---------------------------------------------------------------------------
+// NEON kernels: vld3q_u8/vld4q_u8 deinterleave 16 BGR/BGRA pixels directly and vaddlvq_u8
+// adds each channel across the vector.
+
+static void sumSpanBGRNeon(const uchar* pixels, int n, int& sumB, int& sumG, int& sumR) {
+    int b = 0, g = 0, r = 0;
+
+    int i = 0;
+    for (; i + 16 <= n; i += 16, pixels += 48) {
+        const uint8x16x3_t v = vld3q_u8(pixels);
+        b += vaddlvq_u8(v.val[0]);
+        g += vaddlvq_u8(v.val[1]);
+        r += vaddlvq_u8(v.val[2]);
+    }
+
+    int tailB, tailG, tailR;
+    sumSpanBGRScalar(pixels, n - i, tailB, tailG, tailR);
+    sumB = b + tailB;
+    sumG = g + tailG;
+    sumR = r + tailR;
+}
+
+static void sumSpanBGRANeon(const uchar* pixels, int n, int& sumB, int& sumG, int& sumR) {
+    int b = 0, g = 0, r = 0;
+
+    int i = 0;
+    for (; i + 16 <= n; i += 16, pixels += 64) {
+        const uint8x16x4_t v = vld4q_u8(pixels);
+        b += vaddlvq_u8(v.val[0]);
+        g += vaddlvq_u8(v.val[1]);
+        r += vaddlvq_u8(v.val[2]);
+    }
+
+    int tailB, tailG, tailR;
+    sumSpanBGRAScalar(pixels, n - i, tailB, tailG, tailR);
+    sumB = b + tailB;
+    sumG = g + tailG;
+    sumR = r + tailR;
+}
+
+static int sumSpanGrayNeon(const uchar* pixels, int n) {
+    int sum = 0;
+
+    int i = 0;
+    for (; i + 16 <= n; i += 16) {
+        sum += vaddlvq_u8(vld1q_u8(pixels + i));
+    }
+    return sum + sumSpanGrayScalar(pixels + i, n - i);
+}
+
+// Pyramid downsampling: vpaddlq_u8 adds neighbouring pixels of each
+// deinterleaved channel and vrshrn_n_u16 applies the rounded divide by 4
+static void downsampleBGRNeon(const uchar* row0, const uchar* row1, uchar* out, int width) {
+    int x = 0;
+    for (; x + 8 <= width; x += 8, row0 += 48, row1 += 48, out += 24) {
+        const uint8x16x3_t a = vld3q_u8(row0);
+        const uint8x16x3_t b = vld3q_u8(row1);
+        uint8x8x3_t avg;
+        for (int k = 0; k < 3; k++) {
+            avg.val[k] = vrshrn_n_u16(vaddq_u16(vpaddlq_u8(a.val[k]), vpaddlq_u8(b.val[k])), 2);
+        }
+        vst3_u8(out, avg);
+    }
+    downsampleRowScalar<3>(row0, row1, out, width - x);
+}
+
+static void downsampleBGRANeon(const uchar* row0, const uchar* row1, uchar* out, int width) {
+    int x = 0;
+    for (; x + 8 <= width; x += 8, row0 += 64, row1 += 64, out += 32) {
+        const uint8x16x4_t a = vld4q_u8(row0);
+        const uint8x16x4_t b = vld4q_u8(row1);
+        uint8x8x4_t avg;
+        for (int k = 0; k < 4; k++) {
+            avg.val[k] = vrshrn_n_u16(vaddq_u16(vpaddlq_u8(a.val[k]), vpaddlq_u8(b.val[k])), 2);
+        }
+        vst4_u8(out, avg);
+    }
+    downsampleRowScalar<4>(row0, row1, out, width - x);
+}
+
+static void downsampleGrayNeon(const uchar* row0, const uchar* row1, uchar* out, int width) {
+    int x = 0;
+    for (; x + 8 <= width; x += 8, row0 += 16, row1 += 16, out += 8) {
+        const uint16x8_t sum = vaddq_u16(vpaddlq_u8(vld1q_u8(row0)), vpaddlq_u8(vld1q_u8(row1)));
+        vst1_u8(out, vrshrn_n_u16(sum, 2));
+    }
+    downsampleRowScalar<1>(row0, row1, out, width - x);
+}
+
+#endif // LPX_SCAN_NEON
+
+// ---------------------------------------------------------------------------
+// Runtime dispatch
+
+bool isScanKernelSupported(ScanKernel kernel) {
+    switch (kernel) {
+        case SCAN_KERNEL_AUTO:
+        case SCAN_KERNEL_SCALAR:
+            return true;
+#ifdef LPX_SCAN_X86
+        case SCAN_KERNEL_SSE41:
+            return __builtin_cpu_supports("sse4.1");
+        case SCAN_KERNEL_AVX2:
+            return __builtin_cpu_supports("avx2") && __builtin_cpu_supports("sse4.1");
+#endif
+#ifdef LPX_SCAN_NEON
+        case SCAN_KERNEL_NEON:
+            return true;
+#endif
+        default:
+            return false;
+    }
+}
+
+// Best kernel available on this CPU
+static ScanKernel detectScanKernel() {
+    if (isScanKernelSupported(SCAN_KERNEL_AVX2)) return SCAN_KERNEL_AVX2;
+    if (isScanKernelSupported(SCAN_KERNEL_SSE41)) return SCAN_KERNEL_SSE41;
+    if (isScanKernelSupported(SCAN_KERNEL_NEON)) return SCAN_KERNEL_NEON;
+    return SCAN_KERNEL_SCALAR;
+}
+
+static ScanKernelFunctions makeKernelFunctions(ScanKernel kernel) {
+    ScanKernelFunctions fns = { SCAN_KERNEL_SCALAR, sumSpanBGRScalar, sumSpanBGRAScalar, sumSpanGrayScalar,
+                                downsampleBGRScalar, downsampleBGRAScalar, downsampleGrayScalar };
+    switch (kernel) {
+#ifdef LPX_SCAN_X86
+        case SCAN_KERNEL_SSE41:
+            fns = { SCAN_KERNEL_SSE41, sumSpanBGRSse41, sumSpanBGRASse41, sumSpanGraySse41,
+                    downsampleBGRSse41, downsampleBGRASse41, downsampleGraySse41 };
+            break;
+        case SCAN_KERNEL_AVX2:
+            fns = { SCAN_KERNEL_AVX2, sumSpanBGRAvx2, sumSpanBGRAAvx2, sumSpanGrayAvx2,
+                    downsampleBGRSse41, downsampleBGRASse41, downsampleGraySse41 };
+            break;
+#endif
+#ifdef LPX_SCAN_NEON
+        case SCAN_KERNEL_NEON:
+            fns = { SCAN_KERNEL_NEON, sumSpanBGRNeon, sumSpanBGRANeon, sumSpanGrayNeon,
+                    downsampleBGRNeon, downsampleBGRANeon, downsampleGrayNeon };
+            break;
+#endif
+        default:
+            break;
+    }
+    return fns;
+}
+
+// Kernel selected at first use; LPX_SCAN_KERNEL overrides the CPU detection
+static ScanKernel initialScanKernel() {
+    const char* env_var = std::getenv("LPX_SCAN_KERNEL");
+    if (env_var != nullptr) {
+        ScanKernel kernel;
+        if (parseScanKernel(env_var, kernel) && isScanKernelSupported(kernel)) {
+            return kernel == SCAN_KERNEL_AUTO ? detectScanKernel() : kernel;
+        }
+        LOG_WARNING("Ignoring unsupported LPX_SCAN_KERNEL=" + std::string(env_var));
+    }
+    return detectScanKernel();
+}
+
+static std::atomic<int> g_scanKernel(-1);
+
+const ScanKernelFunctions& getScanKernelFunctions() {
+    static const ScanKernelFunctions table[] = {
+        makeKernelFunctions(SCAN_KERNEL_SCALAR),
+        makeKernelFunctions(SCAN_KERNEL_SCALAR),
+        makeKernelFunctions(SCAN_KERNEL_SSE41),
+        makeKernelFunctions(SCAN_KERNEL_AVX2),
+        makeKernelFunctions(SCAN_KERNEL_NEON),
+    };
+
+    int kernel = g_scanKernel.load(std::memory_order_relaxed);
+    if (kernel < 0) {
+        kernel = initialScanKernel();
+        g_scanKernel.store(kernel, std::memory_order_relaxed);
+    }
+    return table[kernel];
+}
+
+bool setScanKernel(ScanKernel kernel) {
+    if (!isScanKernelSupported(kernel)) {
+        return false;
+    }
+    if (kernel == SCAN_KERNEL_AUTO) {
+        kernel = detectScanKernel();
+    }
+    g_scanKernel.store(kernel, std::memory_order_relaxed);
+    return true;
+}
+
+ScanKernel getScanKernel() {
+    return getScanKernelFunctions().kernel;
+}
+
+const char* getScanKernelName(ScanKernel kernel) {
+    switch (kernel) {
+        case SCAN_KERNEL_AUTO: return "auto";
+        case SCAN_KERNEL_SCALAR: return "scalar";
+        case SCAN_KERNEL_SSE41: return "sse4.1";
+        case SCAN_KERNEL_AVX2: return "avx2";
+        case SCAN_KERNEL_NEON: return "neon";
+    }
+    return "unknown";
+}
+
+bool parseScanKernel(const std::string& name, ScanKernel& kernel) {
+    const ScanKernel kernels[] = { SCAN_KERNEL_AUTO, SCAN_KERNEL_SCALAR, SCAN_KERNEL_SSE41,
+                                   SCAN_KERNEL_AVX2, SCAN_KERNEL_NEON };
+    for (ScanKernel k : kernels) {
+        if (name == getScanKernelName(k)) {
+            kernel = k;
+            return true;
+        }
+    }
+    return false;
+}
+
+} // namespace optimized
+} // namespace lpx
@@ -0,0 +1,428 @@
+/**
+ * scan_plan.cpp
+ *
+ * Precomputed per-fixation scan plans and their LRU cache
+ */
+
+#include "../include/lpx_optimized.h"
+#include "../include/lpx_common.h"
+#include <cstdlib>  // For getenv
+#include <string>
+
+namespace lpx {
+namespace optimized {
+
+bool ScanPlanKey::operator==(const ScanPlanKey& other) const {
+    return tables == other.tables && format == other.format && cols == other.cols && rows == other.rows &&
+           scanCols == other.scanCols && scanRows == other.scanRows &&
+           step == other.step && pixelSize == other.pixelSize && nMaxCells == other.nMaxCells &&
+           centerX == other.centerX && centerY == other.centerY && pyramidLevels == other.pyramidLevels &&
+           firstCell == other.firstCell && lastCell == other.lastCell;
+}
+
+ScanPlanKey makeScanPlanKey(const LPXTables* tables, int nMaxCells, const FrameLayout& frame,
+                            float x_center, float y_center, int pyramidLevels,
+                            int firstCell, int lastCell) {
+    ScanPlanKey key;
+    key.tables = tables;
+    key.format = frame.format;
+    key.cols = frame.width;
+    key.rows = frame.height;
+    key.scanCols = frame.scanWidth;
+    key.scanRows = frame.scanHeight;
+    key.step = frame.step;
+    key.pixelSize = frame.pixelSize;
+    key.nMaxCells = nMaxCells;
+    key.centerX = x_center;
+    key.centerY = y_center;
+    key.pyramidLevels = pyramidLevels;
+    key.firstCell = std::max(0, std::min(firstCell, nMaxCells));
+    key.lastCell = std::max(key.firstCell, std::min(lastCell, nMaxCells));
+    return key;
+}
+
+int getPyramidLevel(int64_t cellArea, int maxLevel) {
+    int level = 0;
+    while (level < maxLevel &&
+           cellArea >= static_cast<int64_t>(PYRAMID_SAMPLES_PER_CELL) << (2 * (level + 1))) {
+        level++;
+    }
+    return level;
+}
+
+// Source pixel sampled for a single scan pixel (the one under its center)
+static int nearestSourcePixel(int o, int scanLength, int sourceLength) {
+    return static_cast<int>(((2 * static_cast<int64_t>(o) + 1) * sourceLength) / (2 * static_cast<int64_t>(scanLength)));
+}
+
+// Source pixels [lo, hi) that make up scan pixel o along one axis when
+// sourceLength pixels are scanned as scanLength. Shrinking covers every source
+// pixel exactly once. Enlarging takes the source pixel nearest the scan
+// pixel's center, as a nearest-neighbour resize does, so a source pixel is
+// counted once for every scan pixel it lies under. With equal lengths scan
+// pixel o is source pixel o.
+static void mapScanPixel(int o, int scanLength, int sourceLength, int& lo, int& hi) {
+    if (sourceLength < scanLength) {
+        lo = nearestSourcePixel(o, scanLength, sourceLength);
+        hi = lo + 1;
+        return;
+    }
+    const int64_t n = scanLength;
+    const int64_t s = sourceLength;
+    lo = static_cast<int>((o * s + n - 1) / n);
+    hi = static_cast<int>(((o + 1) * s + n - 1) / n);
+}
+
+// Fovea pixel at source pixel (x, y), with the offset of its chroma sample
+static PlanFoveaPixel makeFoveaPixel(const FrameLayout& frame, int x, int y, int cell) {
+    const int step = static_cast<int>(frame.step);
+    const int chromaStep = static_cast<int>(frame.chromaStep);
+    int chromaOffset = 0;
+    if (frame.format == PIXEL_FORMAT_NV12) {
+        chromaOffset = (y / 2) * chromaStep + (x / 2) * 2;
+    } else if (frame.format == PIXEL_FORMAT_I420) {
+        chromaOffset = (y / 2) * chromaStep + x / 2;
+    } else if (frame.format == PIXEL_FORMAT_YUYV) {
+        chromaOffset = y * step + (x / 2) * 4 + 1;
+    }
+    return PlanFoveaPixel{y * step + x * frame.pixelSize, chromaOffset, cell};
+}
+
+// Spans of pyramid level `level` for the cells assigned to it. Level pixel
+// (X, Y) takes the cell of the frame pixel nearest the center of its square.
+static void buildPlanLevel(const ScanSpanTable& spans, const std::vector<uint8_t>& cellLevels,
+                           const FrameLayout& frame, int level, int scanYMin, int scanYMax,
+                           int ws_wm_jofs, int hs_hm_kofs, ScanPlanLevel& out) {
+    const int s = 1 << level;
+    const int half = s / 2;
+    const int cols = frame.width >> level;
+    const int rows = frame.height >> level;
+    const int nMaxCells = static_cast<int>(cellLevels.size());
+
+    // Level rows whose sample row is one of the scanned frame rows
+    out.yMin = std::min(rows, (scanYMin + half - 1) / s);
+    out.yMax = std::max(out.yMin, std::min(rows, (scanYMax + half - 1) / s));
+    out.rowSpanStart.clear();
+    out.spans.clear();
+    if (cols == 0) out.yMax = out.yMin;
+
+    for (int Y = out.yMin; Y < out.yMax; Y++) {
+        out.rowSpanStart.push_back(static_cast<int>(out.spans.size()));
+        const int y = Y * s + half;
+        spans.forEachSpan(hs_hm_kofs + y, ws_wm_jofs + half, ws_wm_jofs + (cols - 1) * s + half + 1,
+            [&](int startCol, int endCol, int iCell) {
+                if (iCell >= nMaxCells || cellLevels[iCell] != level) return;
+                // Level columns whose sample column falls in [startCol, endCol)
+                const int xLo = (startCol - ws_wm_jofs - half + s - 1) / s;
+                const int xHi = (endCol - ws_wm_jofs - half + s - 1) / s;
+                if (xHi > xLo) {
+                    out.spans.push_back(PlanSpan{xLo, xHi - xLo, iCell});
+                }
+            });
+    }
+    out.rowSpanStart.push_back(static_cast<int>(out.spans.size()));
+}
+
+std::shared_ptr<const ScanPlan> buildScanPlan(const ScanSpanTable& spans, int nMaxCells,
+                                              const FrameLayout& frame,
+                                              float x_center, float y_center,
+                                              int pyramidLevels, int firstCell, int lastCell) {
+    const std::shared_ptr<LPXTables>& sct = spans.sct;
+    std::shared_ptr<ScanPlan> plan = std::make_shared<ScanPlan>();
+    plan->key = makeScanPlanKey(sct.get(), nMaxCells, frame, x_center, y_center, pyramidLevels,
+                                firstCell, lastCell);
+    plan->sct = sct;
+    const int cellStart = plan->key.firstCell;
+    const int cellEnd = plan->key.lastCell;
+    plan->cellStart = cellStart;
+    plan->cellEnd = cellEnd;
+
+    // Cell geometry lives on the scan grid; pixels are read from the source frame
+    const int cols = frame.scanWidth;
+    const int rows = frame.scanHeight;
+
+    const int w_m = sct->mapWidth;
+    const int lastFoveaIndex = sct->lastFoveaIndex;
+
+    // Fovea: table order is kept so later entries for the same cell still win
+    plan->foveaCells = std::max(cellStart, std::min(lastFoveaIndex + 1, cellEnd));
+    std::vector<bool> foveaHit(plan->foveaCells, false);
+    for (int i = 0; i < sct->innerLength; i++) {
+        const int scanX = static_cast<int>(x_center + sct->innerCells[i].x - w_m / 2);
+        const int scanY = static_cast<int>(y_center + sct->innerCells[i].y - w_m / 2);
+        if (scanX < 0 || scanX >= cols || scanY < 0 || scanY >= rows) continue;
+        const int x = nearestSourcePixel(scanX, cols, frame.width);
+        const int y = nearestSourcePixel(scanY, rows, frame.height);
+
+        const int cellIndex = (i <= lastFoveaIndex && i < nMaxCells) ? i : sct->outerPixelCellIdx[i];
+        if (cellIndex >= cellStart && cellIndex < cellEnd) {
+            plan->fovea.push_back(makeFoveaPixel(frame, x, y, cellIndex));
+            if (cellIndex < plan->foveaCells) {
+                foveaHit[cellIndex] = true;
+            }
+        }
+    }
+    plan->foveaCovered = std::find(foveaHit.begin() + cellStart, foveaHit.end(), false) == foveaHit.end();
+
+    // Level each peripheral cell is read from (0 = the frame itself); cells
+    // outside the scanned range get a level no span is ever built for
+    const uint8_t UNSCANNED = 0xFF;
+    std::vector<uint8_t> cellLevels(nMaxCells, UNSCANNED);
+    std::fill(cellLevels.begin() + cellStart, cellLevels.begin() + cellEnd, 0);
+    if (pyramidLevels > 0) {
+        for (int c = std::max(lastFoveaIndex + 1, cellStart); c < cellEnd && c < static_cast<int>(spans.cellArea.size()); c++) {
+            cellLevels[c] = static_cast<uint8_t>(getPyramidLevel(spans.cellArea[c], pyramidLevels));
+        }
+    }
+
+    // Peripheral rows covered by the spiral, on the scan grid
+    const float spiralRadius = getSpiralRadius(nMaxCells, sct->spiralPer);
+    const int spRad = static_cast<int>(spiralRadius + 0.5f);
+    int scanYMin = std::max(0, static_cast<int>(y_center - spRad));
+    int scanYMax = std::max(scanYMin, std::min(rows, static_cast<int>(y_center + spRad)));
+
+    const int ws_wm_jofs = w_m / 2 - static_cast<int>(x_center);  // Map column of image column 0
+    const int hs_hm_kofs = w_m / 2 - static_cast<int>(y_center);  // Map row of image row 0
+
+    // A partial range reads only the square its last cell reaches out to
+    int scanXMin = 0;
+    int scanXMax = cols;
+    if (cellEnd < nMaxCells) {
+        const int reach = (cellEnd > 0 && cellEnd <= static_cast<int>(spans.cellReach.size()))
+                              ? spans.cellReach[cellEnd - 1] : (cellEnd > 0 ? w_m : -1);
+        scanYMin = std::max(scanYMin, w_m / 2 - reach - hs_hm_kofs);
+        scanYMax = std::max(scanYMin, std::min(scanYMax, w_m / 2 + reach + 1 - hs_hm_kofs));
+        scanXMin = std::max(0, w_m / 2 - reach - ws_wm_jofs);
+        scanXMax = std::max(scanXMin, std::min(cols, w_m / 2 + reach + 1 - ws_wm_jofs));
+    }
+
+    // Pyramid levels sample the frame itself, so there is no fused resize here.
+    // Going from the coarsest level down, cells the image edge leaves with too
+    // few samples at their level move to the next finer one.
+    plan->coarseLevels.resize(pyramidLevels);
+    std::vector<int> samples(nMaxCells);
+    for (int level = pyramidLevels; level >= 1; level--) {
+        ScanPlanLevel& out = plan->coarseLevels[level - 1];
+        buildPlanLevel(spans, cellLevels, frame, level, scanYMin, scanYMax, ws_wm_jofs, hs_hm_kofs, out);
+
+        std::fill(samples.begin(), samples.end(), 0);
+        for (const PlanSpan& span : out.spans) {
+            samples[span.cell] += span.count;
+        }
+        bool demoted = false;
+        for (int c = lastFoveaIndex + 1; c < nMaxCells; c++) {
+            if (cellLevels[c] == level && samples[c] < PYRAMID_SAMPLES_PER_CELL / 4) {
+                cellLevels[c] = static_cast<uint8_t>(level - 1);
+                demoted = true;
+            }
+        }
+        if (demoted) {
+            buildPlanLevel(spans, cellLevels, frame, level, scanYMin, scanYMax, ws_wm_jofs, hs_hm_kofs, out);
+        }
+    }
+
+    // Source columns behind every scan column
+    std::vector<int> colLo(cols), colHi(cols);
+    for (int c = 0; c < cols; c++) {
+        mapScanPixel(c, cols, frame.width, colLo[c], colHi[c]);
+    }
+
+    // Source rows behind the scanned rows
+    int rowLo = 0, rowHi = 0;
+    if (scanYMax > scanYMin) {
+        int unused;
+        mapScanPixel(scanYMin, rows, frame.height, rowLo, unused);
+        mapScanPixel(scanYMax - 1, rows, frame.height, unused, rowHi);
+    }
+    plan->yMin = rowLo;
+    plan->yMax = rowHi;
+
+    // Each scan row's spans go to every source row behind it, with their
+    // columns mapped to source columns. When columns are enlarged a span is
+    // split wherever a source column repeats, so each scan column adds its
+    // source column once, as rows repeated under several scan rows are added
+    // once per scan row.
+    const bool enlargeCols = frame.width < cols;
+    std::vector<std::vector<PlanSpan>> rowSpans(rowHi - rowLo);
+    for (int k_s = scanYMin; k_s < scanYMax; k_s++) {
+        int srcRowLo, srcRowHi;
+        mapScanPixel(k_s, rows, frame.height, srcRowLo, srcRowHi);
+
+        // Keep only peripheral cells that exist in the image
+        spans.forEachSpan(hs_hm_kofs + k_s, ws_wm_jofs + scanXMin, ws_wm_jofs + scanXMax,
+            [&](int startCol, int endCol, int iCell) {
+                if (iCell <= lastFoveaIndex || iCell >= nMaxCells || cellLevels[iCell] != 0) return;
+                auto addSpan = [&](int srcStart, int srcEnd) {
+                    for (int row = srcRowLo; row < srcRowHi; row++) {
+                        rowSpans[row - rowLo].push_back(PlanSpan{srcStart, srcEnd - srcStart, iCell});
+                    }
+                };
+                const int first = startCol - ws_wm_jofs;
+                const int last = endCol - ws_wm_jofs;
+                if (!enlargeCols) {
+                    addSpan(colLo[first], colHi[last - 1]);
+                    return;
+                }
+                for (int c = first; c < last; ) {
+                    const int srcStart = colLo[c];
+                    int srcEnd = srcStart + 1;
+                    for (c++; c < last && colLo[c] == srcEnd; c++) {
+                        srcEnd++;
+                    }
+                    addSpan(srcStart, srcEnd);
+                }
+            });
+    }
+
+    plan->rowSpanStart.reserve(rowSpans.size() + 1);
+    for (const std::vector<PlanSpan>& row : rowSpans) {
+        plan->rowSpanStart.push_back(static_cast<int>(plan->spans.size()));
+        plan->spans.insert(plan->spans.end(), row.begin(), row.end());
+    }
+    plan->rowSpanStart.push_back(static_cast<int>(plan->spans.size()));
+
+    return plan;
+}
+
+void buildCellScanPlan(const ScanSpanTable& spans, const CellSpanIndex& index, int nMaxCells,
+                       const FrameLayout& frame, float x_center, float y_center,
+                       const int* cells, int nCells, ScanPlan& plan) {
+    const std::shared_ptr<LPXTables>& sct = spans.sct;
+    plan.key = makeScanPlanKey(sct.get(), nMaxCells, frame, x_center, y_center);
+    plan.sct = sct;
+    plan.cellStart = 0;
+    plan.cellEnd = nMaxCells;
+    plan.coarseLevels.clear();
+
+    const int cols = frame.width;
+    const int rows = frame.height;
+    const int w_m = sct->mapWidth;
+    const int lastFoveaIndex = sct->lastFoveaIndex;
+    plan.foveaCells = std::min(lastFoveaIndex + 1, nMaxCells);
+    plan.foveaCovered = false;  // Cells not listed are never gathered
+
+    // Fovea cells: the last table entry inside the image, as a full scan keeps
+    plan.fovea.clear();
+    for (int n = 0; n < nCells; n++) {
+        const int cell = cells[n];
+        if (cell >= plan.foveaCells || cell >= index.cellCount()) continue;
+        for (int k = index.cellInnerStart[cell]; k < index.cellInnerStart[cell + 1]; k++) {
+            const int i = index.cellInner[k];
+            const int x = static_cast<int>(x_center + sct->innerCells[i].x - w_m / 2);
+            const int y = static_cast<int>(y_center + sct->innerCells[i].y - w_m / 2);
+            if (x < 0 || x >= cols || y < 0 || y >= rows) continue;
+            plan.fovea.push_back(makeFoveaPixel(frame, x, y, cell));
+            break;
+        }
+    }
+
+    // Peripheral rows covered by the spiral, as in buildScanPlan
+    const int spRad = (nMaxCells == index.spiralCells)
+                          ? index.spiralRadius
+                          : static_cast<int>(getSpiralRadius(nMaxCells, sct->spiralPer) + 0.5f);
+    const int yMin = std::max(0, static_cast<int>(y_center - spRad));
+    const int yMax = std::max(yMin, std::min(rows, static_cast<int>(y_center + spRad)));
+    const int ws_wm_jofs = w_m / 2 - static_cast<int>(x_center);  // Map column of image column 0
+    const int hs_hm_kofs = w_m / 2 - static_cast<int>(y_center);  // Map row of image row 0
+
+    // Map spans of the peripheral cells moved to image coordinates and
+    // clipped, visited twice: once to count the spans of each row, then to
+    // place them. A cell's spans are in map order, so each cell still sums
+    // its pixels row by row, left to right.
+    plan.yMin = yMin;
+    plan.yMax = yMax;
+    plan.rowSpanStart.assign(yMax - yMin + 1, 0);
+    auto forEachCellSpan = [&](auto&& fn) {
+        for (int n = 0; n < nCells; n++) {
+            const int cell = cells[n];
+            if (cell <= lastFoveaIndex || cell >= nMaxCells || cell >= index.cellCount()) continue;
+            for (int k = index.cellSpanStart[cell]; k < index.cellSpanStart[cell + 1]; k++) {
+                const MapSpan& span = index.cellSpans[k];
+                const int y = span.row - hs_hm_kofs;
+                if (y < yMin || y >= yMax) continue;
+                const int start = std::max(span.col - ws_wm_jofs, 0);
+                const int end = std::min(span.col + span.count - ws_wm_jofs, cols);
+                if (start < end) fn(y, start, end - start, cell);
+            }
+        }
+    };
+    forEachCellSpan([&](int y, int, int, int) { plan.rowSpanStart[y - yMin + 1]++; });
+    for (size_t r = 1; r < plan.rowSpanStart.size(); r++) {
+        plan.rowSpanStart[r] += plan.rowSpanStart[r - 1];
+    }
+    plan.spans.resize(plan.rowSpanStart.back());
+    forEachCellSpan([&](int y, int col, int count, int cell) {
+        plan.spans[plan.rowSpanStart[y - yMin]++] = PlanSpan{col, count, cell};
+    });
+    // Placing advanced each row's start to the next row's; shift them back
+    for (size_t r = plan.rowSpanStart.size() - 1; r > 0; r--) {
+        plan.rowSpanStart[r] = plan.rowSpanStart[r - 1];
+    }
+    plan.rowSpanStart[0] = 0;
+}
+
+ScanPlanCache::ScanPlanCache(size_t capacity) : maxPlans(capacity) {
+}
+
+std::shared_ptr<const ScanPlan> ScanPlanCache::get(const ScanSpanTable& spans, int nMaxCells,
+                                                   const FrameLayout& frame,
+                                                   float x_center, float y_center,
+                                                   int pyramidLevels, int firstCell, int lastCell) {
+    const ScanPlanKey key = makeScanPlanKey(spans.sct.get(), nMaxCells, frame, x_center, y_center,
+                                            pyramidLevels, firstCell, lastCell);
+
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        for (auto it = plans.begin(); it != plans.end(); ++it) {
+            if ((*it)->key == key) {
+                plans.splice(plans.begin(), plans, it);  // Mark as most recently used
+                return plans.front();
+            }
+        }
+    }
+
+    // Build outside the lock so scans at other fixations are not held up
+    std::shared_ptr<const ScanPlan> plan = buildScanPlan(spans, nMaxCells, frame, x_center, y_center,
+                                                         pyramidLevels, firstCell, lastCell);
+
+    std::lock_guard<std::mutex> lock(mutex);
+    for (const auto& cached : plans) {
+        if (cached->key == key) return cached;  // Another scan built it meanwhile
+    }
+    if (maxPlans > 0) {
+        plans.push_front(plan);
+        while (plans.size() > maxPlans) {
+            plans.pop_back();
+        }
+    }
+    return plan;
+}
+
+void ScanPlanCache::setCapacity(size_t capacity) {
+    std::lock_guard<std::mutex> lock(mutex);
+    maxPlans = capacity;
+    while (plans.size() > maxPlans) {
+        plans.pop_back();
+    }
+}
+
+size_t ScanPlanCache::capacity() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return maxPlans;
+}
+
+void ScanPlanCache::clear() {
+    std::lock_guard<std::mutex> lock(mutex);
+    plans.clear();
+}
+
+ScanPlanCache& getScanPlanCache() {
+    static ScanPlanCache cache([]() {
+        const char* env_var = std::getenv("LPX_SCAN_PLAN_CACHE");
+        return (env_var != nullptr) ? static_cast<size_t>(std::max(0, std::atoi(env_var))) : size_t(8);
+    }());
+    return cache;
+}
+
+} // namespace optimized
+} // namespace lpx
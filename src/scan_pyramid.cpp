@@ -0,0 +1,61 @@
+/**
+ * scan_pyramid.cpp
+ *
+ * Box-filtered image pyramid read by the outer rings of a pyramid scan
+ */
+
+#include "../include/lpx_optimized.h"
+#include "../include/lpx_common.h"
+
+namespace lpx {
+namespace optimized {
+
+bool buildScanPyramid(const cv::Mat& image, int numLevels, std::vector<cv::Mat>& pyramid,
+                      PixelFormat format) {
+    return buildScanPyramid(getScanThreadPool(), image, numLevels, pyramid, format);
+}
+
+bool buildScanPyramid(ScanThreadPool& pool, const cv::Mat& image, int numLevels,
+                      std::vector<cv::Mat>& pyramid, PixelFormat format) {
+    FrameLayout frame;
+    if (numLevels < 0 || !describeFrame(image, format, frame) || frame.isYUV() || frame.depth != CV_8U) {
+        LOG_ERROR(std::string("Cannot build a scan pyramid for pixel format ") + getPixelFormatName(format));
+        return false;
+    }
+
+    pyramid.resize(numLevels + 1);
+    pyramid[0] = image;
+
+    const ScanKernelFunctions& kernel = getScanKernelFunctions();
+    const DownsampleRowFn downsampleRow = (frame.pixelSize == 1) ? kernel.downsampleGray :
+                                          (frame.pixelSize == 3) ? kernel.downsampleBGR : kernel.downsampleBGRA;
+
+    auto poolLock = pool.acquire();
+
+    for (int l = 1; l <= numLevels; l++) {
+        const cv::Mat& src = pyramid[l - 1];
+        if (src.rows < 2 || src.cols < 2) {
+            pyramid.resize(l);  // Image too small for more levels
+            break;
+        }
+        cv::Mat& dst = pyramid[l];
+        dst.create(src.rows / 2, src.cols / 2, image.type());  // No-op when the size is unchanged
+
+        // Row bands of at least 16 output rows per worker
+        const int numBands = std::max(1, std::min(static_cast<int>(pool.size()), dst.rows / 16));
+        const int rowsPerBand = dst.rows / numBands;
+        auto downsampleBand = [&](int band, int) {
+            const int yStart = band * rowsPerBand;
+            const int yEnd = (band == numBands - 1) ? dst.rows : yStart + rowsPerBand;
+            for (int y = yStart; y < yEnd; y++) {
+                downsampleRow(src.ptr<uchar>(2 * y), src.ptr<uchar>(2 * y + 1), dst.ptr<uchar>(y), dst.cols);
+            }
+        };
+        pool.parallelFor(numBands, downsampleBand);
+    }
+
+    return true;
+}
+
+} // namespace optimized
+} // namespace lpx
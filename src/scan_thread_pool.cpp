@@ -0,0 +1,186 @@
+/**
+ * scan_thread_pool.cpp
+ *
+ * Persistent worker pool used by the optimized log-polar scan
+ */
+
+#include "../include/lpx_optimized.h"
+#include "../include/lpx_common.h"
+#include <cstdlib>  // For getenv
+#include <string>
+
+#include <pthread.h>
+#include <sched.h>
+
+namespace lpx {
+namespace optimized {
+
+// Pin the calling thread to a single core (no-op where affinity is unsupported)
+static void pinCurrentThread(unsigned int core) {
+#ifdef __linux__
+    const unsigned int numCores = std::max(1u, std::thread::hardware_concurrency());
+    cpu_set_t cpuset;
+    CPU_ZERO(&cpuset);
+    CPU_SET(core % numCores, &cpuset);
+    if (pthread_setaffinity_np(pthread_self(), sizeof(cpu_set_t), &cpuset) != 0) {
+        LOG_WARNING("Failed to pin scan worker to core " + std::to_string(core));
+    }
+#else
+    (void)core;
+#endif
+}
+
+ScanThreadPool::ScanThreadPool() : nextTask(0) {
+    unsigned int requested = 0;
+    bool pin = false;
+
+    const char* threadsVar = std::getenv("LPX_SCAN_THREADS");
+    if (threadsVar != nullptr) {
+        requested = static_cast<unsigned int>(std::max(0, std::atoi(threadsVar)));
+    }
+    const char* pinVar = std::getenv("LPX_PIN_SCAN_THREADS");
+    if (pinVar != nullptr) {
+        pin = (std::string(pinVar) == "1" || std::string(pinVar) == "true");
+    }
+
+    configure(requested, pin);
+}
+
+ScanThreadPool::ScanThreadPool(unsigned int numThreads, bool pinThreads) : nextTask(0) {
+    configure(numThreads, pinThreads);
+}
+
+ScanThreadPool::~ScanThreadPool() {
+    std::lock_guard<std::mutex> dispatchLock(dispatchMutex);
+    stopWorkers();
+}
+
+void ScanThreadPool::configure(unsigned int threads, bool pin) {
+    if (threads == 0) {
+        threads = std::max(1u, std::thread::hardware_concurrency());
+    }
+
+    std::lock_guard<std::mutex> ownerLock(ownerMutex);
+    std::lock_guard<std::mutex> dispatchLock(dispatchMutex);
+    if (scratch.size() == threads && pin == pinThreads) {
+        return;
+    }
+
+    stopWorkers();
+    numThreads = threads;
+    pinThreads = pin;
+    scratch.resize(numThreads);
+    wideScratch.resize(numThreads);
+    statsScratch.resize(numThreads);
+    startWorkers();
+
+    LOG_DEBUG("Scan thread pool: " + std::to_string(numThreads) + " threads" +
+              (pinThreads ? " (pinned)" : ""));
+}
+
+void ScanThreadPool::startWorkers() {
+    stopping = false;
+
+    // Worker 0 is the calling thread, so start numThreads - 1 background threads.
+    // They start from the current generation so they only pick up new jobs.
+    for (unsigned int w = 1; w < numThreads; w++) {
+        workers.emplace_back(&ScanThreadPool::workerLoop, this, static_cast<int>(w), generation);
+    }
+}
+
+void ScanThreadPool::stopWorkers() {
+    {
+        std::lock_guard<std::mutex> lock(stateMutex);
+        stopping = true;
+    }
+    wakeCondition.notify_all();
+
+    for (auto& worker : workers) {
+        if (worker.joinable()) {
+            worker.join();
+        }
+    }
+    workers.clear();
+}
+
+void ScanThreadPool::runTasks(int worker) {
+    for (;;) {
+        const int task = nextTask.fetch_add(1, std::memory_order_relaxed);
+        if (task >= jobTasks) break;
+        jobFn(jobContext, task, worker);
+    }
+}
+
+void ScanThreadPool::workerLoop(int worker, unsigned long seenGeneration) {
+    if (pinThreads) {
+        pinCurrentThread(static_cast<unsigned int>(worker));
+    }
+
+    for (;;) {
+        {
+            std::unique_lock<std::mutex> lock(stateMutex);
+            wakeCondition.wait(lock, [&]() { return stopping || generation != seenGeneration; });
+            if (stopping) return;
+            seenGeneration = generation;
+        }
+
+        runTasks(worker);
+
+        // Check out of this job; the dispatcher waits for every worker so the
+        // job's function and context stay valid while anyone might use them
+        std::lock_guard<std::mutex> lock(stateMutex);
+        if (--workersRunning == 0) {
+            doneCondition.notify_one();
+        }
+    }
+}
+
+void ScanThreadPool::run(int numTasks, TaskFn fn, void* context) {
+    if (numTasks <= 0) return;
+
+    std::lock_guard<std::mutex> dispatchLock(dispatchMutex);
+
+    // Not worth waking the pool for a single task
+    if (workers.empty() || numTasks == 1) {
+        for (int task = 0; task < numTasks; task++) {
+            fn(context, task, 0);
+        }
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(stateMutex);
+        jobFn = fn;
+        jobContext = context;
+        jobTasks = numTasks;
+        nextTask.store(0, std::memory_order_relaxed);
+        workersRunning = static_cast<int>(workers.size());
+        generation++;
+    }
+    wakeCondition.notify_all();
+
+    // The calling thread works as worker 0
+    runTasks(0);
+
+    std::unique_lock<std::mutex> lock(stateMutex);
+    doneCondition.wait(lock, [&]() { return workersRunning == 0; });
+    jobFn = nullptr;
+    jobContext = nullptr;
+}
+
+ScanThreadPool& getScanThreadPool() {
+    static ScanThreadPool pool;
+    return pool;
+}
+
+void setScanThreadCount(unsigned int numThreads) {
+    ScanThreadPool& pool = getScanThreadPool();
+    pool.configure(numThreads, pool.isPinned());
+}
+
+unsigned int getScanThreadCount() {
+    return getScanThreadPool().size();
+}
+
+} // namespace optimized
+} // namespace lpx
@@ -0,0 +1,73 @@
+#!/usr/bin/env python3
+"""
+Test that the batched cell lookup gives exactly the cells of getXCellIndex
+"""
+
+import numpy as np
+import lpximage
+
+tables = lpximage.LPXTables("../ScanTables63")
+if not tables.isInitialized():
+    print("❌ Failed to load ../ScanTables63")
+    exit(1)
+
+kernels = lpximage.getAvailableScanKernels()
+print(f"Available kernels: {kernels}")
+
+def batch_cells(kernel, xs, ys, spiral_per):
+    lpximage.setScanKernel(kernel)
+    return lpximage.getXCellIndices(xs, ys, spiral_per)
+
+failures = 0
+
+# Every point of the tables' map, a band of rows at a time. The scalar kernel
+# takes each point through getXCellIndex.
+half = tables.mapWidth // 2
+cols = np.arange(tables.mapWidth, dtype=np.float32) - half
+for first_row in range(0, tables.mapWidth, 500):
+    rows = np.arange(first_row, min(first_row + 500, tables.mapWidth), dtype=np.float32) - half
+    xs, ys = np.meshgrid(cols, rows)
+    xs, ys = xs.ravel(), ys.ravel()
+    expected = batch_cells("scalar", xs, ys, tables.spiralPer)
+    for kernel in kernels:
+        cells = batch_cells(kernel, xs, ys, tables.spiralPer)
+        if np.any(cells != expected):
+            print(f"❌ {kernel}: {np.count_nonzero(cells != expected)} map cells differ in rows from {first_row}")
+            failures += 1
+if not failures:
+    print(f"✓ All {tables.mapWidth}x{tables.mapWidth} map points match for every kernel")
+
+# Points between pixels, near the center and beyond the spiral, for other periods
+rng = np.random.default_rng(25)
+edge_x = np.array([0.0, -0.0, 0.0, 1.0, -1.0, 0.3, 1e-7, 9999.5, 10000.5, 20000.0, 3.0], dtype=np.float32)
+edge_y = np.array([0.0, 0.0, -0.0, -0.0, -0.0, 0.2, -1e-7, 0.0, 0.0, 0.0, -1e-30], dtype=np.float32)
+for spiral_per in [1.5, 15.5, 31.5, 63.5, 127.5, 400.5]:
+    xs = np.concatenate([rng.uniform(-6000, 6000, 200000), rng.uniform(-4, 4, 20000), edge_x]).astype(np.float32)
+    ys = np.concatenate([rng.uniform(-6000, 6000, 200000), rng.uniform(-4, 4, 20000), edge_y]).astype(np.float32)
+    expected = batch_cells("scalar", xs, ys, spiral_per)
+    for kernel in kernels:
+        cells = batch_cells(kernel, xs, ys, spiral_per)
+        if np.any(cells != expected):
+            print(f"❌ {kernel}: {np.count_nonzero(cells != expected)} cells differ at spiral period {spiral_per}")
+            failures += 1
+
+    # The scalar batch is getXCellIndex itself
+    for i in rng.choice(len(xs), 2000, replace=False).tolist() + list(range(len(xs) - len(edge_x), len(xs))):
+        if expected[i] != lpximage.getXCellIndex(float(xs[i]), float(ys[i]), spiral_per):
+            print(f"❌ Scalar batch differs from getXCellIndex at ({xs[i]}, {ys[i]}), spiral period {spiral_per}")
+            failures += 1
+            break
+
+lpximage.setScanKernel("auto")
+
+try:
+    lpximage.getXCellIndices(np.zeros(3, dtype=np.float32), np.zeros(2, dtype=np.float32), 63.5)
+    print("❌ Point arrays of different lengths were accepted")
+    failures += 1
+except ValueError:
+    pass
+
+if failures:
+    print(f"❌ {failures} cell lookup checks failed")
+    exit(1)
+print("✓ Batched cell lookups match getXCellIndex")
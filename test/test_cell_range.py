@@ -0,0 +1,55 @@
+#!/usr/bin/env python3
+"""
+Test that scanning a range of cells matches a full scan on those cells and
+leaves the rest empty
+"""
+
+import numpy as np
+import lpximage
+
+if not lpximage.initLPX("../ScanTables63", 640, 480):
+    print("❌ Failed to initialize LPX system")
+    exit(1)
+
+def cell_values(lpx_image):
+    return [lpx_image.getCellValue(i) for i in range(lpx_image.getLength())]
+
+rng = np.random.default_rng(29)
+noise = rng.integers(0, 256, size=(480, 640, 3), dtype=np.uint8)
+gray = noise[:, :, :1].copy()
+
+tables = lpximage.LPXTables("../ScanTables63")
+fovea_end = tables.lastFoveaIndex + 1
+ranges = [(0, fovea_end), (0, 100), (fovea_end, -1), (5, 37), (1000, 3000), (17, 50000), (3000, 2000)]
+
+failures = 0
+
+for image in (noise, gray):
+    for cx, cy in [(320.0, 240.0), (0.0, 0.0), (600.5, 100.25)]:
+        full = cell_values(lpximage.scanImage(image, cx, cy))
+        for first, last in ranges:
+            part = cell_values(lpximage.scanImage(image, cx, cy, firstCell=first, lastCell=last))
+            end = len(full) if last < 0 else max(first, min(last, len(full)))
+            expected = [v if first <= i < end else 0 for i, v in enumerate(full)]
+            if part != expected:
+                print(f"❌ Cells [{first}, {last}) at ({cx}, {cy}) differ from a full scan")
+                failures += 1
+
+# The engine takes the same range
+engine = lpximage.LPXScanEngine(tables, 2)
+if cell_values(engine.scanImage(noise, 320.0, 240.0, firstCell=0, lastCell=fovea_end)) != \
+        cell_values(lpximage.scanImage(noise, 320.0, 240.0, firstCell=0, lastCell=fovea_end)):
+    print("❌ Engine fovea scan differs from the module scan")
+    failures += 1
+
+try:
+    lpximage.scanImage(noise, 320.0, 240.0, pyramidLevels=2, firstCell=0, lastCell=fovea_end)
+    print("❌ A cell range with pyramidLevels was accepted")
+    failures += 1
+except ValueError:
+    pass
+
+if failures:
+    print(f"❌ {failures} cell range checks failed")
+    exit(1)
+print("✓ Cell range scans match full scans")
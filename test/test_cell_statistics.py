@@ -0,0 +1,82 @@
+#!/usr/bin/env python3
+"""
+Test the per-cell variance, minimum and maximum gathered during a scan
+"""
+
+import numpy as np
+import lpximage
+
+if not lpximage.initLPX("../ScanTables63", 640, 480):
+    print("❌ Failed to initialize LPX system")
+    exit(1)
+
+def cell_values(lpx_image):
+    return [lpx_image.getCellValue(i) for i in range(lpx_image.getLength())]
+
+rng = np.random.default_rng(31)
+failures = 0
+
+# Variance is E[x^2] - E[x]^2, which precise scans of x and x^2 give independently
+frame = rng.random(size=(480, 640, 3), dtype=np.float32)
+for cx, cy in [(0.0, 0.0), (200.5, -100.25)]:
+    result = lpximage.scanImage(frame, cx, cy, precise=True, statistics=True)
+    means = result.getPreciseCellValues().astype(np.float64)
+    squares = lpximage.scanImage(frame * frame, cx, cy, precise=True).getPreciseCellValues().astype(np.float64)
+    if not np.allclose(result.getCellVariances(), squares - means * means, atol=1e-5):
+        print(f"❌ Variances at ({cx}, {cy}) differ from E[x^2] - E[x]^2")
+        failures += 1
+    minima, maxima = result.getCellMinima(), result.getCellMaxima()
+    if np.any(minima > means + 1e-6) or np.any(maxima < means - 1e-6):
+        print(f"❌ Cell means at ({cx}, {cy}) fall outside their minimum and maximum")
+        failures += 1
+    if cell_values(result) != cell_values(lpximage.scanImage(frame, cx, cy)):
+        print(f"❌ Statistics changed the cells at ({cx}, {cy})")
+        failures += 1
+
+# Two-level noise: every minimum and maximum is one of the levels
+levels = np.where(rng.random(size=(480, 640, 1)) < 0.5, 10, 200).astype(np.uint8)
+result = lpximage.scanImage(levels, 0.0, 0.0, statistics=True)
+variances, minima, maxima = result.getCellVariances(), result.getCellMinima(), result.getCellMaxima()
+scanned = np.array(cell_values(result)) != 0
+if not np.all(np.isin(minima[scanned], [10, 200])) or not np.all(np.isin(maxima[scanned], [10, 200])):
+    print("❌ Minima or maxima are not pixel values")
+    failures += 1
+if np.any((variances[scanned] == 0) != (minima[scanned] == maxima[scanned])):
+    print("❌ Zero variance does not match equal minimum and maximum")
+    failures += 1
+
+# A flat frame has no variance anywhere
+flat = np.full((480, 640, 3), (30, 60, 90), dtype=np.uint8)
+result = lpximage.scanImage(flat, 0.0, 0.0, statistics=True)
+scanned = np.array(cell_values(result)) != 0
+if np.any(result.getCellVariances() != 0) or \
+   np.any(result.getCellMinima()[scanned] != [30, 60, 90]) or np.any(result.getCellMaxima()[scanned] != [30, 60, 90]):
+    print("❌ A flat frame has non-zero variance or wrong extremes")
+    failures += 1
+
+# Only cells in a partial scan's range get statistics
+result = lpximage.scanImage(levels, 0.0, 0.0, firstCell=3000, lastCell=4000, statistics=True)
+if np.any(result.getCellMaxima()[:3000] != 0) or np.any(result.getCellMaxima()[4000:] != 0):
+    print("❌ Cells outside the range have statistics")
+    failures += 1
+
+# Without statistics nothing is kept
+plain = lpximage.scanImage(flat, 0.0, 0.0)
+if plain.hasCellStatistics() or plain.getCellVariances().size != 0:
+    print("❌ Statistics were kept without being requested")
+    failures += 1
+
+# YUV frames and pyramid scans are rejected
+for kwargs in ({"format": "nv12"}, {"pyramidLevels": 2}):
+    try:
+        image = np.zeros((720, 640, 1), dtype=np.uint8) if "format" in kwargs else flat
+        lpximage.scanImage(image, 0.0, 0.0, statistics=True, **kwargs)
+        print(f"❌ Statistics were accepted with {kwargs}")
+        failures += 1
+    except Exception:
+        pass
+
+if failures:
+    print(f"❌ {failures} cell statistics checks failed")
+    exit(1)
+print("✓ Cell statistics match the scanned pixels")
@@ -0,0 +1,80 @@
+#!/usr/bin/env python3
+"""
+Test that delta scans of a mostly static scene match full scans
+"""
+
+import numpy as np
+import lpximage
+
+if not lpximage.initLPX("../ScanTables63", 640, 480):
+    print("❌ Failed to initialize LPX system")
+    exit(1)
+
+def cell_values(lpx_image):
+    return [lpx_image.getCellValue(i) for i in range(lpx_image.getLength())]
+
+rng = np.random.default_rng(41)
+failures = 0
+
+background = rng.integers(0, 256, size=(480, 640, 3), dtype=np.uint8)
+for tile_size in (16, 7):
+    for cx, cy, first, last in [(320.0, 240.0, 0, -1), (100.5, 400.25, 0, -1), (320.0, 240.0, 1000, 3000)]:
+        scanner = lpximage.LPXDeltaScanner(tileSize=tile_size)
+        frame = background.copy()
+        for i in range(8):
+            # A few moving patches, and an unchanged frame now and then
+            if i % 3 != 2:
+                for _ in range(3):
+                    x, y = rng.integers(0, 600), rng.integers(0, 440)
+                    frame[y:y + 40, x:x + 40] = rng.integers(0, 256, size=frame[y:y + 40, x:x + 40].shape)
+            result = scanner.scanImage(frame, cx, cy, firstCell=first, lastCell=last)
+            expected = lpximage.scanImage(frame, cx, cy, firstCell=first, lastCell=last)
+            if cell_values(result) != cell_values(expected):
+                print(f"❌ Delta scan {i} at ({cx}, {cy}) with {tile_size}-pixel tiles differs from scanImage")
+                failures += 1
+            if scanner.wasFullScan() != (i == 0):
+                print(f"❌ Scan {i} at ({cx}, {cy}) was{'' if scanner.wasFullScan() else ' not'} a full scan")
+                failures += 1
+            if i % 3 == 2 and scanner.getChangedTileCount() != 0:
+                print("❌ An unchanged frame had changed tiles")
+                failures += 1
+
+# Small changes touch few tiles
+scanner = lpximage.LPXDeltaScanner()
+frame = background.copy()
+scanner.scanImage(frame, 320.0, 240.0)
+frame[100:110, 200:210] = 0
+scanner.scanImage(frame, 320.0, 240.0)
+if not 1 <= scanner.getChangedTileCount() <= 4:
+    print(f"❌ A 10x10 change touched {scanner.getChangedTileCount()} tiles")
+    failures += 1
+
+# Moving the fixation, reset() and precise output force full scans
+image = lpximage.LPXImage(scanner.getScanTables(), 640, 480)
+for name, scan in [("new fixation", lambda: scanner.scanInto(image, frame, 300.0, 240.0)),
+                   ("reset", lambda: (scanner.reset(), scanner.scanInto(image, frame, 300.0, 240.0))),
+                   ("precise", lambda: (image.setPreciseOutput(True), scanner.scanInto(image, frame, 300.0, 240.0)))]:
+    scan()
+    if not scanner.wasFullScan():
+        print(f"❌ A {name} did not force a full scan")
+        failures += 1
+frame[0:50, 0:50] = 255
+scanner.scanInto(image, frame, 300.0, 240.0)
+expected = lpximage.scanImage(frame, 300.0, 240.0, precise=True)
+if not np.array_equal(image.getPreciseCellValues(), expected.getPreciseCellValues()):
+    print("❌ Precise delta values differ from scanImage")
+    failures += 1
+
+# Deep and YUV frames are rejected
+for image, fmt in [(background.astype(np.float32), "auto"), (np.zeros((720, 640, 1), dtype=np.uint8), "nv12")]:
+    try:
+        lpximage.LPXDeltaScanner().scanImage(image, 0.0, 0.0, format=fmt)
+        print(f"❌ A {image.dtype} {fmt} frame was accepted")
+        failures += 1
+    except Exception:
+        pass
+
+if failures:
+    print(f"❌ {failures} delta scan checks failed")
+    exit(1)
+print("✓ Delta scans match full scans")
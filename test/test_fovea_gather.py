@@ -0,0 +1,52 @@
+#!/usr/bin/env python3
+"""
+Test the fovea gather for colour, grayscale and edge-of-image fixations
+"""
+
+import numpy as np
+import lpximage
+
+if not lpximage.initLPX("../ScanTables63", 640, 480):
+    print("❌ Failed to initialize LPX system")
+    exit(1)
+
+# Fovea cells take single pixels; the center cell of a scan over a flat patch
+# must be exactly the patch colour
+FOVEA_CELLS = 100
+failures = 0
+
+color = np.zeros((480, 640, 3), dtype=np.uint8)
+color[200:280, 280:360] = (10, 20, 30)  # B, G, R
+lpx_image = lpximage.scanImage(color, 320.0, 240.0)
+expected = 10 | (20 << 8) | (30 << 16)
+if any(lpx_image.getCellValue(i) != expected for i in range(FOVEA_CELLS)):
+    print("❌ Colour fovea cells do not match the patch")
+    failures += 1
+else:
+    print("✓ Colour fovea cells match the patch")
+
+gray = np.zeros((480, 640, 1), dtype=np.uint8)
+gray[200:280, 280:360] = 77
+lpx_image = lpximage.scanImage(gray, 320.0, 240.0)
+expected = 77 | (77 << 8) | (77 << 16)
+if any(lpx_image.getCellValue(i) != expected for i in range(FOVEA_CELLS)):
+    print("❌ Grayscale fovea cells do not replicate the intensity")
+    failures += 1
+else:
+    print("✓ Grayscale fovea cells replicate the intensity")
+
+# Fixating the top-left corner leaves three quarters of the fovea off the image;
+# those cells must stay empty rather than read outside the frame
+white = np.full((480, 640, 3), 255, dtype=np.uint8)
+lpx_image = lpximage.scanImage(white, 0.0, 0.0)
+values = [lpx_image.getCellValue(i) for i in range(FOVEA_CELLS)]
+if not all(v in (0, 0xFFFFFF) for v in values) or 0 not in values or 0xFFFFFF not in values:
+    print("❌ Corner fixation sampled pixels outside the image")
+    failures += 1
+else:
+    print("✓ Corner fixation keeps off-image fovea cells empty")
+
+if failures:
+    print(f"❌ {failures} fovea checks failed")
+    exit(1)
+print("✓ Fovea gather checks passed")
@@ -0,0 +1,73 @@
+#!/usr/bin/env python3
+"""
+Test scanning with the resize folded into the scan (scanImage scale argument)
+"""
+
+import numpy as np
+import lpximage
+
+if not lpximage.initLPX("../ScanTables63", 640, 480):
+    print("❌ Failed to initialize LPX system")
+    exit(1)
+
+rng = np.random.default_rng(8)
+failures = 0
+
+def scan_cells(image, cx, cy, scale=1.0):
+    lpx_image = lpximage.scanImage(image, cx, cy, "auto", scale)
+    return lpx_image, [lpx_image.getCellValue(i) for i in range(lpx_image.getLength())]
+
+small = rng.integers(0, 256, size=(240, 320, 3), dtype=np.uint8)
+
+# Every pixel of `small` repeated as a 2x2 block: shrinking it back by half
+# inside the scan must give exactly the scan of `small`
+doubled = np.ascontiguousarray(np.repeat(np.repeat(small, 2, axis=0), 2, axis=1))
+
+for cx, cy in [(160.0, 120.0), (100.5, 60.25), (0.0, 0.0), (319.0, 239.0)]:
+    _, expected = scan_cells(small, cx, cy)
+    lpx_image, cells = scan_cells(doubled, cx, cy, 0.5)
+    if cells != expected:
+        print(f"❌ Half-size fused scan at ({cx}, {cy}) differs from scanning the small image")
+        failures += 1
+    else:
+        print(f"✓ Half-size fused scan at ({cx}, {cy}) matches")
+
+if lpx_image.getWidth() != 320 or lpx_image.getHeight() != 240:
+    print("❌ Fused scan reports the source size instead of the scanned size")
+    failures += 1
+
+# A scale of 1 is the ordinary scan
+_, plain = scan_cells(small, 160.0, 120.0)
+_, unscaled = scan_cells(small, 160.0, 120.0, 1.0)
+if plain != unscaled:
+    print("❌ scale=1.0 changes the scan")
+    failures += 1
+
+# Enlarging repeats source pixels, so a flat image stays flat
+flat = np.full((120, 160, 3), (40, 80, 120), dtype=np.uint8)
+_, cells = scan_cells(flat, 240.0, 180.0, 3.0)
+expected_value = 40 | (80 << 8) | (120 << 16)
+# (cells past the image edge stay empty)
+if any(c not in (0, expected_value) for c in cells) or cells[:2730].count(expected_value) != 2730:
+    print("❌ Enlarged flat image does not stay flat")
+    failures += 1
+else:
+    print("✓ Enlarged flat image stays flat")
+
+# Enlarging by a whole factor is a nearest-neighbour resize: the fused scan
+# must match scanning an explicit np.repeat upscale
+patch = np.ascontiguousarray(small[:120, :160])
+for factor, cx, cy in [(3, 240.0, 180.0), (3, 100.5, 250.25), (2, 160.0, 120.0)]:
+    upscaled = np.ascontiguousarray(np.repeat(np.repeat(patch, factor, axis=0), factor, axis=1))
+    _, expected = scan_cells(upscaled, cx, cy)
+    _, cells = scan_cells(patch, cx, cy, float(factor))
+    if cells != expected:
+        print(f"❌ {factor}x fused enlargement at ({cx}, {cy}) differs from scanning the repeated image")
+        failures += 1
+    else:
+        print(f"✓ {factor}x fused enlargement at ({cx}, {cy}) matches")
+
+if failures:
+    print(f"❌ {failures} fused resize checks failed")
+    exit(1)
+print("✓ Fused resize checks passed")
@@ -0,0 +1,62 @@
+#!/usr/bin/env python3
+"""
+Test the luminance, green-red and yellow-blue planes filled during a scan
+"""
+
+import numpy as np
+import lpximage
+
+if not lpximage.initLPX("../ScanTables63", 640, 480):
+    print("❌ Failed to initialize LPX system")
+    exit(1)
+
+def expected_planes(lpx_image):
+    # The conversions LPXVision applies to each packed cell
+    cells = np.array([lpx_image.getCellValue(i) for i in range(lpx_image.getMaxCells())], dtype=np.int64)
+    b, g, r = cells & 0xFF, (cells >> 8) & 0xFF, (cells >> 16) & 0xFF
+    luminance = ((0.299 * r + 0.587 * g + 0.114 * b) * 1023.0 / 255.0).astype(np.int64)
+    green_red = np.trunc((g - r) * 1023 / 255).astype(np.int64)
+    yellow_blue = np.trunc(((r + g) // 2 - b) * 1023 / 255).astype(np.int64)
+    return np.stack([luminance, green_red, yellow_blue])
+
+rng = np.random.default_rng(43)
+frame = rng.integers(0, 256, size=(480, 640, 3), dtype=np.uint8)
+failures = 0
+
+for kwargs in ({}, {"firstCell": 2000, "lastCell": 4000}, {"format": "rgb"}):
+    result = lpximage.scanImage(frame, 300.0, 200.0, opponent=True, **kwargs)
+    planes = result.getOpponentCells()
+    if planes.dtype != np.int16 or planes.shape != (3, result.getMaxCells()):
+        print(f"❌ Opponent planes have type {planes.dtype} and shape {planes.shape}")
+        failures += 1
+    elif not np.array_equal(planes, expected_planes(result)):
+        print(f"❌ Opponent planes with {kwargs} differ from the packed cells")
+        failures += 1
+
+# Other scan paths fill the planes of an image that asks for them
+delta = lpximage.LPXDeltaScanner()
+shared = lpximage.LPXImage(delta.getScanTables(), 640, 480)
+shared.setOpponentOutput(True)
+for name, scan in [("scanInto", lambda: lpximage.scanInto(shared, frame, 100.0, 100.0)),
+                   ("delta", lambda: delta.scanInto(shared, frame, 120.0, 80.0))]:
+    scan()
+    if not np.array_equal(shared.getOpponentCells(), expected_planes(shared)):
+        print(f"❌ {name} did not fill the opponent planes")
+        failures += 1
+
+# LPXVision gives the same cells from the planes as from the packed cells
+with_planes = lpximage.scanImage(frame, 320.0, 240.0, opponent=True)
+without = lpximage.scanImage(frame, 320.0, 240.0)
+if list(lpximage.LPXVision(with_planes).retinaCells) != list(lpximage.LPXVision(without).retinaCells):
+    print("❌ LPXVision cells differ when read from the opponent planes")
+    failures += 1
+
+# Without opponent output nothing is kept
+if without.hasOpponentOutput() or without.getOpponentCells().size != 0:
+    print("❌ Opponent planes were kept without being requested")
+    failures += 1
+
+if failures:
+    print(f"❌ {failures} opponent cell checks failed")
+    exit(1)
+print("✓ Opponent planes match the packed cells")
@@ -0,0 +1,76 @@
+#!/usr/bin/env python3
+"""
+Test scanning RGB, BGRA and YUV frames without converting them first
+"""
+
+import numpy as np
+import lpximage
+
+if not lpximage.initLPX("../ScanTables63", 640, 480):
+    print("❌ Failed to initialize LPX system")
+    exit(1)
+
+HEIGHT, WIDTH = 480, 640
+rng = np.random.default_rng(7)
+failures = 0
+
+def scan_cells(image, fmt, cx=320.0, cy=240.0):
+    lpx_image = lpximage.scanImage(image, cx, cy, fmt)
+    return [lpx_image.getCellValue(i) for i in range(lpx_image.getLength())]
+
+def check(name, ok):
+    global failures
+    if ok:
+        print(f"✓ {name}")
+    else:
+        print(f"❌ {name}")
+        failures += 1
+
+# Packed colour layouts give exactly the BGR result
+bgr = rng.integers(0, 256, size=(HEIGHT, WIDTH, 3), dtype=np.uint8)
+expected = scan_cells(bgr, "bgr")
+check("RGB matches BGR", scan_cells(np.ascontiguousarray(bgr[:, :, ::-1]), "rgb") == expected)
+
+bgra = np.concatenate([bgr, rng.integers(0, 256, size=(HEIGHT, WIDTH, 1), dtype=np.uint8)], axis=2)
+check("BGRA matches BGR (alpha ignored)", scan_cells(bgra, "bgra") == expected)
+check("4-channel auto is BGRA", scan_cells(bgra, "auto") == expected)
+
+# The same YUV 4:2:0 content in every YUV layout gives the same cells
+y_plane = rng.integers(40, 200, size=(HEIGHT, WIDTH), dtype=np.uint8)
+u_plane = rng.integers(100, 156, size=(HEIGHT // 2, WIDTH // 2), dtype=np.uint8)
+v_plane = rng.integers(100, 156, size=(HEIGHT // 2, WIDTH // 2), dtype=np.uint8)
+
+uv = np.stack([u_plane, v_plane], axis=2).reshape(HEIGHT // 2, WIDTH)
+nv12 = np.concatenate([y_plane, uv], axis=0)[:, :, None]
+i420 = np.concatenate([y_plane.ravel(), u_plane.ravel(), v_plane.ravel()]).reshape(HEIGHT * 3 // 2, WIDTH, 1)
+
+# YUYV is 4:2:2, so repeat each chroma row for both luma rows it covers
+yuyv = np.empty((HEIGHT, WIDTH, 2), dtype=np.uint8)
+yuyv[:, :, 0] = y_plane
+yuyv[:, 0::2, 1] = np.repeat(u_plane, 2, axis=0)
+yuyv[:, 1::2, 1] = np.repeat(v_plane, 2, axis=0)
+
+nv12_cells = scan_cells(nv12, "nv12")
+check("I420 matches NV12", scan_cells(i420, "i420") == nv12_cells)
+check("YUYV matches NV12", scan_cells(yuyv, "yuyv") == nv12_cells)
+
+lpx_image = lpximage.scanImage(nv12, 320.0, 240.0, "nv12")
+check("NV12 frame size excludes the chroma rows",
+      lpx_image.getWidth() == WIDTH and lpx_image.getHeight() == HEIGHT)
+
+# A flat mid-grey YUV frame converts to mid-grey BGR in every cell
+flat = np.full((HEIGHT * 3 // 2, WIDTH, 1), 128, dtype=np.uint8)
+flat[:HEIGHT] = 126
+grey = scan_cells(flat, "nv12")
+check("Flat YUV frame converts to grey", all(c == 0x808080 for c in grey[:3000]))
+
+try:
+    lpximage.scanImage(bgr, 320.0, 240.0, "nv12")
+    check("Mismatched shape is rejected", False)
+except RuntimeError:
+    check("Mismatched shape is rejected", True)
+
+if failures:
+    print(f"❌ {failures} pixel format checks failed")
+    exit(1)
+print("✓ All pixel format checks passed")
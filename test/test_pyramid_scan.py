@@ -0,0 +1,59 @@
+#!/usr/bin/env python3
+"""
+Test pyramid scans against the exact scan
+"""
+
+import numpy as np
+import lpximage
+
+if not lpximage.initLPX("../ScanTables63", 1920, 1080):
+    print("❌ Failed to initialize LPX system")
+    exit(1)
+
+def cells(lpx_image):
+    return np.array([lpx_image.getCellValue(i) for i in range(lpx_image.getLength())], dtype=np.int64)
+
+def channels(values):
+    return np.stack([(values >> shift) & 0xFF for shift in (0, 8, 16)], axis=1)
+
+failures = 0
+
+# A flat frame averages to the same colour at every level
+flat = np.full((1080, 1920, 3), (40, 120, 200), dtype=np.uint8)
+if not np.array_equal(cells(lpximage.scanImage(flat, 960.0, 540.0, pyramidLevels=4)),
+                      cells(lpximage.scanImage(flat, 960.0, 540.0))):
+    print("❌ Pyramid scan of a flat frame differs from the exact scan")
+    failures += 1
+else:
+    print("✓ Flat frame: pyramid scan matches the exact scan")
+
+# On a smooth frame the outer cells only move by rounding
+y, x = np.mgrid[0:1080, 0:1920]
+smooth = np.dstack([x * 255 // 1919, y * 255 // 1079, (x + y) * 255 // 2998]).astype(np.uint8)
+for cx, cy in [(960.0, 540.0), (300.5, 200.25), (1900.0, 1000.0)]:
+    exact = channels(cells(lpximage.scanImage(smooth, cx, cy)))
+    pyramid = channels(cells(lpximage.scanImage(smooth, cx, cy, pyramidLevels=4)))
+    error = np.abs(exact - pyramid)
+    # Cells near the frame edge are sampled less densely, so allow a few levels there
+    if error.mean() > 0.5 or error.max() > 8:
+        print(f"❌ ({cx}, {cy}): mean error {error.mean():.3f}, max {error.max()}")
+        failures += 1
+    else:
+        print(f"✓ ({cx}, {cy}): mean error {error.mean():.3f}, max {error.max()}")
+
+    # No cell the exact scan fills may be left empty
+    if np.any((exact.sum(axis=1) > 0) & (pyramid.sum(axis=1) == 0)):
+        print(f"❌ ({cx}, {cy}): pyramid scan left cells empty")
+        failures += 1
+
+try:
+    lpximage.scanImage(np.zeros((1620, 1920, 1), dtype=np.uint8), 960.0, 540.0, format="nv12", pyramidLevels=2)
+    print("❌ YUV pyramid scans should be rejected")
+    failures += 1
+except RuntimeError:
+    print("✓ YUV pyramid scans are rejected")
+
+if failures:
+    print(f"❌ {failures} pyramid scan checks failed")
+    exit(1)
+print("✓ Pyramid scans match the exact scan within rounding")
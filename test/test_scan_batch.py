@@ -0,0 +1,52 @@
+#!/usr/bin/env python3
+"""
+Test that batch scans match frame-by-frame scans and keep the input order
+"""
+
+import numpy as np
+import lpximage
+
+if not lpximage.initLPX("../ScanTables63", 640, 480):
+    print("❌ Failed to initialize LPX system")
+    exit(1)
+
+def cell_values(lpx_image):
+    return [lpx_image.getCellValue(i) for i in range(lpx_image.getLength())]
+
+rng = np.random.default_rng(23)
+# Mixed sizes, so out-of-order results would not line up
+frames = [rng.integers(0, 256, size=(240 + 16 * i, 320 + 32 * i, 3), dtype=np.uint8) for i in range(10)]
+centers = [(frame.shape[1] * 0.1 * i, frame.shape[0] / 2.0 + i) for i, frame in enumerate(frames)]
+
+failures = 0
+
+for threads in (1, 3):
+    lpximage.configureScanThreads(threads)
+    results = lpximage.scanBatch(frames, centers)
+    if len(results) != len(frames):
+        print(f"❌ {threads} threads: {len(results)} results for {len(frames)} frames")
+        failures += 1
+        continue
+    for i, (frame, (cx, cy), result) in enumerate(zip(frames, centers, results)):
+        if result.getWidth() != frame.shape[1] or cell_values(result) != cell_values(lpximage.scanImage(frame, cx, cy)):
+            print(f"❌ {threads} threads: frame {i} differs from scanImage")
+            failures += 1
+lpximage.configureScanThreads(0)
+
+# A single center applies to every frame
+results = lpximage.scanBatch(frames[:3], [(100.0, 100.0)])
+if [cell_values(r) for r in results] != [cell_values(lpximage.scanImage(f, 100.0, 100.0)) for f in frames[:3]]:
+    print("❌ Single-center batch differs from scanImage")
+    failures += 1
+
+# A frame that does not match the format comes back as None without failing the rest
+mixed = [frames[0], np.zeros((10, 10, 2), dtype=np.uint8), frames[1]]
+results = lpximage.scanBatch(mixed, [(50.0, 50.0)], "bgr")
+if results[1] is not None or results[0] is None or results[2] is None:
+    print("❌ Mismatched frame was not reported as None")
+    failures += 1
+
+if failures:
+    print(f"❌ {failures} batch scan checks failed")
+    exit(1)
+print("✓ Batch scans match frame-by-frame scans")
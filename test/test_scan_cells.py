@@ -0,0 +1,67 @@
+#!/usr/bin/env python3
+"""
+Test scanning a list of cells against full scans
+"""
+
+import numpy as np
+import lpximage
+
+if not lpximage.initLPX("../ScanTables63", 640, 480):
+    print("❌ Failed to initialize LPX system")
+    exit(1)
+
+def cell_values(lpx_image):
+    return np.array([lpx_image.getCellValue(i) for i in range(lpx_image.getLength())], dtype=np.uint32)
+
+rng = np.random.default_rng(20)
+failures = 0
+
+frames = [
+    ("bgr", rng.integers(0, 256, size=(480, 640, 3), dtype=np.uint8), "auto"),
+    ("gray", rng.integers(0, 256, size=(480, 640, 1), dtype=np.uint8), "auto"),
+    ("nv12", rng.integers(0, 256, size=(720, 640, 1), dtype=np.uint8), "nv12"),
+    ("uint16", rng.integers(0, 65536, size=(480, 640, 3), dtype=np.uint16), "auto"),
+]
+full = lpximage.scanImage(frames[0][1], 0.0, 0.0)
+n_cells = full.getMaxCells()
+probes = [
+    rng.integers(0, n_cells, size=300),        # Mostly outer cells
+    np.arange(0, 2000, 7),                     # Fovea and inner rings
+    np.array([0, n_cells - 1, 5, 5, 5]),       # Ends of the range, repeated cell
+    np.array([], dtype=np.int64),
+]
+
+# Listed cells match the full scan, the rest are zero
+for name, frame, fmt in frames:
+    for cx, cy in [(0.0, 0.0), (250.5, -120.25), (400.0, 300.0)]:
+        expected = cell_values(lpximage.scanImage(frame, cx, cy, format=fmt))
+        for cells in probes:
+            result = lpximage.scanCells(frame, cx, cy, cells.tolist(), format=fmt)
+            listed = np.zeros(n_cells, dtype=bool)
+            listed[cells] = True
+            values = cell_values(result)
+            if np.any(values[listed] != expected[listed]) or np.any(values[~listed] != 0):
+                print(f"❌ {name} at ({cx}, {cy}): {len(cells)} listed cells differ from a full scan")
+                failures += 1
+
+# The engine gives the same cells
+engine = lpximage.LPXScanEngine("../ScanTables63")
+frame = frames[0][1]
+if np.any(cell_values(engine.scanCells(frame, 10.0, 20.0, probes[0].tolist())) !=
+          cell_values(lpximage.scanCells(frame, 10.0, 20.0, probes[0].tolist()))):
+    print("❌ Engine scanCells differs from the module-level scanCells")
+    failures += 1
+
+# Cells outside the image's range are rejected
+for bad in ([-1], [n_cells]):
+    try:
+        lpximage.scanCells(frame, 0.0, 0.0, bad)
+        print(f"❌ Cell list {bad} was accepted")
+        failures += 1
+    except ValueError:
+        pass
+
+if failures:
+    print(f"❌ {failures} cell scan checks failed")
+    exit(1)
+print("✓ Cell scans match the full scan for the listed cells")
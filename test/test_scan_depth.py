@@ -0,0 +1,78 @@
+#!/usr/bin/env python3
+"""
+Test that 16-bit and float frames scan like the 8-bit frame they were made
+from, without converting them to 8 bits first
+"""
+
+import numpy as np
+import lpximage
+
+if not lpximage.initLPX("../ScanTables63", 640, 480):
+    print("❌ Failed to initialize LPX system")
+    exit(1)
+
+def cell_values(lpx_image):
+    return [lpx_image.getCellValue(i) for i in range(lpx_image.getLength())]
+
+def packed_from_precise(precise, rounded):
+    # Cell values pack 8-bit B, G, R into the low three bytes; 8-bit scans
+    # truncate the mean and deeper scans round it
+    offset = 0.5 if rounded else 1e-4
+    channels = np.floor(np.clip(precise, 0.0, 255.0) + offset).astype(np.int64)
+    return list(channels[:, 0] | (channels[:, 1] << 8) | (channels[:, 2] << 16))
+
+rng = np.random.default_rng(29)
+noise = rng.integers(0, 256, size=(480, 640, 3), dtype=np.uint8)
+deep_frames = {
+    "uint16": (noise.astype(np.uint16) * 257, 257.0),
+    "float32": (noise.astype(np.float32) / 255.0, 1.0 / 255.0),
+}
+
+failures = 0
+
+for cx, cy in [(0.0, 0.0), (150.5, -60.25), (-320.0, 240.0)]:
+    reference = lpximage.scanImage(noise, cx, cy, precise=True)
+    expected = reference.getPreciseCellValues().astype(np.float64)
+    if expected.shape != (reference.getLength(), 3):
+        print(f"❌ Precise values have shape {expected.shape}")
+        failures += 1
+        continue
+    if packed_from_precise(expected, False) != cell_values(reference):
+        print(f"❌ 8-bit cells at ({cx}, {cy}) are not the truncated precise means")
+        failures += 1
+
+    for name, (frame, unit) in deep_frames.items():
+        result = lpximage.scanImage(frame, cx, cy, precise=True)
+        precise = result.getPreciseCellValues().astype(np.float64)
+        if not np.allclose(precise, expected * unit, rtol=1e-5, atol=1e-6 * unit):
+            print(f"❌ {name} precise values at ({cx}, {cy}) differ from the 8-bit scan")
+            failures += 1
+        if packed_from_precise(precise / unit, True) != cell_values(result):
+            print(f"❌ {name} cells at ({cx}, {cy}) are not the rounded precise means")
+            failures += 1
+
+# Without precise output the accessor is empty and cells are unchanged
+plain = lpximage.scanImage(noise, 10.0, 20.0)
+if plain.hasPreciseOutput() or plain.getPreciseCellValues().size != 0:
+    print("❌ Precise values were kept without being requested")
+    failures += 1
+
+# Batch scans read deep frames too
+frames = [frame for frame, _ in deep_frames.values()]
+batch = lpximage.scanBatch(frames, [(10.0, 20.0)])
+if any(r is None or cell_values(r) != cell_values(lpximage.scanImage(f, 10.0, 20.0)) for f, r in zip(frames, batch)):
+    print("❌ Batch scans of deep frames differ from scanImage")
+    failures += 1
+
+# Pyramid scans only read 8-bit frames
+try:
+    lpximage.scanImage(deep_frames["float32"][0], 0.0, 0.0, pyramidLevels=2)
+    print("❌ A pyramid scan accepted a float frame")
+    failures += 1
+except Exception:
+    pass
+
+if failures:
+    print(f"❌ {failures} scan depth checks failed")
+    exit(1)
+print("✓ 16-bit and float scans match 8-bit scans")
@@ -0,0 +1,66 @@
+#!/usr/bin/env python3
+"""
+Test that independent scan engines running in parallel threads give the same
+results as the global scan functions
+"""
+
+import threading
+import numpy as np
+import lpximage
+
+if not lpximage.initLPX("../ScanTables63", 640, 480):
+    print("❌ Failed to initialize LPX system")
+    exit(1)
+
+def cell_values(lpx_image):
+    return [lpx_image.getCellValue(i) for i in range(lpx_image.getLength())]
+
+# Two streams with their own frames and fixations
+rng = np.random.default_rng(11)
+streams = []
+for cx, cy in [(320.0, 240.0), (200.5, 300.25)]:
+    frames = [rng.integers(0, 256, size=(480, 640, 3), dtype=np.uint8) for _ in range(3)]
+    expected = [cell_values(lpximage.scanImage(f, cx, cy)) for f in frames]
+    streams.append((frames, cx, cy, expected))
+
+failures = []
+
+def run_stream(engine, frames, cx, cy, expected, name):
+    for repeat in range(4):
+        for frame, cells in zip(frames, expected):
+            lpx_image = engine.scanImage(frame, cx, cy)
+            if cell_values(lpx_image) != cells:
+                failures.append(f"{name}: pass {repeat} differs from scanImage")
+                return
+
+# Each engine loads its own tables, so nothing is shared between the streams
+engines = [lpximage.LPXScanEngine("../ScanTables63", numThreads=2) for _ in streams]
+threads = [threading.Thread(target=run_stream, args=(engine, *stream, f"stream {n}"))
+           for n, (engine, stream) in enumerate(zip(engines, streams))]
+for t in threads:
+    t.start()
+for t in threads:
+    t.join()
+
+# Both streams through one engine take turns on its pool
+shared = lpximage.LPXScanEngine(lpximage.LPXTables("../ScanTables63"), numThreads=2)
+threads = [threading.Thread(target=run_stream, args=(shared, *stream, f"shared engine, stream {n}"))
+           for n, stream in enumerate(streams)]
+for t in threads:
+    t.start()
+for t in threads:
+    t.join()
+
+# Multi-fixation scans match the global function
+frame = streams[0][0][0]
+centers = [(320.0, 240.0), (100.0, 100.0), (600.5, 400.5)]
+for n, (a, b) in enumerate(zip(engines[0].scanMultiple(frame, centers), lpximage.scanMultiple(frame, centers))):
+    if cell_values(a) != cell_values(b):
+        failures.append(f"scanMultiple center {n} differs from the global function")
+
+for failure in failures:
+    print(f"❌ {failure}")
+if failures:
+    print(f"❌ {len(failures)} scan engine checks failed")
+    exit(1)
+print("✓ Concurrent scan engines match the global scan functions")
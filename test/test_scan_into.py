@@ -0,0 +1,65 @@
+#!/usr/bin/env python3
+"""
+Test that scanning into a reused LPXImage matches a fresh scan, and that
+steady-state scans do not allocate
+"""
+
+import os
+import subprocess
+import numpy as np
+import lpximage
+
+if not lpximage.initLPX("../ScanTables63", 640, 480):
+    print("❌ Failed to initialize LPX system")
+    exit(1)
+
+def cell_values(lpx_image):
+    return [lpx_image.getCellValue(i) for i in range(lpx_image.getLength())]
+
+rng = np.random.default_rng(17)
+noise = rng.integers(0, 256, size=(480, 640, 3), dtype=np.uint8)
+white = np.full((480, 640, 3), 255, dtype=np.uint8)
+
+failures = 0
+
+# One image reused across fixations; the corner fixations leave fovea cells
+# off the image, which must not keep the previous scan's values
+reused = lpximage.LPXImage(lpximage.LPXTables("../ScanTables63"), 1, 1)
+for cx, cy in [(320.0, 240.0), (0.0, 0.0), (639.5, 479.5), (100.25, 400.75), (0.0, 0.0)]:
+    for image in (white, noise):
+        if not lpximage.scanInto(reused, image, cx, cy):
+            print(f"❌ scanInto failed at ({cx}, {cy})")
+            failures += 1
+            continue
+        if cell_values(reused) != cell_values(lpximage.scanImage(image, cx, cy)):
+            print(f"❌ Reused image at ({cx}, {cy}) differs from a fresh scan")
+            failures += 1
+        if reused.getWidth() != 640 or reused.getHeight() != 480:
+            print("❌ scanInto did not set the image size")
+            failures += 1
+
+# Pooled results stay valid while held, even as later scans recycle others
+held = [lpximage.scanImage(noise, 320.0, 240.0) for _ in range(12)]
+expected = cell_values(held[0])
+for _ in range(3):
+    lpximage.scanImage(white, 320.0, 240.0)
+if any(cell_values(lpx_image) != expected for lpx_image in held):
+    print("❌ A held image was overwritten by a later scan")
+    failures += 1
+
+# Allocation counts come from the benchmark, which replaces operator new
+benchmark = os.environ.get("LPX_SCAN_BENCHMARK", "../build/main_scan_benchmark")
+if os.path.exists(benchmark):
+    result = subprocess.run([benchmark, "../ScanTables63", "alloc", "640", "480", "20"],
+                            stdout=subprocess.PIPE, stderr=subprocess.STDOUT, universal_newlines=True)
+    print(result.stdout)
+    if result.returncode != 0:
+        print("❌ Steady-state scans allocated")
+        failures += 1
+else:
+    print(f"⚠️  {benchmark} not found, skipping the allocation count")
+
+if failures:
+    print(f"❌ {failures} scan-into checks failed")
+    exit(1)
+print("✓ Reused and pooled images match fresh scans")
@@ -0,0 +1,69 @@
+#!/usr/bin/env python3
+"""
+Test that every SIMD span kernel produces the same LPXImage as the scalar kernel
+"""
+
+import numpy as np
+import lpximage
+
+if not lpximage.initLPX("../ScanTables63", 640, 480):
+    print("❌ Failed to initialize LPX system")
+    exit(1)
+
+kernels = lpximage.getAvailableScanKernels()
+print(f"Available kernels: {kernels}")
+print(f"Selected kernel: {lpximage.getScanKernel()}")
+
+if "scalar" not in kernels:
+    print("❌ Scalar kernel must always be available")
+    exit(1)
+
+rng = np.random.default_rng(63)
+
+# Odd sizes and fractional centers exercise the span tails and image edges
+cases = [
+    (480, 640, 3, 320.0, 240.0),
+    (1080, 1920, 3, 1000.7, 500.3),
+    (333, 517, 3, 40.5, 300.2),
+    (101, 77, 3, 38.0, 50.0),
+    (479, 641, 1, 320.5, 239.5),
+]
+
+def scan_cells(image, cx, cy):
+    lpx_image = lpximage.scanImage(image, cx, cy)
+    return [lpx_image.getCellValue(i) for i in range(lpx_image.getLength())]
+
+failures = 0
+for height, width, channels, cx, cy in cases:
+    image = rng.integers(0, 256, size=(height, width, channels), dtype=np.uint8)
+
+    lpximage.setScanKernel("scalar")
+    expected = scan_cells(image, cx, cy)
+
+    for kernel in kernels:
+        if not lpximage.setScanKernel(kernel):
+            print(f"❌ Could not select kernel {kernel}")
+            failures += 1
+            continue
+        cells = scan_cells(image, cx, cy)
+        if cells != expected:
+            mismatches = sum(1 for a, b in zip(cells, expected) if a != b)
+            print(f"❌ {kernel}: {mismatches} cells differ for {width}x{height}x{channels} at ({cx}, {cy})")
+            failures += 1
+        else:
+            print(f"✓ {kernel}: identical for {width}x{height}x{channels} at ({cx}, {cy})")
+
+lpximage.setScanKernel("auto")
+
+if lpximage.setScanKernel("neon") == ("neon" in kernels) and \
+   lpximage.setScanKernel("avx2") == ("avx2" in kernels):
+    print("✓ Unsupported kernels are rejected")
+else:
+    print("❌ setScanKernel result does not match getAvailableScanKernels")
+    failures += 1
+lpximage.setScanKernel("auto")
+
+if failures:
+    print(f"❌ {failures} kernel checks failed")
+    exit(1)
+print("✓ All kernels match the scalar kernel")
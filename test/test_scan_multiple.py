@@ -0,0 +1,46 @@
+#!/usr/bin/env python3
+"""
+Test that a multi-fixation scan matches scanning each center on its own
+"""
+
+import numpy as np
+import lpximage
+
+if not lpximage.initLPX("../ScanTables63", 640, 480):
+    print("❌ Failed to initialize LPX system")
+    exit(1)
+
+rng = np.random.default_rng(9)
+
+# Candidate centers inside, on the edge of and outside the frame, with a repeat
+centers = [(320.0, 240.0), (100.5, 80.25), (600.0, 450.0), (0.0, 0.0),
+           (-50.0, 240.0), (320.7, 700.0), (320.0, 240.0)]
+
+def cells(lpx_image):
+    return [lpx_image.getCellValue(i) for i in range(lpx_image.getLength())]
+
+failures = 0
+for fmt, shape in [("bgr", (480, 640, 3)), ("rgb", (480, 640, 3)), ("bgra", (480, 640, 4)),
+                   ("gray", (480, 640, 1)), ("nv12", (720, 640, 1)), ("yuyv", (480, 640, 2))]:
+    image = rng.integers(0, 256, size=shape, dtype=np.uint8)
+    results = lpximage.scanMultiple(image, centers, format=fmt)
+    if len(results) != len(centers):
+        print(f"❌ {fmt}: expected {len(centers)} results, got {len(results)}")
+        failures += 1
+        continue
+
+    for (cx, cy), result in zip(centers, results):
+        expected = lpximage.scanImage(image, cx, cy, format=fmt)
+        if cells(result) != cells(expected):
+            print(f"❌ {fmt}: scan at ({cx}, {cy}) differs from a single scan")
+            failures += 1
+    print(f"✓ {fmt}: {len(centers)} fixations checked")
+
+if lpximage.scanMultiple(np.zeros((480, 640, 3), dtype=np.uint8), []) != []:
+    print("❌ No centers should give no results")
+    failures += 1
+
+if failures:
+    print(f"❌ {failures} multi-fixation checks failed")
+    exit(1)
+print("✓ Multi-fixation scans match single scans")
@@ -0,0 +1,79 @@
+#!/usr/bin/env python3
+"""
+Test that cached scan plans give the same result as freshly built ones
+"""
+
+import os
+import subprocess
+import sys
+import tempfile
+import numpy as np
+import lpximage
+
+# Set in the reference run, which rebuilds the plan for every scan
+reference_path = os.environ.get("LPX_SCAN_PLAN_REFERENCE")
+
+if not lpximage.initLPX("../ScanTables63", 640, 480):
+    print("❌ Failed to initialize LPX system")
+    exit(1)
+
+rng = np.random.default_rng(5)
+image = rng.integers(0, 256, size=(480, 640, 3), dtype=np.uint8)
+
+# More fixations than the plan cache holds, so plans are evicted and rebuilt.
+# Fractional centers near the image edge share an integer center with their
+# neighbours but not necessarily the same fovea pixels.
+centers = [(320.0, 240.0), (320.5, 240.5), (321.0, 240.0), (0.5, 0.5), (0.0, 0.0),
+           (-0.5, -0.5), (639.5, 479.5), (100.25, 400.75), (500.0, 50.0),
+           (10.0, 470.0), (320.0, 241.0), (200.7, 200.3)]
+
+# Each new center is followed by revisits of recent ones, which the 8-plan
+# cache still holds, then a last sweep hits evicted and cached plans alike
+sequence = []
+for i in range(len(centers)):
+    sequence += [i] + [j for j in (i - 1, i - 3, i - 6) if j >= 0]
+sequence += list(range(len(centers)))
+
+def scan_cells(cx, cy):
+    lpx_image = lpximage.scanImage(image, cx, cy)
+    return [lpx_image.getCellValue(i) for i in range(lpx_image.getLength())]
+
+scans = np.array([scan_cells(*centers[i]) for i in sequence], dtype=np.uint32)
+if reference_path:
+    np.save(reference_path, scans)
+    exit(0)
+
+# Cache hits the sequence should give (LRU of 8 plans)
+cached, hits = [], 0
+for i in sequence:
+    if i in cached:
+        hits += 1
+        cached.remove(i)
+    cached = ([i] + cached)[:8]
+
+failures = 0
+with tempfile.TemporaryDirectory() as directory:
+    path = os.path.join(directory, "reference.npy")
+    env = dict(os.environ, LPX_SCAN_PLAN_CACHE="0", LPX_SCAN_PLAN_REFERENCE=path)
+    if subprocess.run([sys.executable, os.path.abspath(__file__)], env=env).returncode != 0:
+        print("❌ Reference run with LPX_SCAN_PLAN_CACHE=0 failed")
+        exit(1)
+    reference = np.load(path)
+
+for n, i in enumerate(sequence):
+    if not np.array_equal(scans[n], reference[n]):
+        cx, cy = centers[i]
+        print(f"❌ Scan {n} at ({cx}, {cy}) differs from the uncached reference")
+        failures += 1
+print(f"Compared {len(sequence)} scans ({hits} from cached plans) with plans rebuilt for every scan")
+
+# Scanning the same center back to back reuses one plan
+steady = [scan_cells(320.0, 240.0) for _ in range(5)]
+if any(not np.array_equal(cells, reference[0]) for cells in steady):
+    print("❌ Repeated scans at a fixed center differ")
+    failures += 1
+
+if failures:
+    print(f"❌ {failures} scan plan checks failed")
+    exit(1)
+print("✓ Cached scan plans match freshly built ones")
@@ -0,0 +1,92 @@
+#!/usr/bin/env python3
+"""
+Test that a frame streamed a band of rows at a time scans like the whole frame
+"""
+
+import numpy as np
+import lpximage
+
+if not lpximage.initLPX("../ScanTables63", 640, 480):
+    print("❌ Failed to initialize LPX system")
+    exit(1)
+
+def cell_values(lpx_image):
+    return [lpx_image.getCellValue(i) for i in range(lpx_image.getLength())]
+
+tables = lpximage.LPXTables("../ScanTables63")
+session = lpximage.LPXScanSession(tables)
+rng = np.random.default_rng(37)
+failures = 0
+
+def stream(frame, cx, cy, bands, dtype="uint8", firstCell=0, lastCell=-1):
+    image = lpximage.LPXImage(tables, frame.shape[1], frame.shape[0])
+    if not session.begin(image, frame.shape[1], frame.shape[0], frame.shape[2], cx, cy,
+                         dtype=dtype, firstCell=firstCell, lastCell=lastCell):
+        return None
+    for first, last in bands:
+        session.pushRows(frame[first:last], first)
+    return image if session.isComplete() else None
+
+in_order = [(r, r + 16) for r in range(0, 480, 16)]
+shuffled = [in_order[i] for i in rng.permutation(len(in_order))]
+overlapping = [(r, min(r + 40, 480)) for r in range(0, 480, 24)][::-1]
+
+noise = rng.integers(0, 256, size=(480, 640, 3), dtype=np.uint8)
+frames = {
+    "uint8": noise,
+    "uint16": noise.astype(np.uint16) * 257,
+    "float32": noise.astype(np.float32) / 255.0,
+}
+for dtype, frame in frames.items():
+    for cx, cy in [(0.0, 0.0), (150.5, -60.25)]:
+        expected = cell_values(lpximage.scanImage(frame, cx, cy))
+        for name, bands in [("in order", in_order), ("shuffled", shuffled), ("overlapping", overlapping)]:
+            result = stream(frame, cx, cy, bands, dtype=dtype)
+            if result is None or cell_values(result) != expected:
+                print(f"❌ {dtype} frame streamed {name} at ({cx}, {cy}) differs from scanImage")
+                failures += 1
+
+# A range of cells near the top of the frame is done before the last rows arrive
+image = lpximage.LPXImage(tables, 640, 480)
+session.begin(image, 640, 480, 3, 320.0, 60.0, lastCell=tables.lastFoveaIndex + 1)
+if session.getEndRow() >= 480:
+    print("❌ A fovea scan near the top reads the whole frame")
+    failures += 1
+for first, last in in_order:
+    session.pushRows(noise[first:last], first)
+    if session.isComplete():
+        break
+if not session.isComplete() or last >= 480:
+    print("❌ A fovea scan near the top waited for the whole frame")
+    failures += 1
+elif cell_values(image) != cell_values(lpximage.scanImage(noise, 320.0, 60.0, lastCell=tables.lastFoveaIndex + 1)):
+    print("❌ An early fovea scan differs from scanImage")
+    failures += 1
+
+# finish() completes a scan from the rows it has
+image = lpximage.LPXImage(tables, 640, 480)
+session.begin(image, 640, 480, 3, 0.0, 0.0)
+session.pushRows(noise[:240], 0)
+if session.isComplete() or session.getRowsPending() == 0 or not session.finish() or not session.isComplete():
+    print("❌ finish() did not complete a partial scan")
+    failures += 1
+
+# Bands outside the frame, bands of the wrong width and YUV frames are rejected
+session.begin(lpximage.LPXImage(tables, 640, 480), 640, 480, 3, 0.0, 0.0)
+if session.pushRows(noise[:16], 470):
+    print("❌ A band past the last row was accepted")
+    failures += 1
+try:
+    session.pushRows(noise[:16, :320], 0)
+    print("❌ A band of the wrong width was accepted")
+    failures += 1
+except Exception:
+    pass
+if session.begin(lpximage.LPXImage(tables, 640, 480), 640, 480, 1, 0.0, 0.0, format="nv12"):
+    print("❌ A YUV frame was accepted")
+    failures += 1
+
+if failures:
+    print(f"❌ {failures} scan session checks failed")
+    exit(1)
+print("✓ Streamed frames scan like whole frames")
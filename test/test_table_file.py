@@ -0,0 +1,66 @@
+#!/usr/bin/env python3
+"""
+Test writing scan tables as a mapped table file and scanning with it
+"""
+
+import os
+import tempfile
+import numpy as np
+import lpximage
+
+tables = lpximage.LPXTables("../ScanTables63")
+if not tables.isInitialized():
+    print("❌ Failed to load scan tables")
+    exit(1)
+
+failures = 0
+directory = tempfile.mkdtemp()
+path = os.path.join(directory, "ScanTables63.lpxt")
+
+if not lpximage.writeTableFile(tables, path) or not lpximage.isTableFile(path):
+    print("❌ Table file was not written")
+    exit(1)
+if lpximage.isTableFile("../ScanTables63"):
+    print("❌ The original tables were taken for a table file")
+    failures += 1
+
+mapped = lpximage.LPXTables(path)
+if not mapped.isInitialized() or not mapped.isMapped() or tables.isMapped():
+    print("❌ Table file was not mapped")
+    failures += 1
+if (mapped.spiralPer, mapped.length, mapped.lastFoveaIndex) != (tables.spiralPer, tables.length, tables.lastFoveaIndex):
+    print("❌ Mapped tables differ from the original")
+    failures += 1
+
+def cell_values(lpx_image):
+    return [lpx_image.getCellValue(i) for i in range(lpx_image.getLength())]
+
+# Scans with mapped tables, which also use the prebuilt indexes, are identical
+rng = np.random.default_rng(21)
+frame = rng.integers(0, 256, size=(480, 640, 3), dtype=np.uint8)
+original = lpximage.LPXScanEngine(tables)
+engine = lpximage.LPXScanEngine(mapped)
+cells = list(range(0, 7000, 11))
+for cx, cy in [(320.0, 240.0), (0.0, 0.0), (500.5, 80.25)]:
+    if cell_values(engine.scanImage(frame, cx, cy)) != cell_values(original.scanImage(frame, cx, cy)):
+        print(f"❌ Scan at ({cx}, {cy}) differs with mapped tables")
+        failures += 1
+    if cell_values(engine.scanCells(frame, cx, cy, cells)) != cell_values(original.scanCells(frame, cx, cy, cells)):
+        print(f"❌ Cell scan at ({cx}, {cy}) differs with mapped tables")
+        failures += 1
+
+# A damaged header is rejected
+with open(path, "rb") as f:
+    data = bytearray(f.read())
+data[40] ^= 1
+damaged = os.path.join(directory, "damaged.lpxt")
+with open(damaged, "wb") as f:
+    f.write(data)
+if lpximage.LPXTables(damaged).isInitialized():
+    print("❌ A table file with a damaged header was loaded")
+    failures += 1
+
+if failures:
+    print(f"❌ {failures} table file checks failed")
+    exit(1)
+print("✓ Mapped table files scan the same as the original tables")
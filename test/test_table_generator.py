@@ -0,0 +1,79 @@
+#!/usr/bin/env python3
+"""
+Test generating scan tables against the shipped ScanTables63
+"""
+
+import os
+import struct
+import tempfile
+import numpy as np
+import lpximage
+
+failures = 0
+directory = tempfile.mkdtemp()
+
+generated = lpximage.LPXTables("")
+if not generated.generate(63, 6000) or not generated.isInitialized():
+    print("❌ Failed to generate the tables of spiral period 63")
+    exit(1)
+path = os.path.join(directory, "ScanTables63")
+if not generated.save(path):
+    print("❌ Failed to save the generated tables")
+    exit(1)
+
+def read_tables(filename):
+    with open(filename, "rb") as f:
+        data = f.read()
+    header = struct.unpack_from("<7i", data, 0)
+    length, inner_length = header[3], header[4]
+    runs = data[28:28 + 8 * length]
+    inner = struct.unpack_from("<%di" % (2 * inner_length), data, 28 + 8 * length)
+    return header, runs, inner
+
+shipped_header, shipped_runs, shipped_inner = read_tables("../ScanTables63")
+header, runs, inner = read_tables(path)
+if header != shipped_header:
+    print(f"❌ Generated header {header} differs from {shipped_header}")
+    failures += 1
+if runs != shipped_runs:
+    print("❌ Generated pixel runs differ from ScanTables63")
+    failures += 1
+
+# Fovea cells sample the pixel under their centers. Centers on the ray at
+# angle zero lie within a rounding error of a row boundary, where the shipped
+# file may have rounded to the other row.
+for cell in range(len(inner) // 2):
+    x, y = inner[2 * cell], inner[2 * cell + 1]
+    sx, sy = shipped_inner[2 * cell], shipped_inner[2 * cell + 1]
+    if (x, y) != (sx, sy) and not (x == sx and x >= 3000 and {y, sy} == {2999, 3000}):
+        print(f"❌ Fovea cell {cell} at ({x}, {y}) rather than ({sx}, {sy})")
+        failures += 1
+
+# Tables of another period scan like loaded ones
+small = lpximage.LPXTables("")
+if not small.generate(31, 2000) or small.mapWidth != 2000 or small.spiralPer != 31.5:
+    print("❌ Failed to generate the tables of spiral period 31")
+    failures += 1
+else:
+    rng = np.random.default_rng(23)
+    frame = rng.integers(0, 256, size=(480, 640, 3), dtype=np.uint8)
+    scanned = lpximage.LPXScanEngine(small).scanImage(frame, 320.0, 240.0)
+    if scanned.getMaxCells() != small.lastCellIndex + 1 or scanned.getCellValue(small.lastFoveaIndex + 100) == 0:
+        print("❌ Generated tables of spiral period 31 did not scan")
+        failures += 1
+
+# With a cache directory, later generations map the cached table file
+os.environ["LPX_TABLE_CACHE"] = directory
+first = lpximage.LPXTables("")
+second = lpximage.LPXTables("")
+if not first.generate(31, 2000) or first.isMapped() or not second.generate(31, 2000) or not second.isMapped():
+    print("❌ Generated tables were not cached")
+    failures += 1
+if (second.length, second.lastFoveaIndex, second.lastCellIndex) != (small.length, small.lastFoveaIndex, small.lastCellIndex):
+    print("❌ Cached tables differ from the generated ones")
+    failures += 1
+
+if failures:
+    print(f"❌ {failures} table generator checks failed")
+    exit(1)
+print("✓ Generated scan tables match ScanTables63")
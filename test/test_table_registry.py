@@ -0,0 +1,69 @@
+#!/usr/bin/env python3
+"""
+Test sharing scan tables between processes through shared memory
+"""
+
+import os
+import subprocess
+import sys
+import numpy as np
+
+os.environ["LPX_SHARED_TABLES"] = "1"
+import lpximage
+
+segment = "/dev/shm/lpx-tables-6000-635"
+failures = 0
+
+# Releasing the last user removes the segment (run before this process
+# attaches it, since the scan indexes keep the tables of this process alive)
+child = subprocess.run([sys.executable, "-c",
+                        "import lpximage, os; t = lpximage.LPXTables('../ScanTables63'); "
+                        "ok = t.isShared() and os.path.exists('%s'); del t; "
+                        "exit(0 if ok and not os.path.exists('%s') else 1)" % (segment, segment)])
+if child.returncode != 0:
+    print("❌ The segment was not removed when its last user released it")
+    failures += 1
+
+shared = lpximage.LPXTables("../ScanTables63")
+if not shared.isInitialized() or not shared.isShared():
+    print("❌ Scan tables were not loaded into shared memory")
+    exit(1)
+if not os.path.exists(segment):
+    print(f"❌ {segment} was not published")
+    failures += 1
+
+# Another process attaches the published segment
+child = subprocess.run([sys.executable, "-c",
+                        "import lpximage; t = lpximage.LPXTables('../ScanTables63'); "
+                        "exit(0 if t.isShared() and t.length == %d else 1)" % shared.length])
+if child.returncode != 0:
+    print("❌ Another process did not attach the shared tables")
+    failures += 1
+if not os.path.exists(segment):
+    print("❌ The segment was removed while still in use")
+    failures += 1
+
+# Scans with the shared tables are identical to scans with a private copy
+def cell_values(lpx_image):
+    return [lpx_image.getCellValue(i) for i in range(lpx_image.getLength())]
+
+os.environ["LPX_SHARED_TABLES"] = "0"
+private = lpximage.LPXTables("../ScanTables63")
+if private.isShared():
+    print("❌ Tables were shared with LPX_SHARED_TABLES=0")
+    failures += 1
+
+rng = np.random.default_rng(22)
+frame = rng.integers(0, 256, size=(480, 640, 3), dtype=np.uint8)
+engine = lpximage.LPXScanEngine(shared)
+original = lpximage.LPXScanEngine(private)
+for cx, cy in [(320.0, 240.0), (0.0, 0.0), (500.5, 80.25)]:
+    if cell_values(engine.scanImage(frame, cx, cy)) != cell_values(original.scanImage(frame, cx, cy)):
+        print(f"❌ Scan at ({cx}, {cy}) differs with shared tables")
+        failures += 1
+del engine
+
+if failures:
+    print(f"❌ {failures} shared table checks failed")
+    exit(1)
+print("✓ Scan tables are shared between processes")